@@ -18,7 +18,7 @@ using namespace std;
 class BoardCell {
 	
     public:  
-		BoardCell() {} // default contstructor (do nothing)
+		BoardCell() : ticket(0), asleep(false) {} // default contstructor
         virtual ~BoardCell() {} // destructor (do nothing)
         
         virtual char display( ) = 0; // pure virtual function; this is an abstract base class
@@ -45,6 +45,10 @@ class BoardCell {
         
         void setMoved(bool m) {moved = m;}
         bool getMoved() {return moved;}
+        void setTicket(unsigned long t) {ticket = t;}
+        unsigned long getTicket() {return ticket;}
+        void setAsleep(bool a) {asleep = a;}
+        bool getAsleep() {return asleep;}
         void setRow(size_t r) {myRow = r;}
         size_t getRow() {return myRow;}
         void setCol(size_t c) {myCol = c;}
@@ -58,6 +62,8 @@ class BoardCell {
         size_t myRow; // current row for this board cell in a 2D grid
         size_t myCol; // current column for this board cell in a 2D grid
         bool moved;   // true = this board cell already moved in the current round
+        unsigned long ticket; // the board's schedule entries for this cell carry this; older ones are void
+        bool asleep;  // true = a scheduled board has this baddie sleeping until a hero comes near
 
 }; // BoardCell (abstract base class)
 
@@ -0,0 +1,287 @@
+/*-------------------------------------------------
+FILE: chunkedgrid.h
+
+AUTHOR: Viraj Saudagar
+
+DESCRIPTION:
+This class is a 2D grid for worlds that are mostly
+empty. The grid is cut into chunks of ChunkSide x
+ChunkSide elements kept in a hash table, and a chunk is
+only allocated once a value other than the fill value
+is stored in it. Everywhere else the grid reads as the
+fill value without taking any memory, and a chunk that
+goes back to holding only the fill value is recycled.
+Memory follows what is on the grid instead of its area:
+a 1,000,000 x 1,000,000 grid with a few thousand things
+on it fits in a few megabytes.
+
+Reads remember the chunk they found last, so reads near
+each other cost one compare more than a dense grid. A
+read that lands in another chunk searches the table,
+which is open addressed (keys and chunk pointers side by
+side in one array, probed linearly) so that usually
+costs one cache miss on top of the element's own. The
+remembered chunk makes even const reads unsafe to run on
+several threads at once.
+
+Unlike Grid, writes go through set() so the grid can
+tell when a chunk is needed and when it empties out.
+-------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+#include <exception>
+#include <stdexcept>
+
+using namespace std;
+
+template<typename T>
+class ChunkedGrid {
+public:
+  static const size_t ChunkBits = 4;
+  static const size_t ChunkSide = 1 << ChunkBits;  // 16 x 16 elements per chunk
+
+private:
+  struct Chunk {
+    T Cells[ChunkSide * ChunkSide];  // row after row
+    size_t Used;                     // elements that are not the fill value
+  };
+
+  // one entry of the hash table; Key is NoKey in an unused slot
+  struct Slot {
+    size_t Key;    // chunk row * ChunkCols + chunk column
+    Chunk* Data;
+  };
+  static const size_t NoKey = (size_t)-1;
+
+  size_t NumRows, NumCols;
+  size_t ChunkCols;                          // chunks across one row of chunks
+  T Fill;                                    // what every element without a chunk reads as
+  vector<Slot> Table;                        // allocated chunks; a power of two, at most half full
+  size_t NumChunks;                          // used slots in Table
+  vector<Chunk*> Spare;                      // emptied chunks, reused before allocating
+  mutable size_t LastKey;                    // key of LastChunk
+  mutable Chunk* LastChunk;                  // the chunk found last, NULL if none
+
+  size_t keyOf(size_t r, size_t c) const {
+    return (r >> ChunkBits) * ChunkCols + (c >> ChunkBits);
+  }
+
+  static size_t offsetOf(size_t r, size_t c) {
+    return ((r & (ChunkSide - 1)) << ChunkBits) | (c & (ChunkSide - 1));
+  }
+
+  // where in Table the search for key starts (Fibonacci hashing spreads neighbouring keys)
+  size_t homeOf(size_t key) const {
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 20) & (Table.size() - 1);
+  }
+
+  // the slot holding key, or the unused slot where it would go
+  size_t slotOf(size_t key) const {
+    size_t i = homeOf(key);
+    while (Table[i].Key != NoKey && Table[i].Key != key) {
+      i = (i + 1) & (Table.size() - 1);
+    }
+    return i;
+  }
+
+  // the chunk with this key, or NULL if it has not been allocated
+  Chunk* find(size_t key) const {
+    if (LastChunk != NULL && LastKey == key) {
+      return LastChunk;
+    }
+    const Slot& slot = Table[slotOf(key)];
+    if (slot.Key == NoKey) {
+      return NULL;
+    }
+    LastKey = key;
+    LastChunk = slot.Data;
+    return LastChunk;
+  }
+
+  // doubles the table and puts every chunk back in
+  void grow() {
+    vector<Slot> old;
+    old.swap(Table);
+    Slot unused = {NoKey, NULL};
+    Table.assign(old.size() * 2, unused);
+    for (size_t i = 0; i < old.size(); i++) {
+      if (old[i].Key != NoKey) {
+        Table[slotOf(old[i].Key)] = old[i];
+      }
+    }
+  }
+
+  Chunk* addChunk(size_t key) {
+    Chunk* chunk;
+    if (Spare.empty()) {
+      chunk = new Chunk();
+    }
+    else {
+      chunk = Spare.back();
+      Spare.pop_back();
+    }
+    for (size_t i = 0; i < ChunkSide * ChunkSide; i++) {
+      chunk->Cells[i] = Fill;
+    }
+    chunk->Used = 0;
+    if ((NumChunks + 1) * 2 > Table.size()) {
+      grow();
+    }
+    Slot& slot = Table[slotOf(key)];
+    slot.Key = key;
+    slot.Data = chunk;
+    NumChunks++;
+    LastKey = key;
+    LastChunk = chunk;
+    return chunk;
+  }
+
+  // Frees the slot of key and moves later entries of its probe run back into the gap,
+  // so no search ever has to step over a removed entry.
+  void removeChunk(size_t key, Chunk* chunk) {
+    size_t mask = Table.size() - 1;
+    size_t gap = slotOf(key);
+    for (size_t i = (gap + 1) & mask; Table[i].Key != NoKey; i = (i + 1) & mask) {
+      // an entry can fill the gap if its home is not in (gap, i]
+      size_t home = homeOf(Table[i].Key);
+      if (((i - home) & mask) >= ((i - gap) & mask)) {
+        Table[gap] = Table[i];
+        gap = i;
+      }
+    }
+    Table[gap].Key = NoKey;
+    NumChunks--;
+    Spare.push_back(chunk);
+    if (LastChunk == chunk) {
+      LastChunk = NULL;
+    }
+  }
+
+  void checkRange(size_t r, size_t c) const {
+    if (r >= NumRows || c >= NumCols) {
+      throw invalid_argument("ChunkedGrid () operator overload -> Invalid row or column argument provided");
+    }
+  }
+
+  ChunkedGrid(const ChunkedGrid&);
+  ChunkedGrid& operator=(const ChunkedGrid&);
+
+public:
+  // Default constructor -> an empty 0 x 0 grid, to be sized with resize().
+  ChunkedGrid() : NumRows(0), NumCols(0), ChunkCols(0), Fill(), NumChunks(0), LastKey(0), LastChunk(NULL) {
+    clear();
+  }
+
+  // Parameterized Constructor -> an R x C grid where every element reads as fill.
+  ChunkedGrid(size_t R, size_t C, const T& fill = T())
+    : NumRows(0), NumCols(0), ChunkCols(0), Fill(fill), NumChunks(0), LastKey(0), LastChunk(NULL) {
+    if (R == 0 || C == 0) {
+      throw invalid_argument("ChunkedGrid Parameterized Constructor -> invalid row or column input");
+    }
+    resize(R, C);
+  }
+
+  // Destructor -> frees every chunk, spare ones included.
+  ~ChunkedGrid() {
+    clear();
+    for (size_t i = 0; i < Spare.size(); i++) {
+      delete Spare[i];
+    }
+  }
+
+  // Makes the grid R x C with every element back to the fill value.
+  void resize(size_t R, size_t C) {
+    clear();
+    NumRows = R;
+    NumCols = C;
+    ChunkCols = (C + ChunkSide - 1) >> ChunkBits;
+  }
+
+  // Sets every element back to the fill value and frees the chunks.
+  void clear() {
+    for (size_t i = 0; i < Table.size(); i++) {
+      if (Table[i].Key != NoKey) {
+        delete Table[i].Data;
+      }
+    }
+    Slot unused = {NoKey, NULL};
+    Table.assign(16, unused);
+    NumChunks = 0;
+    LastChunk = NULL;
+  }
+
+  // Returns the number of rows in the grid.
+  size_t numrows() const {
+    return NumRows;
+  }
+
+  // returns the number of columns in row r of the grid (every row has the same).
+  size_t numcols(size_t) const {
+    return NumCols;
+  }
+
+  // Returns the total number elements in the grid object, stored or not.
+  size_t size() const {
+    return NumRows * NumCols;
+  }
+
+  // Returns the number of chunks allocated right now.
+  size_t numchunks() const {
+    return NumChunks;
+  }
+
+  // Parenthesis Operator overload -> returns the element at (r, c), the fill value if its
+  // chunk was never allocated. Read only; use set() to change an element.
+  const T& operator()(size_t r, size_t c) const {
+    checkRange(r, c);
+    Chunk* chunk = find(keyOf(r, c));
+    return chunk != NULL ? chunk->Cells[offsetOf(r, c)] : Fill;
+  }
+
+  // Stores value at (r, c), allocating its chunk if it needs one and recycling the
+  // chunk if that leaves it holding only the fill value.
+  void set(size_t r, size_t c, const T& value) {
+    checkRange(r, c);
+    size_t key = keyOf(r, c);
+    Chunk* chunk = find(key);
+    bool used = !(value == Fill);
+    if (chunk == NULL) {
+      if (!used) {
+        return;
+      }
+      chunk = addChunk(key);
+    }
+    T& cell = chunk->Cells[offsetOf(r, c)];
+    bool wasUsed = !(cell == Fill);
+    cell = value;
+    if (used != wasUsed) {
+      if (used) {
+        chunk->Used++;
+      }
+      else if (--chunk->Used == 0) {
+        removeChunk(key, chunk);
+      }
+    }
+  }
+
+  // Appends r * numcols() + c of every element that is not the fill value to cells,
+  // chunk by chunk in no particular order.
+  void usedCells(vector<size_t>& cells) const {
+    for (size_t s = 0; s < Table.size(); s++) {
+      if (Table[s].Key == NoKey) {
+        continue;
+      }
+      size_t top = (Table[s].Key / ChunkCols) << ChunkBits;
+      size_t left = (Table[s].Key % ChunkCols) << ChunkBits;
+      const Chunk& chunk = *Table[s].Data;
+      for (size_t i = 0; i < ChunkSide * ChunkSide; i++) {
+        if (!(chunk.Cells[i] == Fill)) {
+          cells.push_back((top + (i >> ChunkBits)) * NumCols + left + (i & (ChunkSide - 1)));
+        }
+      }
+    }
+  }
+
+};
@@ -0,0 +1,129 @@
+/*
+    Filename: "collisiontest.cpp"
+    Author: Viraj Saudagar
+
+    Deterministic check of the baddie collision policies, which difftest
+    cannot cover because the frozen reference board only knows the legacy
+    rules. Two monsters stand next to each other in the hero's row, the
+    one behind moving first, and the hero waits one turn:
+
+        . . . m m . . . H         (5,5) moves onto (5,6) first
+
+    The expected board after that turn is written out for every policy:
+
+        legacy   the mover replaces the other:    m at (5,6)
+        block    the mover stays, the other steps: m at (5,5) and (5,7)
+        swap     they trade places, both moved:    m at (5,5) and (5,6)
+        merge    one super monster where they met: M at (5,6)
+
+    and compared with every tile of the board, along with the number of
+    baddies and getCollisionCount() (1 for the policy played, 0 for the
+    others). Every kind of board makeGameBoard() hands out is checked.
+
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+#include "gameboard.h"
+
+// What the board holds after the turn, other than the hero at (5, 10).
+struct Expected {
+    CollisionPolicy policy;
+    size_t numBaddies;
+    TilePlacement baddies[2];
+};
+
+static const Expected kExpected[] = {
+    {CollisionLegacy, 1, {{5, 6, TileMonster}, {0, 0, TileEmpty}}},
+    {CollisionBlock, 2, {{5, 5, TileMonster}, {5, 7, TileMonster}}},
+    {CollisionSwap, 2, {{5, 5, TileMonster}, {5, 6, TileMonster}}},
+    {CollisionMerge, 1, {{5, 6, TileSuperMonster}, {0, 0, TileEmpty}}},
+};
+
+// plays the scene once; prints what differs and returns false if anything does
+bool checkPolicy(size_t rows, size_t cols, const Expected& expected) {
+    unique_ptr<GameBoardBase> board(makeGameBoard(rows, cols));
+    board->setVerbose(false);
+    board->setCollisionPolicy(expected.policy);
+
+    vector<TilePlacement> placements;
+    TilePlacement hero = {5, 10, TileHero};
+    TilePlacement mover = {5, 5, TileMonster};
+    TilePlacement other = {5, 6, TileMonster};
+    placements.push_back(hero);
+    placements.push_back(mover);
+    placements.push_back(other);
+    board->setupFromPlacements(placements);
+
+    bool alive = board->makeMoves('s');
+
+    vector<unsigned char> want(rows * cols, TileEmpty);
+    want[hero.row * cols + hero.col] = TileHero;
+    for (size_t k = 0; k < expected.numBaddies; k++) {
+        want[expected.baddies[k].row * cols + expected.baddies[k].col] = expected.baddies[k].tile;
+    }
+    vector<unsigned char> got(rows * cols);
+    board->getTiles(&got[0]);
+
+    const char* name = kCollisionPolicyNames[expected.policy];
+    bool ok = true;
+    if (!alive) {
+        cout << rows << "x" << cols << " " << name << ": the hero did not survive the turn" << endl;
+        ok = false;
+    }
+    size_t numBaddies = 0;
+    for (size_t i = 0; i < got.size(); i++) {
+        if (isBaddieTile(got[i])) {
+            numBaddies++;
+        }
+        if (got[i] != want[i]) {
+            cout << rows << "x" << cols << " " << name << ": (" << i / cols << "," << i % cols << ") is tile "
+                 << (int)got[i] << ", expected " << (int)want[i] << endl;
+            ok = false;
+        }
+    }
+    if (numBaddies != expected.numBaddies) {
+        cout << rows << "x" << cols << " " << name << ": " << numBaddies << " baddies, expected "
+             << expected.numBaddies << endl;
+        ok = false;
+    }
+    for (int p = 0; p < NumCollisionPolicies; p++) {
+        unsigned long wantCount = (p == expected.policy) ? 1 : 0;
+        if (board->getCollisionCount((CollisionPolicy)p) != wantCount) {
+            cout << rows << "x" << cols << " " << name << ": getCollisionCount(" << kCollisionPolicyNames[p]
+                 << ") is " << board->getCollisionCount((CollisionPolicy)p) << ", expected " << wantCount << endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main() {
+
+    // GameBoard, FixedGameBoard and SparseGameBoard, in that order
+    static const size_t kSizes[][2] = {{10, 20}, {15, 40}, {1100, 1000}};
+
+    size_t failures = 0;
+    size_t checks = 0;
+    for (size_t s = 0; s < sizeof(kSizes) / sizeof(kSizes[0]); s++) {
+        for (size_t e = 0; e < sizeof(kExpected) / sizeof(kExpected[0]); e++) {
+            checks++;
+            if (!checkPolicy(kSizes[s][0], kSizes[s][1], kExpected[e])) {
+                failures++;
+            }
+        }
+    }
+
+    if (failures > 0) {
+        cout << failures << " of " << checks << " collision checks failed" << endl;
+        return 1;
+    }
+    cout << "All " << checks << " collision checks passed." << endl;
+    return 0;
+
+} // main
@@ -0,0 +1,184 @@
+/*
+    Filename: "crowd.cpp"
+    Author: Viraj Saudagar
+
+    Many heroes on one shared world. Sets up a board (a SparseGameBoard
+    for the default 2000 x 2000 world, see makeGameBoard()) with --heroes
+    heroes, --monsters monsters and --bats bats scattered over it, plus
+    abysses and ladders, and plays --ticks rounds of makeTick() with a
+    random move for every hero. A hero whose game ended is replaced by a
+    new one on a random empty cell (addHero()), the way players rejoin,
+    so about --heroes heroes play every round; --no-respawn turns that
+    off. Reported:
+
+      - how long a round took (p50, p99 and max) and baddie moves per
+        second, each of them one nearest-hero lookup in the HeroIndex
+      - baddies that acted per round, out of those on the board
+      - heroes playing per round and how the heroes' games ended
+
+    --bucket sets the side of the index buckets (0, the default, lets the
+    index pick it); --scan puts the whole world into one bucket, which is
+    the same as looking at every hero for every baddie, for comparison.
+
+    --hero-every, --monster-every, --super-every and --bat-every set the
+    beats between two actions of each (see setActionSchedule()), and
+    --wake-radius lets baddies sleep until a hero comes that close, so
+    that a round only costs what the baddies near the heroes do.
+
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+using namespace std;
+
+#include "gameboard.h"
+#include "gamerng.h"
+#include "gamestats.h"
+
+int main(int argc, char* argv[]) {
+
+    size_t rows = 2000, cols = 2000;
+    size_t numHeroes = 1000, numMonsters = 45000, numBats = 5000;
+    size_t numAbysses = 20000, numLadders = 200;
+    size_t numTicks = 200;
+    size_t bucketSide = 0;
+    bool scan = false;
+    bool respawn = true;
+    int seed = 1;
+    CollisionPolicy collisionPolicy = CollisionBlock;
+    ActionSchedule schedule;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        bool ok = true;
+        if (arg == "--rows" && hasValue)              rows = max(1, atoi(argv[++i]));
+        else if (arg == "--cols" && hasValue)         cols = max(1, atoi(argv[++i]));
+        else if (arg == "--heroes" && hasValue)       numHeroes = atoi(argv[++i]);
+        else if (arg == "--monsters" && hasValue)     numMonsters = atoi(argv[++i]);
+        else if (arg == "--bats" && hasValue)         numBats = atoi(argv[++i]);
+        else if (arg == "--abysses" && hasValue)      numAbysses = atoi(argv[++i]);
+        else if (arg == "--ladders" && hasValue)      numLadders = atoi(argv[++i]);
+        else if (arg == "--ticks" && hasValue)        numTicks = max(1, atoi(argv[++i]));
+        else if (arg == "--bucket" && hasValue)       bucketSide = atoi(argv[++i]);
+        else if (arg == "--scan")                     scan = true;
+        else if (arg == "--no-respawn")               respawn = false;
+        else if (arg == "--seed" && hasValue)         seed = atoi(argv[++i]);
+        else if (arg == "--collisions" && hasValue)   ok = collisionPolicyOfName(argv[++i], collisionPolicy);
+        else if (arg == "--hero-every" && hasValue)   schedule.hero = max(1, atoi(argv[++i]));
+        else if (arg == "--monster-every" && hasValue) schedule.monster = max(1, atoi(argv[++i]));
+        else if (arg == "--super-every" && hasValue)  schedule.superMonster = max(1, atoi(argv[++i]));
+        else if (arg == "--bat-every" && hasValue)    schedule.bat = max(1, atoi(argv[++i]));
+        else if (arg == "--wake-radius" && hasValue)  schedule.wakeRadius = atoi(argv[++i]);
+        else                                          ok = false;
+        if (!ok) {
+            cout << "usage: " << argv[0] << " [--rows n] [--cols n] [--heroes n] [--monsters n] [--bats n]" << endl;
+            cout << "       [--abysses n] [--ladders n] [--ticks n] [--bucket side] [--scan] [--no-respawn]" << endl;
+            cout << "       [--seed n] [--collisions block|swap|merge|legacy] [--hero-every beats]" << endl;
+            cout << "       [--monster-every beats] [--super-every beats] [--bat-every beats] [--wake-radius n]" << endl;
+            return 1;
+        }
+    }
+    size_t numPlaced = numHeroes + numMonsters + numBats + numAbysses + numLadders;
+    if (numPlaced > rows * cols / 2) {
+        cout << "too many things for a " << rows << "x" << cols << " world" << endl;
+        return 1;
+    }
+    if (scan) {
+        bucketSide = max(rows, cols);
+    }
+
+    // every kind of tile on cells of its own; a third of the monsters are super monsters
+    GameRng rng(seed);
+    vector<bool> used(rows * cols, false);
+    vector<TilePlacement> placements;
+    size_t counts[] = {numHeroes, numMonsters - numMonsters / 3, numMonsters / 3, numBats, numAbysses, numLadders};
+    unsigned char tiles[] = {TileHero, TileMonster, TileSuperMonster, TileBat, TileAbyss, TileLadder};
+    for (size_t t = 0; t < sizeof(tiles); t++) {
+        for (size_t n = 0; n < counts[t]; n++) {
+            size_t cell;
+            do {
+                cell = ((size_t)rng() * 32768 + rng()) % (rows * cols);
+            } while (used[cell]);
+            used[cell] = true;
+            TilePlacement p = {cell / cols, cell % cols, tiles[t]};
+            placements.push_back(p);
+        }
+    }
+
+    unique_ptr<GameBoardBase> board(makeGameBoard(rows, cols));
+    board->setVerbose(false);
+    board->setCollisionPolicy(collisionPolicy);
+    board->setMultiHero(true, bucketSide);
+    board->setActionSchedule(schedule);
+    chrono::steady_clock::time_point setupStart = chrono::steady_clock::now();
+    board->setupFromPlacements(placements);
+    double setupSeconds = chrono::duration<double>(chrono::steady_clock::now() - setupStart).count();
+
+    cout << rows << "x" << cols << " world, " << numHeroes << " heroes, " << numMonsters << " monsters, "
+         << numBats << " bats, " << numTicks << " ticks, "
+         << (scan ? string("every hero looked at by every baddie") :
+             bucketSide ? "bucket side " + to_string(bucketSide) : string("index picks the bucket side")) << endl;
+    if (!schedule.lockstep()) {
+        printf("hero every %u beats, monsters every %u, super monsters every %u, bats every %u, wake radius %zu\n",
+               schedule.hero, schedule.monster, schedule.superMonster, schedule.bat, schedule.wakeRadius);
+    }
+    printf("set up in %.3f s\n", setupSeconds);
+
+    static const char kMoves[] = "qweasdzxc";
+    vector<char> heroMoves;
+    LogHistogram tickMicros;
+    RunningStats heroesPlaying;
+    RunningStats baddiesActing;
+    size_t playing = board->getPlayingHeroes();
+    size_t respawns = 0;
+    double seconds = 0;
+    for (size_t t = 0; t < numTicks && playing > 0; t++) {
+        heroMoves.resize(board->getNumHeroes());
+        for (size_t h = 0; h < heroMoves.size(); h++) {
+            heroMoves[h] = kMoves[rng() % 9];
+        }
+        heroesPlaying.add(playing);
+        unsigned long actionsBefore = board->getBaddieActions();
+        chrono::steady_clock::time_point tickStart = chrono::steady_clock::now();
+        playing = board->makeTick(&heroMoves[0]);
+        double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - tickStart).count();
+        tickMicros.add(micros);
+        baddiesActing.add(board->getBaddieActions() - actionsBefore);
+        seconds += micros / 1e6;
+        for (; respawn && playing < numHeroes; playing++, respawns++) {
+            size_t r, c;
+            do {
+                size_t cell = ((size_t)rng() * 32768 + rng()) % (rows * cols);
+                r = cell / cols;
+                c = cell % cols;
+            } while (board->getCellTile(r, c) != TileEmpty);
+            board->addHero(r, c);
+        }
+    }
+
+    size_t outcomes[NumGameOutcomes] = {0};
+    for (size_t h = 0; h < board->getNumHeroes(); h++) {
+        outcomes[board->getHeroOutcome(h)]++;
+    }
+
+    cout << endl;
+    printf("tick us            p50 %.1f, p99 %.1f, max %.1f over %zu ticks\n", tickMicros.quantile(0.5),
+           tickMicros.quantile(0.99), tickMicros.maximum(), tickMicros.count());
+    printf("baddie moves/s     %.0f\n", board->getBaddieActions() / seconds);
+    printf("baddies per tick   %.1f acted (%zu baddies at the start)\n", baddiesActing.mean(), numMonsters + numBats);
+    printf("heroes per tick    %.1f, %zu rejoined\n", heroesPlaying.mean(), respawns);
+    printf("heroes             playing %zu, escaped %zu, abyss %zu, monster %zu, bat %zu\n",
+           outcomes[OutcomePlaying], outcomes[OutcomeEscaped], outcomes[OutcomeAbyss], outcomes[OutcomeMonster],
+           outcomes[OutcomeBat]);
+    cout << endl << tickMicros.count() << " ticks in " << seconds << " s (makeTick() only)" << endl;
+
+    return 0;
+
+} // main
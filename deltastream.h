@@ -0,0 +1,294 @@
+/*
+    Filename: "deltastream.h"
+    Author: Viraj Saudagar
+
+    This file defines the spectator stream: a compact binary encoding of a
+    game as one keyframe followed by one delta per turn.
+
+    Every frame is a varint byte count followed by that many bytes:
+
+        'K' turn status rows cols run...      keyframe, the whole board as runs
+                                              of equal tiles: varint(length << 3 | tile)
+        'D' turn status count cell...         delta, the cells that changed this
+                                              turn: varint(gap << 3 | tile), where gap
+                                              is the number of cells skipped since the
+                                              previous changed cell
+
+    turn, rows, cols and count are varints (7 bits per byte, low bits first);
+    status is one byte, bit 0 = game over, bit 1 = hero escaped. Tiles are
+    TileType codes. A delta costs a few bytes per changed cell, so it does
+    not grow with the board, and it carries the new tile of every cell it
+    lists, so applying it twice does no harm.
+
+    DeltaEncoder produces frames for one board (it turns on the board's
+    change tracking) into SharedFrame buffers that are built once and can
+    be handed to any number of spectators without copying; DeltaDecoder
+    rebuilds the board on the spectator side.
+
+*/
+
+#ifndef _DELTASTREAM_H
+#define _DELTASTREAM_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#include "gameboard.h"
+#include "tiles.h"
+
+using namespace std;
+
+typedef vector<unsigned char> FrameBuffer;
+typedef shared_ptr<const FrameBuffer> SharedFrame;
+
+enum FrameKind {
+    FrameKey = 'K',
+    FrameDelta = 'D'
+};
+
+static const unsigned char kStatusOver = 1;
+static const unsigned char kStatusWon = 2;
+
+inline void putVarint(FrameBuffer& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+// reads a varint at data[at], advancing at; returns false if it runs past size
+inline bool getVarint(const unsigned char* data, size_t size, size_t& at, size_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && at < size; shift += 7) {
+        unsigned char byte = data[at++];
+        value |= (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+class DeltaEncoder {
+    private:
+        GameBoardBase& board;
+        size_t keyframeInterval;  // a keyframe at least every this many frames
+        size_t turn;
+        size_t sinceKeyframe;
+        vector<size_t> changes;
+        vector<unsigned char> tiles;
+        FrameBuffer body;
+
+        unsigned char status(bool over) {
+            return (over ? kStatusOver : 0) | (board.getWonGame() ? kStatusWon : 0);
+        }
+
+        void finish(FrameBuffer& out) {
+            putVarint(out, body.size());
+            out.insert(out.end(), body.begin(), body.end());
+        }
+
+    public:
+        /* param constructor -> starts tracking changes on board, which has to outlive the encoder */
+        DeltaEncoder(GameBoardBase& b, size_t interval = 64)
+            : board(b), keyframeInterval(max((size_t)1, interval)), turn(0), sinceKeyframe(0) {
+            board.setTrackChanges(true);
+            tiles.resize(board.getNumRows() * board.getNumCols());
+        }
+
+        /* destructor */
+        virtual ~DeltaEncoder() {
+            board.setTrackChanges(false);
+        }
+
+        size_t getTurn() const {
+            return turn;
+        }
+
+        // appends a keyframe of the board as it is now; it does not advance the turn or
+        // disturb the deltas, so it can be sent to a spectator who joins in the middle
+        void keyframe(FrameBuffer& out, bool over) {
+            board.getTiles(&tiles[0]);
+            body.clear();
+            body.push_back(FrameKey);
+            putVarint(body, turn);
+            body.push_back(status(over));
+            putVarint(body, board.getNumRows());
+            putVarint(body, board.getNumCols());
+            size_t i = 0;
+            while (i < tiles.size()) {
+                size_t run = 1;
+                while (i + run < tiles.size() && tiles[i + run] == tiles[i]) {
+                    run++;
+                }
+                putVarint(body, run << 3 | tiles[i]);
+                i += run;
+            }
+            finish(out);
+        }
+
+        // appends the frame for the turn that was just played: a delta, or every
+        // keyframeInterval frames a keyframe
+        void nextFrame(FrameBuffer& out, bool over) {
+            turn++;
+            changes.clear();
+            board.takeChangedCells(changes);
+
+            if (++sinceKeyframe >= keyframeInterval) {
+                sinceKeyframe = 0;
+                keyframe(out, over);
+                return;
+            }
+
+            sort(changes.begin(), changes.end());
+            size_t cols = board.getNumCols();
+            body.clear();
+            body.push_back(FrameDelta);
+            putVarint(body, turn);
+            body.push_back(status(over));
+            putVarint(body, changes.size());
+            size_t next = 0;
+            for (size_t i = 0; i < changes.size(); i++) {
+                size_t cell = changes[i];
+                unsigned char tile = board.getCellTile(cell / cols, cell % cols);
+                putVarint(body, (cell - next) << 3 | tile);
+                next = cell + 1;
+            }
+            finish(out);
+        }
+
+    private:
+        DeltaEncoder(const DeltaEncoder&);
+        DeltaEncoder& operator=(const DeltaEncoder&);
+};
+
+
+class DeltaDecoder {
+    private:
+        size_t rows, cols;
+        size_t turn;
+        unsigned char status;
+        unsigned char kind;  // FrameKind of the last frame
+        vector<unsigned char> tiles;
+
+        static void fail(const string& why) {
+            throw runtime_error("DeltaDecoder apply -> " + why);
+        }
+
+    public:
+        /* default constructor -> nothing to show until the first keyframe */
+        DeltaDecoder() : rows(0), cols(0), turn(0), status(0), kind(0) {}
+
+        //---------------------------------------------------------------------------------
+        // size_t apply(const unsigned char* data, size_t size)
+        //
+        // Applies the frame at the start of data. Returns the number of bytes it used,
+        // or 0 if data does not hold a whole frame yet. Throws runtime_error for a
+        // frame that is malformed or a delta that arrives before any keyframe.
+        //---------------------------------------------------------------------------------
+        size_t apply(const unsigned char* data, size_t size) {
+            size_t at = 0;
+            size_t length;
+            if (!getVarint(data, size, at, length) || size - at < length) {
+                return 0;
+            }
+            size_t end = at + length;
+            if (length < 3) {
+                fail("frame too short");
+            }
+            unsigned char frameKind = data[at++];
+            size_t frameTurn;
+            if (!getVarint(data, end, at, frameTurn) || at >= end) {
+                fail("bad frame header");
+            }
+            unsigned char frameStatus = data[at++];
+
+            if (frameKind == FrameKey) {
+                size_t r, c;
+                if (!getVarint(data, end, at, r) || !getVarint(data, end, at, c) || r == 0 || c == 0 || r * c > (1 << 20)) {
+                    fail("bad keyframe size");
+                }
+                vector<unsigned char> board(r * c);
+                size_t filled = 0;
+                while (at < end) {
+                    size_t run;
+                    if (!getVarint(data, end, at, run) || (run >> 3) > board.size() - filled) {
+                        fail("bad keyframe run");
+                    }
+                    fill(board.begin() + filled, board.begin() + filled + (run >> 3), (unsigned char)(run & 7));
+                    filled += run >> 3;
+                }
+                if (filled != board.size()) {
+                    fail("keyframe does not cover the board");
+                }
+                rows = r;
+                cols = c;
+                tiles.swap(board);
+            }
+            else if (frameKind == FrameDelta) {
+                if (tiles.empty()) {
+                    fail("delta before the first keyframe");
+                }
+                size_t count, next = 0;
+                if (!getVarint(data, end, at, count)) {
+                    fail("bad delta count");
+                }
+                for (size_t i = 0; i < count; i++) {
+                    size_t entry;
+                    if (!getVarint(data, end, at, entry) || (entry >> 3) >= tiles.size() - next) {
+                        fail("bad delta cell");
+                    }
+                    next += entry >> 3;
+                    tiles[next++] = entry & 7;
+                }
+            }
+            else {
+                fail("unknown frame kind");
+            }
+
+            turn = frameTurn;
+            status = frameStatus;
+            kind = frameKind;
+            return end;
+        }
+
+        bool ready() const {
+            return !tiles.empty();
+        }
+
+        size_t numRows() const {
+            return rows;
+        }
+
+        size_t numCols() const {
+            return cols;
+        }
+
+        size_t getTurn() const {
+            return turn;
+        }
+
+        bool lastWasKeyframe() const {
+            return kind == FrameKey;
+        }
+
+        bool gameOver() const {
+            return (status & kStatusOver) != 0;
+        }
+
+        bool wonGame() const {
+            return (status & kStatusWon) != 0;
+        }
+
+        // TileType of cell (r, c) as of the last frame
+        unsigned char tile(size_t r, size_t c) const {
+            return tiles[r * cols + c];
+        }
+};
+
+#endif //_DELTASTREAM_H
@@ -0,0 +1,307 @@
+/*
+    Filename: "difftest.cpp"
+    Author: Viraj Saudagar
+
+    Differential test harness for the game engine. Every test case is a
+    random board (seed, size, abysses, monsters, bats) plus a random move
+    sequence. The frozen ReferenceGameBoard and the board makeGameBoard()
+    returns for that size (GameBoard or a FixedGameBoard) are
+    set up from the same parameters and played in lockstep; after setup and
+    after every turn the full observable state is compared: every tile,
+    the hero position, the makeMoves() result and getWonGame().
+
+    On a divergence the move sequence is minimized (chunks of moves are
+    removed, then single moves replaced by 's', for as long as the engines
+    still disagree) and a reproducer is printed that can be rerun with
+    --case or played with game.exe --script.
+
+    With --shared-terrain the optimized board is set up a second time, from
+    a Terrain built out of its layout (setupFromTerrain()), so the shared
+    move tables are what gets compared.
+
+    With --sparse the optimized board is a SparseGameBoard instead, set up
+    a second time from the non-empty squares of its layout
+    (setupFromPlacements()) unless --shared-terrain is given too.
+
+    ReferenceGameBoard::setupBoard() seeds the global rand() state, so cases
+    run one at a time.
+    Use --start and --count to shard a long run across processes.
+
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+#include "gameboard.h"
+#include "referenceboard.h"
+
+struct TestCase {
+    int seed;
+    int rows;
+    int cols;
+    int abysses;
+    int monsters;
+    int bats;
+    string moves;
+};
+
+string describe(const TestCase& tc) {
+    ostringstream out;
+    out << tc.seed << ' ' << tc.rows << ' ' << tc.cols << ' ' << tc.abysses << ' '
+        << tc.monsters << ' ' << tc.bats << ' ' << (tc.moves.empty() ? "-" : tc.moves);
+    return out.str();
+}
+
+// Builds test case number n. Parameters stay inside the ranges main.cpp
+// accepts and leave enough free cells for setupBoard() to place everything.
+TestCase makeCase(unsigned long long n, size_t maxTurns) {
+    const char moveChars[] = "qazwxedcs";
+    mt19937 rng((unsigned)(n * 2654435761ULL + 12345));
+    TestCase tc;
+    tc.seed = (int)(rng() & 0x7fffffff);
+    tc.rows = 10 + rng() % 21;
+    tc.cols = 15 + rng() % 86;
+    if (rng() % 4 == 0) {
+        // make sure the compile-time sized boards from makeGameBoard() get covered
+        bool small = (rng() % 2 == 0);
+        tc.rows = small ? 15 : 30;
+        tc.cols = small ? 40 : 100;
+    }
+    int room = tc.rows * (tc.cols - 6) / 2;
+    tc.abysses = rng() % (min(200, room) + 1);
+    tc.monsters = rng() % (min(30, room - tc.abysses) + 1);
+    tc.bats = rng() % (min(10, room - tc.abysses - tc.monsters) + 1);
+    size_t turns = 1 + rng() % maxTurns;
+    for (size_t i = 0; i < turns; i++) {
+        tc.moves += (rng() % 50 == 0) ? '?' : moveChars[rng() % 9];
+    }
+    return tc;
+}
+
+// Everything the public API exposes about a board, as one comparable string.
+template<typename Board>
+string snapshot(Board& board, const string& result) {
+    ostringstream out;
+    size_t hr, hc;
+    board.getHeroPosition(hr, hc);
+    out << result << " won=" << board.getWonGame() << " hero=" << (long long)hr << ',' << (long long)hc << '\n';
+    for (size_t r = 0; r < board.getNumRows(); r++) {
+        for (size_t c = 0; c < board.getNumCols(); c++) {
+            out << board.getCellDisplay(r, c);
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+template<typename Board>
+void setup(Board& board, const TestCase& tc) {
+    board.setVerbose(false);
+    board.setNumAbysses(tc.abysses);
+    board.setNumMonsters(tc.monsters);
+    board.setNumBats(tc.bats);
+    board.setupBoard(tc.seed);
+}
+
+template<typename Board>
+string play(Board& board, char move) {
+    try {
+        return board.makeMoves(move) ? "alive" : "over";
+    }
+    catch (exception& excpt) {
+        return string("exception: ") + excpt.what();
+    }
+}
+
+//---------------------------------------------------------------------------------
+// long firstDivergence(const TestCase& tc, string* refState, string* optState)
+//
+// Plays the case on both engines. Returns -1 if they agree throughout, 0 if they
+// already differ after setupBoard(), or k if they first differ after move k.
+// The two differing states are returned through refState/optState when given.
+//---------------------------------------------------------------------------------
+bool sharedTerrain = false;  // --shared-terrain
+bool sparseBoard = false;    // --sparse
+
+long firstDivergence(const TestCase& tc, string* refState = NULL, string* optState = NULL) {
+    ReferenceGameBoard reference(tc.rows, tc.cols);
+    unique_ptr<GameBoardBase> optimizedPtr(sparseBoard ? new SparseGameBoard(tc.rows, tc.cols)
+                                                       : makeGameBoard(tc.rows, tc.cols));
+    GameBoardBase& optimized = *optimizedPtr;
+    optimized.setCollisionPolicy(CollisionLegacy);  // the reference engine replaces colliding baddies
+    setup(reference, tc);
+    setup(optimized, tc);
+    if (sharedTerrain) {
+        vector<unsigned char> layout(tc.rows * tc.cols);
+        optimized.getTiles(&layout[0]);
+        optimized.setupFromTerrain(makeTerrain(tc.rows, tc.cols, &layout[0]));
+    }
+    else if (sparseBoard) {
+        vector<unsigned char> layout(tc.rows * tc.cols);
+        optimized.getTiles(&layout[0]);
+        vector<TilePlacement> placements;
+        for (size_t i = 0; i < layout.size(); i++) {
+            if (layout[i] != TileEmpty) {
+                TilePlacement p = {i / tc.cols, i % tc.cols, layout[i]};
+                placements.push_back(p);
+            }
+        }
+        optimized.setupFromPlacements(placements);
+    }
+
+    string ref = snapshot(reference, "setup");
+    string opt = snapshot(optimized, "setup");
+
+    for (size_t turn = 0; ; turn++) {
+        if (ref != opt) {
+            if (refState != NULL) {
+                *refState = ref;
+                *optState = opt;
+            }
+            return (long)turn;
+        }
+        bool over = (turn > 0 && ref.compare(0, 5, "alive") != 0);
+        if (over || turn == tc.moves.size()) {
+            return -1;
+        }
+        string refResult = play(reference, tc.moves[turn]);
+        string optResult = play(optimized, tc.moves[turn]);
+        ref = snapshot(reference, refResult);
+        opt = snapshot(optimized, optResult);
+    }
+}
+
+// Shrinks the move sequence while the engines still disagree.
+TestCase minimize(TestCase tc) {
+    long at = firstDivergence(tc);
+    tc.moves.resize(at);
+
+    for (size_t chunk = max((size_t)1, tc.moves.size() / 2); chunk >= 1; chunk /= 2) {
+        for (size_t start = 0; start < tc.moves.size(); ) {
+            TestCase smaller = tc;
+            smaller.moves.erase(start, chunk);
+            long d = firstDivergence(smaller);
+            if (d >= 0) {
+                smaller.moves.resize(d);
+                tc = smaller;
+            }
+            else {
+                start += chunk;
+            }
+        }
+        if (chunk == 1) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < tc.moves.size(); i++) {
+        if (tc.moves[i] == 's') {
+            continue;
+        }
+        TestCase simpler = tc;
+        simpler.moves[i] = 's';
+        long d = firstDivergence(simpler);
+        if (d >= 0) {
+            simpler.moves.resize(d);
+            tc = simpler;
+        }
+    }
+
+    return tc;
+}
+
+void reportDivergence(const TestCase& found) {
+    TestCase small = minimize(found);
+    string ref, opt;
+    long at = firstDivergence(small, &ref, &opt);
+
+    cout << "DIVERGENCE after " << (at == 0 ? string("setup") : "move " + to_string(at)) << endl;
+    cout << "reproducer: --case \"" << describe(small) << "\"" << (sharedTerrain ? " --shared-terrain" : "")
+         << (sparseBoard ? " --sparse" : "") << endl;
+    cout << "play it:    ./game.exe --rows " << small.rows << " --cols " << small.cols << " --abysses " << small.abysses
+         << " --monsters " << small.monsters << " --bats " << small.bats << " --seed " << small.seed
+         << " --script \"" << small.moves << "\"" << endl;
+    cout << "--- reference ---" << endl << ref;
+    cout << "--- optimized ---" << endl << opt;
+}
+
+int main(int argc, char* argv[]) {
+
+    unsigned long long start = 0;
+    unsigned long long count = 10000;
+    size_t maxTurns = 200;
+    string single;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--start" && i + 1 < argc) {
+            start = strtoull(argv[++i], NULL, 10);
+        }
+        else if (arg == "--count" && i + 1 < argc) {
+            count = strtoull(argv[++i], NULL, 10);
+        }
+        else if (arg == "--turns" && i + 1 < argc) {
+            maxTurns = max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--case" && i + 1 < argc) {
+            single = argv[++i];
+        }
+        else if (arg == "--shared-terrain") {
+            sharedTerrain = true;
+        }
+        else if (arg == "--sparse") {
+            sparseBoard = true;
+        }
+        else {
+            cout << "usage: " << argv[0] << " [--start n] [--count n] [--turns n] [--shared-terrain] [--sparse]"
+                 << " [--case \"seed rows cols abysses monsters bats moves\"]" << endl;
+            return 1;
+        }
+    }
+
+    if (!single.empty()) {
+        TestCase tc;
+        istringstream in(single);
+        in >> tc.seed >> tc.rows >> tc.cols >> tc.abysses >> tc.monsters >> tc.bats >> tc.moves;
+        if (!in && !in.eof()) {
+            cout << "could not parse --case" << endl;
+            return 1;
+        }
+        if (tc.moves == "-") {
+            tc.moves.clear();
+        }
+        if (firstDivergence(tc) < 0) {
+            cout << "engines agree on " << describe(tc) << endl;
+            return 0;
+        }
+        reportDivergence(tc);
+        return 1;
+    }
+
+    chrono::steady_clock::time_point began = chrono::steady_clock::now();
+    for (unsigned long long n = start; n < start + count; n++) {
+        TestCase tc = makeCase(n, maxTurns);
+        if (firstDivergence(tc) >= 0) {
+            cout << "case " << n << " diverged" << endl;
+            reportDivergence(tc);
+            return 1;
+        }
+        if ((n - start + 1) % 10000 == 0) {
+            cout << (n - start + 1) << " cases agree" << endl;
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - began).count();
+    cout << "All " << count << " cases agree (cases " << start << ".." << (start + count - 1) << ", "
+         << seconds << " s)." << endl;
+    return 0;
+
+} // main
@@ -0,0 +1,171 @@
+/*
+    Filename: "dungeon.cpp"
+    Author: Viraj Saudagar
+
+    Multi-level run benchmark. A hero policy (see heropolicy.h) plays runs
+    through a Dungeon (see dungeon.h), going down every ladder it reaches
+    until it dies, runs out of turns on a level, or escapes the last level.
+    Reported:
+
+      - how deep the runs got and how many turns they took
+      - how long going down a ladder took (p50, p99 and max) and how
+        many transitions had to wait for the background thread
+      - levels resident and evicted under the budget, with the estimated
+        bytes they take, next to the process' resident set from /proc
+
+    Runs are played one after the other on the calling thread, so the only
+    other thread is the dungeon's own.
+
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <chrono>
+
+using namespace std;
+
+#include "gameboard.h"
+#include "heropolicy.h"
+#include "gamestats.h"
+#include "levellibrary.h"
+#include "dungeon.h"
+
+// the kB value of field ("VmRSS", "VmHWM", ...) in /proc/self/status, 0 if there is none
+size_t processKilobytes(const string& field) {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, field.size() + 1, field + ":") == 0) {
+            return strtoul(line.c_str() + field.size() + 1, NULL, 10);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+    DungeonConfig config;
+    config.numLevels = 20;
+    string policyName = "planner";
+    string libraryPath;
+    size_t numRuns = 100;
+    size_t maxTurns = 500;   // per level
+    size_t budgetKB = 256;
+    int startSeed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        bool ok = true;
+        if (arg == "--policy" && hasValue)                    policyName = argv[++i];
+        else if (arg == "--rows" && hasValue)                 config.rows = atoi(argv[++i]);
+        else if (arg == "--cols" && hasValue)                 config.cols = atoi(argv[++i]);
+        else if (arg == "--abysses" && hasValue)              config.abysses = atoi(argv[++i]);
+        else if (arg == "--monsters" && hasValue)             config.monsters = atoi(argv[++i]);
+        else if (arg == "--monsters-per-level" && hasValue)   config.monstersPerLevel = atoi(argv[++i]);
+        else if (arg == "--bats" && hasValue)                 config.bats = atoi(argv[++i]);
+        else if (arg == "--collisions" && hasValue)           ok = collisionPolicyOfName(argv[++i], config.collisionPolicy);
+        else if (arg == "--fog" && hasValue)                  config.fogRadius = atoi(argv[++i]);
+        else if (arg == "--levels" && hasValue)               config.numLevels = atoi(argv[++i]);
+        else if (arg == "--library" && hasValue)              libraryPath = argv[++i];
+        else if (arg == "--lookahead" && hasValue)            config.lookahead = max(1, atoi(argv[++i]));
+        else if (arg == "--budget-kb" && hasValue)            budgetKB = atoi(argv[++i]);
+        else if (arg == "--runs" && hasValue)                 numRuns = max(1, atoi(argv[++i]));
+        else if (arg == "--max-turns" && hasValue)            maxTurns = max(1, atoi(argv[++i]));
+        else if (arg == "--start-seed" && hasValue)           startSeed = atoi(argv[++i]);
+        else                                                  ok = false;
+        if (!ok) {
+            cout << "usage: " << argv[0] << " [--policy name] [--rows n] [--cols n] [--abysses n] [--monsters n]" << endl;
+            cout << "       [--monsters-per-level n] [--bats n] [--collisions block|swap|merge|legacy] [--fog radius]" << endl;
+            cout << "       [--levels n] [--library path] [--lookahead n] [--budget-kb n] [--runs n] [--max-turns n]" << endl;
+            cout << "       [--start-seed n]" << endl;
+            cout << "policies: random, greedy, planner, safe, search; --levels 0 plays until the hero dies" << endl;
+            return 1;
+        }
+    }
+    unique_ptr<HeroPolicy> policy(makeHeroPolicy(policyName));
+    if (!policy) {
+        cout << "unknown policy " << policyName << endl;
+        return 1;
+    }
+    unique_ptr<LevelLibrary> library;
+    if (!libraryPath.empty()) {
+        try {
+            library.reset(new LevelLibrary(libraryPath));
+        }
+        catch (const exception& e) {
+            cout << e.what() << endl;
+            return 1;
+        }
+        config.library = library.get();
+    }
+    else if (!validGameParameters(config.rows, config.cols, config.abysses, config.monsters, config.bats)) {
+        cout << "board parameters out of range" << endl;
+        return 1;
+    }
+    config.budgetBytes = budgetKB * 1024;
+
+    RunningStats depths, runTurns;
+    LogHistogram transitionHistogram;
+    size_t cleared = 0, stalls = 0, evictions = 0, transitions = 0;
+    size_t peakLevels = 0, peakBytes = 0;
+    size_t outcomes[NumGameOutcomes] = {0};
+
+    cout << numRuns << " runs of " << policyName << " through "
+         << (config.numLevels ? to_string(config.numLevels) : string("endless")) << " levels ("
+         << (library ? "library " + libraryPath : "generated") << "), lookahead " << config.lookahead
+         << ", budget " << budgetKB << " kB" << endl;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t run = 0; run < numRuns; run++) {
+        // every run starts further along the seeds so runs do not replay each other
+        config.seed = startSeed + (int)run * 1000;
+        Dungeon dungeon(config);
+        bool playing = true;
+        while (playing) {
+            BoardView view(dungeon.board());
+            policy->startGame(view, config.seed + (int)dungeon.heroState().depth);
+            bool alive = true;
+            while (alive && dungeon.heroState().levelTurns < maxTurns) {
+                alive = dungeon.makeMoves(policy->nextMove(view));
+            }
+            GameOutcome outcome = dungeon.board().getOutcome();
+            peakLevels = max(peakLevels, dungeon.residentLevels());
+            peakBytes = max(peakBytes, dungeon.residentBytes());
+            if (outcome != OutcomeEscaped || !dungeon.descend()) {
+                outcomes[outcome]++;
+                playing = false;
+            }
+        }
+        cleared += dungeon.cleared();
+        depths.add(dungeon.heroState().depth + 1);
+        runTurns.add(dungeon.heroState().turns);
+        transitionHistogram.merge(dungeon.transitionMicros());
+        transitions += dungeon.transitionMicros().count();
+        stalls += dungeon.getStalls();
+        evictions += dungeon.getEvictions();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << endl;
+    printf("levels reached     %.2f +- %.2f (cleared %zu of %zu runs)\n", depths.mean(), depths.meanHalfWidth(), cleared, numRuns);
+    printf("turns per run      %.1f +- %.1f\n", runTurns.mean(), runTurns.meanHalfWidth());
+    printf("runs ended by      escaped %zu, abyss %zu, monster %zu, bat %zu, turn limit %zu\n",
+           outcomes[OutcomeEscaped], outcomes[OutcomeAbyss], outcomes[OutcomeMonster], outcomes[OutcomeBat],
+           outcomes[OutcomePlaying]);
+    printf("transitions        %zu, %zu waited for the level to be made\n", transitions, stalls);
+    if (transitions > 0) {
+        printf("transition us      p50 %.2f, p99 %.2f, max %.1f\n", transitionHistogram.quantile(0.5),
+               transitionHistogram.quantile(0.99), transitionHistogram.maximum());
+    }
+    printf("resident levels    peak %zu (%.1f kB estimated), %zu evicted\n", peakLevels, peakBytes / 1024.0, evictions);
+    printf("process memory     rss %zu kB, peak %zu kB\n", processKilobytes("VmRSS"), processKilobytes("VmHWM"));
+    cout << endl << numRuns << " runs in " << seconds << " s" << endl;
+
+    return 0;
+
+} // main
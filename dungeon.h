@@ -0,0 +1,394 @@
+/*
+    Filename: "dungeon.h"
+    Author: Viraj Saudagar
+
+    This file defines Dungeon, a run through a series of levels: the
+    EscapeLadder of one level leads down to the next instead of ending the
+    game, until the hero dies or the last level is escaped.
+
+    Levels are made on a background thread ahead of the hero, either with
+    setupBoard() (one more seed per level, skipping the seeds that
+    analyzeLevel() finds no way out of, and a few more monsters the deeper
+    the level) or drawn from a level library (see levellibrary.h). Up to
+    lookahead finished levels wait in a queue, so going down a ladder only
+    swaps a pointer. descend() times every switch and counts the ones that
+    had to wait for the background thread after all.
+
+    Levels the hero has left stay resident, newest first, for as long as
+    everything resident (past, current and queued levels) fits in the
+    memory budget; the oldest are evicted beyond it. Evicted boards are
+    freed on the background thread too, so nothing the hero waits on
+    frees memory. What a level takes is estimated from its size by
+    levelBytes().
+
+    The hero's state (the depth it got to and the turns it played) is
+    carried from level to level in a HeroState, and every level is set up
+    with the same collision policy, fog of war, threat map, undo history
+    and event log.
+
+*/
+
+#ifndef _DUNGEON_H
+#define _DUNGEON_H
+
+#include <cstddef>
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "gameboard.h"
+#include "levellibrary.h"
+#include "gamestats.h"
+
+using namespace std;
+
+struct DungeonConfig {
+    int rows, cols, abysses, monsters, bats;
+    int monstersPerLevel;         // added to monsters on every level below the first (up to what fits)
+    int seed;                     // the first seed tried for level 0
+    const LevelLibrary* library;  // levels come from here instead of setupBoard() if not NULL
+    size_t numLevels;             // escaping level numLevels - 1 wins the run; 0 = endless
+    size_t lookahead;             // finished levels kept waiting ahead of the hero
+    size_t budgetBytes;           // past levels are evicted beyond this; 0 = keep none
+    CollisionPolicy collisionPolicy;
+    size_t fogRadius;
+    bool trackThreats;
+    size_t undoTurns, undoChanges;
+    bool verbose;
+    EventLog* eventLog;
+    unsigned eventSource;
+
+    DungeonConfig() : rows(15), cols(40), abysses(20), monsters(6), bats(3), monstersPerLevel(1), seed(1),
+                      library(NULL), numLevels(0), lookahead(2), budgetBytes(1 << 20),
+                      collisionPolicy(CollisionBlock), fogRadius(0), trackThreats(false), undoTurns(0), undoChanges(0),
+                      verbose(false), eventLog(NULL), eventSource(0) {}
+};
+
+// what the hero takes from one level to the next
+struct HeroState {
+    size_t depth;        // level the hero is on; 0 is the first
+    size_t turns;        // turns played on every level so far
+    size_t levelTurns;   // turns played on this level
+
+    HeroState() : depth(0), turns(0), levelTurns(0) {}
+};
+
+//---------------------------------------------------------------------------------
+// size_t levelBytes(size_t rows, size_t cols, size_t undoTurns, size_t undoChanges)
+//
+// About how much memory a dense rows x cols board takes: per cell a cell pointer,
+// the occupancy and change maps and a 32-byte MoveTables entry, plus the undo
+// history (see GameBoardBase::setUndoLimit()). The hero and baddies are too few to
+// count.
+//---------------------------------------------------------------------------------
+inline size_t levelBytes(size_t rows, size_t cols, size_t undoTurns, size_t undoChanges) {
+    return rows * cols * (sizeof(BoardCell*) + 2 + 32) + undoTurns * 64 + undoChanges * 4;
+}
+
+class Dungeon {
+    private:
+        struct Level {
+            size_t depth;
+            unique_ptr<GameBoardBase> board;
+        };
+
+        DungeonConfig config;
+        size_t bytesPerLevel;
+
+        // shared with the background thread
+        mutex lock;
+        condition_variable wake;        // room in the queue, something to free, or stopping
+        condition_variable levelReady;  // a level was queued, or making one failed
+        deque<Level> queued;            // finished levels, shallowest first
+        vector< unique_ptr<GameBoardBase> > retired;  // evicted boards for the background thread to free
+        size_t nextDepth;               // the next level to make
+        int nextSeed;                   // the next seed setupBoard() tries
+        string failure;                 // what went wrong making a level, if anything did
+        bool stopping;
+        thread maker;
+
+        // only touched by the caller's thread
+        Level current;
+        deque<Level> past;              // levels left behind, oldest first
+        HeroState hero;
+        LogHistogram transitions;       // microseconds every descend() took
+        size_t stalls;                  // descend() calls that waited for a level to be made
+        size_t evictions;
+
+        bool moreToMake() const {
+            return config.numLevels == 0 || nextDepth < config.numLevels;
+        }
+
+        int monstersAt(size_t depth) const {
+            int monsters = config.monsters;
+            for (size_t d = 0; d < depth && monsters < 30; d++) {
+                if (!validGameParameters(config.rows, config.cols, config.abysses, monsters + config.monstersPerLevel, config.bats)) {
+                    break;
+                }
+                monsters += config.monstersPerLevel;
+            }
+            return monsters;
+        }
+
+        // makes level depth; seed is where setupBoard() starts trying and is left past the seed used
+        GameBoardBase* makeLevel(size_t depth, int& seed) const {
+            unique_ptr<GameBoardBase> board(makeGameBoard(config.rows, config.cols));
+            board->setVerbose(config.verbose);
+            board->setEventLog(config.eventLog, config.eventSource);
+            board->setCollisionPolicy(config.collisionPolicy);
+            board->setFogOfWar(config.fogRadius);
+            board->setTrackThreats(config.trackThreats);
+            board->setUndoLimit(config.undoTurns, config.undoChanges);
+            if (config.library != NULL) {
+                config.library->loadInto(depth % config.library->size(), *board);
+                return board.release();
+            }
+            board->setNumAbysses(config.abysses);
+            board->setNumMonsters(monstersAt(depth));
+            board->setNumBats(config.bats);
+            vector<unsigned char> tiles((size_t)config.rows * config.cols);
+            for (int attempt = 0; attempt < 1000; attempt++) {
+                board->setupBoard(seed++);
+                board->getTiles(&tiles[0]);
+                LevelInfo info;
+                analyzeLevel(&tiles[0], config.rows, config.cols, info);
+                if (info.escapeDistance != kUnreachable) {
+                    return board.release();
+                }
+            }
+            throw runtime_error("Dungeon makeLevel -> no seed gave a level the hero can escape");
+        }
+
+        // Body of the background thread: keeps the queue topped up to lookahead levels
+        // and frees retired boards, until stopped.
+        void makerLoop() {
+            // the lowest priority: waking it up does not take the core from the hero's turn,
+            // and it still gets a share of a busy core
+            setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+
+            unique_lock<mutex> guard(lock);
+            while (true) {
+                while (!stopping && retired.empty() && (queued.size() >= config.lookahead || !moreToMake() || !failure.empty())) {
+                    wake.wait(guard);
+                }
+                if (stopping) {
+                    return;
+                }
+                if (!retired.empty()) {
+                    vector< unique_ptr<GameBoardBase> > dead;
+                    dead.swap(retired);
+                    guard.unlock();
+                    dead.clear();
+                    guard.lock();
+                    continue;
+                }
+                Level level;
+                level.depth = nextDepth;
+                int seed = nextSeed;
+                guard.unlock();
+                string error;
+                try {
+                    level.board.reset(makeLevel(level.depth, seed));
+                }
+                catch (const exception& e) {
+                    error = e.what();
+                }
+                guard.lock();
+                if (error.empty()) {
+                    nextDepth++;
+                    nextSeed = seed;
+                    queued.push_back(move(level));
+                }
+                else {
+                    failure = error;
+                }
+                levelReady.notify_all();
+            }
+        }
+
+        // waits for the next level and makes it the current one; false if there is none
+        bool takeNextLevel() {
+            unique_lock<mutex> guard(lock);
+            if (queued.empty() && !moreToMake()) {
+                return false;
+            }
+            if (queued.empty()) {
+                stalls++;
+            }
+            while (queued.empty() && failure.empty()) {
+                levelReady.wait(guard);
+            }
+            if (queued.empty()) {
+                throw runtime_error("Dungeon -> " + failure);
+            }
+            if (current.board) {
+                past.push_back(move(current));
+            }
+            current = move(queued.front());
+            queued.pop_front();
+            evictPastLevels();
+            guard.unlock();
+            wake.notify_one();
+            return true;
+        }
+
+        // hands the oldest past levels to the background thread until everything fits the
+        // budget; called with lock held
+        void evictPastLevels() {
+            size_t resident = (past.size() + 1 + config.lookahead) * bytesPerLevel;
+            while (!past.empty() && resident > config.budgetBytes) {
+                retired.push_back(move(past.front().board));
+                past.pop_front();
+                resident -= bytesPerLevel;
+                evictions++;
+            }
+        }
+
+    public:
+        /* param constructor -> starts making levels and waits for the first one */
+        explicit Dungeon(const DungeonConfig& dungeonConfig)
+            : config(dungeonConfig), nextDepth(0), nextSeed(dungeonConfig.seed), stopping(false), stalls(0), evictions(0) {
+            if (config.library != NULL) {
+                if (config.library->size() == 0) {
+                    throw invalid_argument("Dungeon constructor -> the level library is empty");
+                }
+                config.rows = config.library->numRows();
+                config.cols = config.library->numCols();
+            }
+            if (config.lookahead == 0) {
+                config.lookahead = 1;
+            }
+            bytesPerLevel = levelBytes(config.rows, config.cols, config.undoTurns, config.undoChanges);
+            maker = thread(&Dungeon::makerLoop, this);
+            try {
+                takeNextLevel();
+            }
+            catch (...) {
+                stop();
+                throw;
+            }
+            stalls = 0;  // waiting for the first level is not a transition
+        }
+
+        /* destructor -> stops the background thread; every level is freed with the dungeon */
+        virtual ~Dungeon() {
+            stop();
+        }
+
+        void stop() {
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            if (maker.joinable()) {
+                maker.join();
+            }
+        }
+
+        // the level the hero is on
+        GameBoardBase& board() {
+            return *current.board;
+        }
+
+        const HeroState& heroState() const {
+            return hero;
+        }
+
+        // plays one turn on the current level, counting it for the hero; same result as makeMoves()
+        bool makeMoves(char move) {
+            hero.turns++;
+            hero.levelTurns++;
+            return current.board->makeMoves(move);
+        }
+
+        // takes back up to turns turns on the current level, uncounting them for the hero;
+        // same result as rewind()
+        size_t rewind(size_t turns) {
+            size_t undone = current.board->rewind(turns);
+            hero.turns -= undone;
+            hero.levelTurns -= undone;
+            return undone;
+        }
+
+        // true once the hero escaped the last level
+        bool cleared() {
+            return current.board->getOutcome() == OutcomeEscaped && config.numLevels > 0 && hero.depth + 1 >= config.numLevels;
+        }
+
+        //---------------------------------------------------------------------------------
+        // bool descend()
+        //
+        // Takes the hero down the ladder of the current level, which it has to have just
+        // escaped, to the next level. Returns false if there is no next level (the last
+        // one was escaped) and leaves the current level as it is.
+        //---------------------------------------------------------------------------------
+        bool descend() {
+            if (current.board->getOutcome() != OutcomeEscaped) {
+                throw logic_error("Dungeon descend -> the hero has not escaped this level");
+            }
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            if (!takeNextLevel()) {
+                return false;
+            }
+            hero.depth = current.depth;
+            hero.levelTurns = 0;
+            transitions.add(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+            return true;
+        }
+
+        // a level the hero has left, or NULL if it was evicted (or not played yet)
+        GameBoardBase* pastLevel(size_t depth) {
+            for (size_t i = 0; i < past.size(); i++) {
+                if (past[i].depth == depth) {
+                    return past[i].board.get();
+                }
+            }
+            return NULL;
+        }
+
+        // microseconds every descend() took
+        const LogHistogram& transitionMicros() const {
+            return transitions;
+        }
+
+        // descend() calls that had to wait for the level to be made
+        size_t getStalls() const {
+            return stalls;
+        }
+
+        size_t getEvictions() const {
+            return evictions;
+        }
+
+        // levels in memory: past, current and (at most lookahead) queued
+        size_t residentLevels() {
+            lock_guard<mutex> guard(lock);
+            return past.size() + 1 + queued.size();
+        }
+
+        // what residentLevels() take, as estimated by levelBytes()
+        size_t residentBytes() {
+            return residentLevels() * bytesPerLevel;
+        }
+
+        size_t getLevelBytes() const {
+            return bytesPerLevel;
+        }
+
+    private:
+        Dungeon(const Dungeon&);
+        Dungeon& operator=(const Dungeon&);
+};
+
+#endif //_DUNGEON_H
@@ -0,0 +1,132 @@
+/*
+    Filename: "envbench.cpp"
+    Author: Viraj Saudagar
+
+    Throughput benchmark for VecEnv. Steps a batch of boards with random
+    actions and reports env-steps per second, games finished, and how many
+    heap allocations step() made once the boards had warmed up (operator
+    new is counted for that, which is why this is its own program).
+
+    --trace and --perf-markers record TraceSpans (see tracing.h) during the
+    timed steps and write them out at the end.
+
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <new>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+#include "vecenv.h"
+#include "gamerng.h"
+
+static atomic<unsigned long long> allocations(0);
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == NULL) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+// kept out of line so g++ does not pair the free() with new expressions (-Wmismatched-new-delete)
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+int main(int argc, char* argv[]) {
+
+    VecEnvConfig config;
+    size_t numEnvs = 1024;
+    size_t numSteps = 2000;
+    size_t warmup = 200;
+    string tracePath, markersPath;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--envs" && hasValue)            numEnvs = max(1, atoi(argv[++i]));
+        else if (arg == "--steps" && hasValue)      numSteps = max(1, atoi(argv[++i]));
+        else if (arg == "--warmup" && hasValue)     warmup = atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)    config.threads = atoi(argv[++i]);
+        else if (arg == "--rows" && hasValue)       config.rows = atoi(argv[++i]);
+        else if (arg == "--cols" && hasValue)       config.cols = atoi(argv[++i]);
+        else if (arg == "--abysses" && hasValue)    config.abysses = atoi(argv[++i]);
+        else if (arg == "--monsters" && hasValue)   config.monsters = atoi(argv[++i]);
+        else if (arg == "--bats" && hasValue)       config.bats = atoi(argv[++i]);
+        else if (arg == "--max-steps" && hasValue)  config.maxSteps = atoi(argv[++i]);
+        else if (arg == "--fog" && hasValue)        config.fogRadius = atoi(argv[++i]);
+        else if (arg == "--trace" && hasValue)      tracePath = argv[++i];
+        else if (arg == "--perf-markers" && hasValue) markersPath = argv[++i];
+        else {
+            cout << "usage: " << argv[0] << " [--envs n] [--steps n] [--warmup n] [--threads n]" << endl;
+            cout << "       [--rows n] [--cols n] [--abysses n] [--monsters n] [--bats n] [--max-steps n] [--fog radius]" << endl;
+            cout << "       [--trace chrome.json] [--perf-markers markers.txt]" << endl;
+            return 1;
+        }
+    }
+
+    VecEnv env(numEnvs, config);
+    vector<int> seeds(numEnvs);
+    for (size_t i = 0; i < numEnvs; i++) {
+        seeds[i] = i + 1;
+    }
+    env.reset(&seeds[0]);
+
+    // actions for every step are drawn up front so the timed loop only steps
+    GameRng rng(7);
+    vector<unsigned char> actions((warmup + numSteps) * numEnvs);
+    for (size_t i = 0; i < actions.size(); i++) {
+        actions[i] = rng() % kVecEnvNumActions;
+    }
+
+    // tracing during warmup too, so every thread has its trace buffer before the count starts
+    bool tracing = !tracePath.empty() || !markersPath.empty();
+    setTracing(tracing);
+    for (size_t s = 0; s < warmup; s++) {
+        env.step(&actions[s * numEnvs]);
+    }
+    clearTrace();
+
+    unsigned long long allocationsBefore = allocations;
+    size_t gamesFinished = 0;
+    double totalReward = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t s = warmup; s < warmup + numSteps; s++) {
+        env.step(&actions[s * numEnvs]);
+        for (size_t i = 0; i < numEnvs; i++) {
+            gamesFinished += env.dones()[i];
+            totalReward += env.rewards()[i];
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    unsigned long long stepAllocations = allocations - allocationsBefore;
+    setTracing(false);
+
+    double envSteps = (double)numEnvs * numSteps;
+    cout << numEnvs << " boards (" << config.rows << "x" << config.cols << ") on " << env.numThreads() << " threads" << endl;
+    cout << "env-steps/s:        " << (long long)(envSteps / seconds) << " (" << numSteps << " steps in " << seconds << " s)" << endl;
+    cout << "games finished:     " << gamesFinished << ", mean reward per step " << totalReward / envSteps << endl;
+    cout << "allocations/step:   " << stepAllocations / (double)numSteps << endl;
+    if (tracing) {
+        if (!saveTrace(tracePath, markersPath)) {
+            cout << "could not write the trace" << endl;
+            return 1;
+        }
+        cout << "trace written, " << traceDropped() << " spans dropped" << endl;
+    }
+
+    return 0;
+
+} // main
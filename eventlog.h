@@ -0,0 +1,387 @@
+/*
+    Filename: "eventlog.h"
+    Author: Viraj Saudagar
+
+    This file defines EventLog, where boards report what happens during a
+    turn without waiting on any I/O. A board with a log attached (see
+    setEventLog()) pushes a GameEvent for every
+
+        clamp        a move that would have left the board
+        deflect      a move stopped by a wall (or, for baddies, the ladder)
+        abyss        the hero or a baddie falling into an abyss
+        collision    a baddie moving onto another baddie
+        capture      a baddie catching the hero, or the hero running into one
+        escape       the hero reaching the ladder
+
+    Pushing is a few atomic operations on a fixed ring, safe from any number
+    of threads. One background writer thread, started with start(), drains
+    the ring into an EventSink:
+
+        TextEventSink     the game's diagnostic messages, one line each
+        BinaryEventSink   every GameEvent as it is in memory, for tools
+
+    The level (LogOutcomes or LogAll) can be changed while the game runs;
+    events below it are never pushed. When the ring is full the event is
+    dropped and counted instead of waiting, and the writer tells the sink
+    how many were lost. flush() waits until everything pushed so far has
+    been written, e.g. before drawing the board underneath the messages.
+
+*/
+
+#ifndef _EVENTLOG_H
+#define _EVENTLOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <ostream>
+#include <stdexcept>
+
+#include "tiles.h"
+#include "movetables.h"
+
+using namespace std;
+
+enum GameEventType {
+    EventClamp = 0,
+    EventDeflect = 1,
+    EventAbyss = 2,
+    EventCollision = 3,
+    EventCapture = 4,
+    EventEscape = 5,
+    NumGameEventTypes = 6
+};
+
+enum EventLevel {
+    LogOff = 0,
+    LogOutcomes = 1,  // abyss, capture and escape: events that end a life or the game
+    LogAll = 2        // everything, including clamps, deflections and collisions
+};
+
+static const char* const kEventLevelNames[3] = {"off", "outcomes", "all"};
+
+// looks a level up by name ("off", "outcomes", "all"); returns false if there is none
+inline bool eventLevelOfName(const string& name, EventLevel& level) {
+    for (int i = 0; i <= LogAll; i++) {
+        if (name == kEventLevelNames[i]) {
+            level = (EventLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// the lowest level that logs events of this type
+inline EventLevel levelOfEvent(GameEventType type) {
+    return (type == EventAbyss || type == EventCapture || type == EventEscape) ? LogOutcomes : LogAll;
+}
+
+struct GameEvent {
+    unsigned source;      // which board, as given to setEventLog()
+    unsigned row, col;    // where the mover started
+    unsigned char type;   // GameEventType
+    unsigned char actor;  // TileHero or the baddie's tile
+    unsigned char move;   // the MoveEntryBits of the move, for clamps and deflections
+};
+
+//---------------------------------------------------------------------------------
+// class EventSink
+//
+// Where the writer thread puts events. Only the writer thread calls it.
+//---------------------------------------------------------------------------------
+class EventSink {
+    public:
+        virtual ~EventSink() {}
+
+        virtual void write(const GameEvent* events, size_t count) = 0;
+
+        // count events were dropped because the ring was full
+        virtual void dropped(size_t count) = 0;
+
+        // called when the ring has been drained
+        virtual void flush() = 0;
+};
+
+// The messages the board used to print itself, one line per event.
+class TextEventSink : public EventSink {
+    private:
+        ostream& out;
+        string text;
+
+        void add(const GameEvent& e) {
+            const char* who = (e.actor == TileHero) ? "Hero" : "Baddie";
+            switch (e.type) {
+                case EventClamp:
+                    if (e.move & MoveRowClamped) {
+                        text += who;
+                        text += " trying to move out-of-bounds with an invalid row\n";
+                        text += "Changing row for ";
+                        text += who;
+                        text += " position to stay in-bounds\n";
+                    }
+                    if (e.move & MoveColClamped) {
+                        text += who;
+                        text += " trying to move out-of-bounds with an invalid column\n";
+                    }
+                    break;
+                case EventDeflect:
+                    if (e.actor == TileHero) {
+                        text += "Hero is trying to move on a Wall cell\n";
+                        text += "Changing Row and/or Column for Hero position to avoid wall\n";
+                    }
+                    else {
+                        text += "Baddie is trying to move on a Wall cell or Escape Cell\n";
+                        text += "Changing Row and/or Column for Baddie position to avoid wall or escape cell\n";
+                    }
+                    break;
+                case EventAbyss:
+                    text += who;
+                    text += " is trying to move on a abyss cell\n";
+                    break;
+                case EventCollision:
+                    text += "Baddie is trying to move on another baddie\n";
+                    break;
+                case EventCapture:
+                    text += (e.actor == TileHero) ? "Hero is trying to move on a baddie cell\n"
+                                                  : "Baddie is trying to move on the hero cell\n";
+                    break;
+                case EventEscape:
+                    text += "Hero is trying to escape\n";
+                    break;
+                default:
+                    break;
+            }
+        }
+
+    public:
+        explicit TextEventSink(ostream& stream) : out(stream) {}
+
+        virtual void write(const GameEvent* events, size_t count) {
+            text.clear();
+            for (size_t i = 0; i < count; i++) {
+                add(events[i]);
+            }
+            out << text;
+        }
+
+        virtual void dropped(size_t count) {
+            out << "(" << count << " game events dropped, the event log was full)\n";
+        }
+
+        virtual void flush() {
+            out.flush();
+        }
+};
+
+// Every GameEvent exactly as it is in memory, for tools on the same machine to read back.
+// A run of dropped events is written as an event with type NumGameEventTypes and the
+// number dropped in source.
+class BinaryEventSink : public EventSink {
+    private:
+        ostream& out;
+
+    public:
+        explicit BinaryEventSink(ostream& stream) : out(stream) {}
+
+        virtual void write(const GameEvent* events, size_t count) {
+            out.write((const char*)events, count * sizeof(GameEvent));
+        }
+
+        virtual void dropped(size_t count) {
+            GameEvent e = GameEvent();
+            e.type = NumGameEventTypes;
+            e.source = (unsigned)count;
+            out.write((const char*)&e, sizeof(e));
+        }
+
+        virtual void flush() {
+            out.flush();
+        }
+};
+
+//---------------------------------------------------------------------------------
+// class EventLog
+//
+// A bounded ring every thread can push into without a lock (each slot carries a
+// sequence number that says whether it is free, being filled or ready), drained in
+// order by one writer thread.
+//---------------------------------------------------------------------------------
+class EventLog {
+    private:
+        struct Slot {
+            atomic<size_t> sequence;  // == position: free; == position + 1: ready to write
+            GameEvent event;
+        };
+
+        unique_ptr<Slot[]> slots;
+        size_t mask;                  // capacity - 1
+        atomic<size_t> tail;          // next position to push
+        atomic<size_t> head;          // next position to drain; only the writer moves it
+        atomic<size_t> written;       // events handed to the sink so far
+        atomic<size_t> droppedCount;  // events that found the ring full
+        atomic<int> minimumLevel;
+        atomic<bool> stopping;
+        EventSink* sink;
+        thread writer;
+
+        // moves what is ready into batch and frees the slots; false if nothing was
+        bool drain(vector<GameEvent>& batch) {
+            batch.clear();
+            size_t pos = head.load(memory_order_relaxed);
+            while (batch.size() < batch.capacity()) {
+                Slot& slot = slots[pos & mask];
+                if (slot.sequence.load(memory_order_acquire) != pos + 1) {
+                    break;
+                }
+                batch.push_back(slot.event);
+                slot.sequence.store(pos + mask + 1, memory_order_release);
+                pos++;
+            }
+            if (batch.empty()) {
+                return false;
+            }
+            head.store(pos, memory_order_release);
+            return true;
+        }
+
+        // writes one batch; false if there was nothing to write
+        bool writeBatch(vector<GameEvent>& batch, size_t& droppedReported) {
+            bool any = drain(batch);
+            if (any) {
+                sink->write(&batch[0], batch.size());
+                written.store(head.load(memory_order_relaxed), memory_order_release);
+            }
+            size_t lost = droppedCount.load(memory_order_relaxed);
+            if (lost != droppedReported) {
+                sink->dropped(lost - droppedReported);
+                droppedReported = lost;
+            }
+            return any;
+        }
+
+        void writerLoop() {
+            vector<GameEvent> batch;
+            batch.reserve(1024);
+            size_t droppedReported = droppedCount.load(memory_order_relaxed);
+            bool unflushed = false;
+            while (true) {
+                if (writeBatch(batch, droppedReported)) {
+                    unflushed = true;
+                    continue;
+                }
+                if (unflushed) {
+                    sink->flush();
+                    unflushed = false;
+                }
+                if (stopping.load(memory_order_acquire)) {
+                    // one more pass for anything pushed before stop() was called
+                    while (writeBatch(batch, droppedReported)) {}
+                    sink->flush();
+                    return;
+                }
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        }
+
+    public:
+        // capacity is rounded up to a power of two
+        explicit EventLog(size_t capacity = 1 << 14, EventLevel level = LogAll)
+            : tail(0), head(0), written(0), droppedCount(0), minimumLevel(level), stopping(false), sink(NULL) {
+            size_t size = 2;
+            while (size < capacity) {
+                size *= 2;
+            }
+            slots.reset(new Slot[size]);
+            mask = size - 1;
+            for (size_t i = 0; i < size; i++) {
+                slots[i].sequence.store(i, memory_order_relaxed);
+            }
+        }
+
+        ~EventLog() {
+            stop();
+        }
+
+        // starts the writer thread draining into eventSink, which must outlive stop()
+        void start(EventSink* eventSink) {
+            if (writer.joinable()) {
+                throw logic_error("EventLog start -> the writer is already running");
+            }
+            sink = eventSink;
+            stopping.store(false, memory_order_relaxed);
+            writer = thread(&EventLog::writerLoop, this);
+        }
+
+        // writes everything pushed so far and ends the writer thread
+        void stop() {
+            if (writer.joinable()) {
+                stopping.store(true, memory_order_release);
+                writer.join();
+            }
+        }
+
+        // waits until every event pushed before the call has been written
+        void flush() {
+            if (!writer.joinable()) {
+                return;
+            }
+            size_t target = tail.load(memory_order_acquire);
+            while (written.load(memory_order_acquire) < target) {
+                this_thread::sleep_for(chrono::microseconds(100));
+            }
+        }
+
+        void setLevel(EventLevel level) {
+            minimumLevel.store(level, memory_order_relaxed);
+        }
+
+        EventLevel getLevel() const {
+            return (EventLevel)minimumLevel.load(memory_order_relaxed);
+        }
+
+        // true if events of this type are logged at the current level
+        bool wants(GameEventType type) const {
+            return levelOfEvent(type) <= minimumLevel.load(memory_order_relaxed);
+        }
+
+        // queues e for the writer; never blocks, returns false (and counts it) if the ring is full
+        bool push(const GameEvent& e) {
+            size_t pos = tail.load(memory_order_relaxed);
+            Slot* slot;
+            while (true) {
+                slot = &slots[pos & mask];
+                size_t sequence = slot->sequence.load(memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0) {
+                    if (tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (diff < 0) {
+                    droppedCount.fetch_add(1, memory_order_relaxed);
+                    return false;
+                }
+                else {
+                    pos = tail.load(memory_order_relaxed);
+                }
+            }
+            slot->event = e;
+            slot->sequence.store(pos + 1, memory_order_release);
+            return true;
+        }
+
+        // events lost to a full ring since the log was made
+        size_t dropped() const {
+            return droppedCount.load(memory_order_relaxed);
+        }
+
+    private:
+        EventLog(const EventLog&);
+        EventLog& operator=(const EventLog&);
+};
+
+#endif //_EVENTLOG_H
@@ -0,0 +1,293 @@
+/*
+    Filename: "fieldofview.h"
+    Author: Viraj Saudagar
+
+    This file defines FieldOfView, what the hero can see in fog-of-war
+    mode: every cell within a radius of the hero (as the crow flies) that
+    no Wall hides from it. Walls themselves are seen, and so is everything
+    else that is not behind one; only walls block the view.
+
+    Visibility is worked out with recursive shadowcasting. Each of the 8
+    octants around the hero is scanned row by row moving outwards, keeping
+    the range of slopes still in view; a wall narrows that range and starts
+    a scan of the part beyond it. Every cell in the radius is looked at
+    once at most, so the cost depends on the radius and not on the size of
+    the board.
+
+    The result is a VisibilityMap, a bitset over the square around the hero
+    (one 64-bit word per 64 columns of it), which the board reads directly
+    when it renders or writes an observation. Walls only change when a
+    baddie runs into one, so maps are cached by the hero's cell: walking
+    back and forth, or standing still, reuses the map worked out the first
+    time. wallsChanged() invalidates every cached map at once.
+
+*/
+
+#ifndef _FIELDOFVIEW_H
+#define _FIELDOFVIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "tracing.h"
+
+using namespace std;
+
+// observation code (see GameBoardBase::getObservation()) and display character of a
+// cell the hero cannot see; the code still fits in 4 bits next to the TileTypes
+static const unsigned char kHiddenTile = 8;
+static const char kHiddenGlyph = '.';
+
+//---------------------------------------------------------------------------------
+// class VisibilityMap
+//
+// The cells seen from one cell: a bitset over the height x width rectangle whose top
+// left cell is (top, left), row after row, each row starting on a new word. Every
+// cell outside the rectangle is hidden.
+//---------------------------------------------------------------------------------
+class VisibilityMap {
+    private:
+        size_t top, left, height, width;
+        size_t wordsPerRow;
+        vector<uint64_t> bits;
+
+    public:
+        VisibilityMap() : top(0), left(0), height(0), width(0), wordsPerRow(0) {}
+
+        // hides everything and makes the rectangle height x width at (top, left)
+        void reset(size_t newTop, size_t newLeft, size_t newHeight, size_t newWidth) {
+            top = newTop;
+            left = newLeft;
+            height = newHeight;
+            width = newWidth;
+            wordsPerRow = (width + 63) / 64;
+            bits.assign(height * wordsPerRow, 0);
+        }
+
+        // makes room for a height x width rectangle, so reset() to one no bigger does not allocate
+        void reserve(size_t maxHeight, size_t maxWidth) {
+            bits.reserve(maxHeight * ((maxWidth + 63) / 64));
+        }
+
+        // marks (r, c), which must be inside the rectangle, as seen
+        void show(size_t r, size_t c) {
+            size_t j = c - left;
+            bits[(r - top) * wordsPerRow + j / 64] |= (uint64_t)1 << (j % 64);
+        }
+
+        bool visible(size_t r, size_t c) const {
+            size_t i = r - top;
+            size_t j = c - left;
+            if (i >= height || j >= width) {
+                return false;
+            }
+            return (bits[i * wordsPerRow + j / 64] >> (j % 64)) & 1;
+        }
+
+        size_t getTop() const {
+            return top;
+        }
+
+        size_t getLeft() const {
+            return left;
+        }
+
+        size_t getHeight() const {
+            return height;
+        }
+
+        size_t getWidth() const {
+            return width;
+        }
+
+        // the words of row top + i; bit j % 64 of word j / 64 is column left + j
+        const uint64_t* rowBits(size_t i) const {
+            return &bits[i * wordsPerRow];
+        }
+
+        // number of cells seen
+        size_t count() const {
+            size_t n = 0;
+            for (size_t i = 0; i < bits.size(); i++) {
+                n += __builtin_popcountll(bits[i]);
+            }
+            return n;
+        }
+};
+
+//---------------------------------------------------------------------------------
+// class FieldOfView
+//
+// Works out and caches VisibilityMaps for a rows x cols board. The board hands in
+// something that tells walls apart (see visibleFrom()), so this knows nothing about
+// how the board stores its tiles.
+//---------------------------------------------------------------------------------
+class FieldOfView {
+    private:
+        static const size_t CacheSize = 64;               // maps kept, one per slot of hero cells
+        static const size_t MaxReservedCells = 1 << 18;   // bigger maps are only allocated when used
+
+        struct CacheEntry {
+            size_t cell;          // r * cols + c the map was worked out from
+            unsigned generation;  // stale unless this equals FieldOfView::generation
+            VisibilityMap map;
+        };
+
+        size_t rows, cols;
+        size_t radius;                        // 0 = fog of war is off
+        unsigned generation;                  // starts at 1; 0 marks an entry stale for good
+        vector<CacheEntry> cache;
+        VisibilityMap nothing;                // what is seen from off the board
+
+        // the cell (r0 + dy * yy + dx * yx, c0 + dy * xy + dx * xx), or false if off the board
+        static bool cellOf(size_t r0, size_t c0, long dx, long dy, int xx, int xy, int yx, int yy,
+                           size_t numRows, size_t numCols, size_t& r, size_t& c) {
+            r = r0 + dx * yx + dy * yy;
+            c = c0 + dx * xx + dy * xy;
+            return r < numRows && c < numCols;
+        }
+
+        //---------------------------------------------------------------------------------
+        // One octant, from distance row outwards, seeing the slopes from start down to end.
+        // (xx, xy, yx, yy) turn the octant's own coordinates (dx along a row, dy outwards)
+        // into the board's. Cells off the board block the view like walls.
+        //---------------------------------------------------------------------------------
+        template<typename IsWall>
+        void castLight(const IsWall& isWall, VisibilityMap& map, size_t r0, size_t c0, long row,
+                       double start, double end, int xx, int xy, int yx, int yy) const {
+            if (start < end) {
+                return;
+            }
+            long reach = (long)radius;
+            long reach2 = reach * reach;
+            double nextStart = start;
+            for (long j = row; j <= reach; j++) {
+                long dy = -j;
+                bool blocked = false;
+                for (long dx = -j; dx <= 0; dx++) {
+                    double leftSlope = (dx - 0.5) / (dy + 0.5);
+                    double rightSlope = (dx + 0.5) / (dy - 0.5);
+                    if (start < rightSlope) {
+                        continue;
+                    }
+                    if (end > leftSlope) {
+                        break;
+                    }
+                    size_t r, c;
+                    bool onBoard = cellOf(r0, c0, dx, dy, xx, xy, yx, yy, rows, cols, r, c);
+                    if (onBoard && dx * dx + dy * dy <= reach2) {
+                        map.show(r, c);
+                    }
+                    bool wall = !onBoard || isWall(r, c);
+                    if (blocked) {
+                        if (wall) {
+                            nextStart = rightSlope;
+                            continue;
+                        }
+                        blocked = false;
+                        start = nextStart;
+                    }
+                    else if (wall && j < reach) {
+                        blocked = true;
+                        castLight(isWall, map, r0, c0, j + 1, start, leftSlope, xx, xy, yx, yy);
+                        nextStart = rightSlope;
+                    }
+                }
+                if (blocked) {
+                    break;
+                }
+            }
+        }
+
+        template<typename IsWall>
+        void compute(const IsWall& isWall, size_t r0, size_t c0, VisibilityMap& map) const {
+            TraceSpan span("fieldOfView");
+            size_t top = r0 >= radius ? r0 - radius : 0;
+            size_t left = c0 >= radius ? c0 - radius : 0;
+            size_t bottom = (rows - 1 - r0 >= radius) ? r0 + radius : rows - 1;
+            size_t right = (cols - 1 - c0 >= radius) ? c0 + radius : cols - 1;
+            map.reset(top, left, bottom - top + 1, right - left + 1);
+            map.show(r0, c0);
+            static const int mult[4][8] = {
+                {1, 0, 0, -1, -1, 0, 0, 1},
+                {0, 1, -1, 0, 0, -1, 1, 0},
+                {0, 1, 1, 0, 0, -1, -1, 0},
+                {1, 0, 0, 1, -1, 0, 0, -1}
+            };
+            for (int octant = 0; octant < 8; octant++) {
+                castLight(isWall, map, r0, c0, 1, 1.0, 0.0,
+                          mult[0][octant], mult[1][octant], mult[2][octant], mult[3][octant]);
+            }
+        }
+
+    public:
+        FieldOfView() : rows(0), cols(0), radius(0), generation(1) {}
+
+        // sizes the view for a rows x cols board and forgets every cached map
+        void resize(size_t numRows, size_t numCols) {
+            rows = numRows;
+            cols = numCols;
+            wallsChanged();
+        }
+
+        // cells further than radius from the hero are hidden; 0 turns fog of war off.
+        // Every cached map is sized for the radius here (unless that is huge), so looking
+        // things up does not allocate.
+        void setRadius(size_t newRadius) {
+            radius = newRadius;
+            if (radius > 0) {
+                size_t height = min(2 * radius + 1, rows);
+                size_t width = min(2 * radius + 1, cols);
+                cache.resize(CacheSize);
+                for (size_t i = 0; i < cache.size(); i++) {
+                    cache[i].generation = 0;
+                    if (height * width <= MaxReservedCells) {
+                        cache[i].map.reserve(height, width);
+                    }
+                }
+            }
+            wallsChanged();
+        }
+
+        size_t getRadius() const {
+            return radius;
+        }
+
+        // forgets every cached map, after a wall was put on or taken off the board
+        void wallsChanged() {
+            generation++;
+            if (generation == 0) {
+                // wrapped around: an old stamp could look current again
+                for (size_t i = 0; i < cache.size(); i++) {
+                    cache[i].generation = 0;
+                }
+                generation = 1;
+            }
+        }
+
+        //---------------------------------------------------------------------------------
+        // const VisibilityMap& visibleFrom(const IsWall& isWall, size_t r, size_t c)
+        //
+        // The cells seen from (r, c), where isWall(r, c) is true for the cells that block
+        // the view. Worked out only if it is not cached already; the map stays valid until
+        // the next call. Nothing is seen from off the board, or with fog of war off.
+        //---------------------------------------------------------------------------------
+        template<typename IsWall>
+        const VisibilityMap& visibleFrom(const IsWall& isWall, size_t r, size_t c) {
+            if (radius == 0 || r >= rows || c >= cols) {
+                return nothing;
+            }
+            size_t cell = r * cols + c;
+            CacheEntry& entry = cache[(cell * 0x9E3779B97F4A7C15ULL >> 32) % CacheSize];
+            if (entry.generation != generation || entry.cell != cell) {
+                compute(isWall, r, c, entry.map);
+                entry.cell = cell;
+                entry.generation = generation;
+            }
+            return entry.map;
+        }
+};
+
+#endif //_FIELDOFVIEW_H
@@ -0,0 +1,112 @@
+/*-------------------------------------------------
+FILE: fixedgrid.h
+
+AUTHOR: Viraj Saudagar
+
+DESCRIPTION:
+This class is a 2D grid whose dimensions are template
+parameters instead of constructor arguments. The
+elements live in a single std::array (row-major) inside
+the object, so there are no per-row heap allocations and
+numrows()/numcols() are compile-time constants. That lets
+the compiler fold the range checks in operator() and
+unroll loops that run over the whole grid.
+
+It offers the same interface as Grid so that GameBoard
+can be instantiated on either one.
+-------------------------------------------------*/
+
+#pragma once
+
+#include <array>
+#include <exception>
+#include <stdexcept>
+
+#include "grid.h"
+
+using namespace std;
+
+template<typename T, size_t R, size_t C>
+class FixedGrid {
+private:
+  static_assert(R > 0 && C > 0, "FixedGrid needs at least one row and one column");
+
+  array<T, R * C> Cells;  // all elements, row after row
+
+public:
+  // Default constructor -> every element is set to the default value of T.
+  FixedGrid() {
+    Cells.fill(T());
+  }
+
+  // Parameterized Constructor -> exists so FixedGrid can be used wherever a Grid
+  // is constructed; the requested size has to match the template dimensions.
+  FixedGrid(size_t r, size_t c) {
+    if (r != R || c != C) {
+      throw invalid_argument("FixedGrid Parameterized Constructor -> size does not match the template dimensions");
+    }
+    Cells.fill(T());
+  }
+
+  // Returns the number of rows in the grid.
+  static constexpr size_t numrows() {
+    return R;
+  }
+
+  // returns the number of columns in row r of the grid (every row has C).
+  static constexpr size_t numcols(size_t) {
+    return C;
+  }
+
+  // Returns the total number elements in the grid object.
+  static constexpr size_t size() {
+    return R * C;
+  }
+
+  typedef T* iterator;
+  typedef const T* const_iterator;
+
+  // Iterators over every element, row after row; the elements are contiguous, so
+  // these are plain pointers.
+  iterator begin() {
+    return Cells.data();
+  }
+
+  iterator end() {
+    return Cells.data() + R * C;
+  }
+
+  const_iterator begin() const {
+    return Cells.data();
+  }
+
+  const_iterator end() const {
+    return Cells.data() + R * C;
+  }
+
+  // Returns row r as a span of its C elements (see GridSpan in grid.h).
+  GridSpan<T> row(size_t r) {
+    if (r >= R) {
+      throw invalid_argument("FixedGrid row -> Invalid row argument provided");
+    }
+    return GridSpan<T>(&Cells[r * C], C);
+  }
+
+  GridSpan<const T> row(size_t r) const {
+    if (r >= R) {
+      throw invalid_argument("FixedGrid row -> Invalid row argument provided");
+    }
+    return GridSpan<const T>(&Cells[r * C], C);
+  }
+
+  // Parenthesis Operator overload -> returns a reference to the element at (r, c).
+  // Compares against constants, so the check disappears whenever the compiler can
+  // prove r and c are in range (e.g. inside loops over the whole grid).
+  T& operator()(size_t r, size_t c) {
+    if (r >= R || c >= C) {
+      throw invalid_argument("FixedGrid () operator overload -> Invalid row or column argument provided");
+    }
+    return Cells[r * C + c];
+  }
+
+};
@@ -7,6 +7,99 @@
     the functionality required to run the game and execute custom moves
     for the hero. 
 
+    The board is a template on the grid that stores the cells:
+      - GameBoard                is sized at runtime and stored in a Grid
+      - FixedGameBoard<R, C>     is sized at compile time and stored in a FixedGrid,
+                                 so range checks fold away and board loops can unroll
+    makeGameBoard() picks the fixed size when one matches and falls back to
+    GameBoard otherwise; callers that do not care which one they got use it
+    through the GameBoardBase interface.
+
+    Alongside the cells every board keeps an occupancy map: the TileType of
+    each cell, updated by the same helpers that write cells. Move checks read
+    the map instead of calling through the cells, and a baddie stepping onto
+    another baddie is found in O(1) and resolved by the CollisionPolicy:
+      - CollisionLegacy   the mover replaces the other baddie (the old behavior)
+      - CollisionBlock    the mover stays where it is
+      - CollisionSwap     the two baddies trade places
+      - CollisionMerge    the two become one Super Monster on the target cell
+
+    With setUndoLimit() the same helpers keep a bounded history of the last
+    turns (every tile a turn changed, plus the hero and the game result as
+    they were before it), and rewind(k) takes back the last k turns in time
+    proportional to what they changed.
+
+    With setTrackChanges(true) the same helpers also record which cells
+    changed tile, so takeChangedCells() costs time in proportion to what
+    happened during the turn rather than to the size of the board.
+
+    Setup, the phases of a turn and every baddie's move are timed with
+    TraceSpans (see tracing.h), which cost next to nothing until tracing is
+    turned on.
+
+    A verbose board reports clamps, deflections, collisions, captures and
+    escapes as GameEvents to the EventLog given to setEventLog() (see
+    eventlog.h); a background thread writes them out, so a turn never
+    waits on the terminal or a file.
+
+    renderTo(), renderRow() and renderViewport() draw the board into a
+    buffer the caller owns, straight from the occupancy map: one table
+    lookup per cell, no iostreams and no virtual call per cell. display()
+    is built on top of them.
+
+    Where a hero or baddie move ends up against the edges, walls, ladder and
+    abysses is read from MoveTables (see movetables.h), which caches the
+    resolved moves of every cell and forgets only the cells around a wall or
+    ladder that a baddie removes.
+
+    Empty and terrain squares carry no state, so they all point at one
+    shared cell per tile and only the hero and baddies are allocated. Many
+    boards can play the same level off one Terrain (see terrain.h), sharing
+    its layout and fully resolved move tables.
+
+    SparseGameBoard keeps its cells and occupancy map in ChunkedGrids (see
+    chunkedgrid.h), so a world of a million by a million squares costs
+    memory only where something is. Nothing a turn does scans the board:
+    the hero's cell and the baddies' cells are tracked as tiles are put,
+    and the baddies move in the same row-major order a scan would visit
+    them in. Such a world is set up with setupFromPlacements(), which lists
+    only what is on it; makeGameBoard() picks SparseGameBoard for boards
+    of more than kSparseBoardCells squares.
+
+    With setFogOfWar(radius) the hero only sees the cells within radius
+    that no wall hides (see fieldofview.h). The renderers draw every other
+    cell as kHiddenGlyph and getObservation() writes kHiddenTile for it;
+    getTiles() still writes the whole board. What the hero sees is cached
+    per hero cell until a wall changes, so a turn costs at most one
+    shadowcast over the radius, whatever the size of the board.
+
+    With setTrackThreats(true) the board keeps a ThreatMap (see
+    threatmap.h) of the cells where the hero would be caught once the
+    baddies have moved. put() updates it for every baddie that moves, is
+    put or is taken off, and for the monsters next to a wall or abyss that
+    changes, so keeping it costs a few move table lookups per baddie move
+    and reading it is one bit test per cell.
+
+    With setMultiHero(true) a board holds any number of heroes, each with
+    an id (row after row as they were set up, then in the order addHero()
+    put them on). makeTick() plays a round for all of them at once: every
+    hero makes its move, then every baddie moves once towards the hero
+    nearest to it, found through a HeroIndex (see heroindex.h) instead of
+    by looking at every hero. A round costs time in proportion to the
+    heroes and baddies on the board, not to their product. Fog of war, the
+    threat map and undo follow a single hero and are not offered then.
+
+    With setActionSchedule() entities act at their own pace instead of
+    every baddie once per hero move: time runs in beats, the hero moves
+    every schedule.hero beats and each kind of baddie every so many beats
+    of its own, so bats can fly several times per hero move and monsters
+    can lag behind. Awake baddies wait on a TimingWheel (see
+    timingwheel.h) for the beat they act next, so a beat only touches the
+    baddies due on it. With a wake radius, baddies start out asleep in
+    buckets of the board and wake for good once a hero comes within the
+    radius; only the buckets around the heroes are looked at, so a
+    sleeping population costs nothing per turn however large it is.
+
 */
 
 #ifndef _GAMEBOARD_H
@@ -17,17 +110,319 @@
 #include <string>
 #include <ctime>
 #include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
 
 #include "boardcell.h"
 #include "grid.h"
+#include "fixedgrid.h"
+#include "chunkedgrid.h"
+#include "gamerng.h"
+#include "tiles.h"
+#include "movetables.h"
+#include "terrain.h"
+#include "tracing.h"
+#include "eventlog.h"
+#include "fieldofview.h"
+#include "threatmap.h"
+#include "heroindex.h"
+#include "timingwheel.h"
 
 using namespace std;
 
-class GameBoard {
-	private: 
-	    Grid<BoardCell*> board;
-        size_t numRows;
-        size_t numCols;
+enum CollisionPolicy {
+    CollisionLegacy = 0,
+    CollisionBlock = 1,
+    CollisionSwap = 2,
+    CollisionMerge = 3,
+    NumCollisionPolicies = 4
+};
+
+static const char* const kCollisionPolicyNames[NumCollisionPolicies] = {"legacy", "block", "swap", "merge"};
+
+// looks a policy up by name ("legacy", "block", "swap", "merge"); returns false if there is none
+inline bool collisionPolicyOfName(const string& name, CollisionPolicy& policy) {
+    for (int i = 0; i < NumCollisionPolicies; i++) {
+        if (name == kCollisionPolicyNames[i]) {
+            policy = (CollisionPolicy)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// How a game ended, as reported by getOutcome().
+enum GameOutcome {
+    OutcomePlaying = 0,     // not over yet
+    OutcomeEscaped = 1,     // the hero reached the ladder
+    OutcomeAbyss = 2,       // the hero stepped into an abyss
+    OutcomeMonster = 3,     // a monster or super monster got the hero (or the hero walked into one)
+    OutcomeBat = 4,         // same with a bat
+    NumGameOutcomes = 5
+};
+
+static const char* const kGameOutcomeNames[NumGameOutcomes] = {"playing", "escaped", "abyss", "monster", "bat"};
+
+// One non-empty square for setupFromPlacements().
+struct TilePlacement {
+    size_t row, col;
+    unsigned char tile;  // TileType
+};
+
+// How often everything acts on a board, in beats (see setActionSchedule()).
+struct ActionSchedule {
+    unsigned hero, monster, superMonster, bat;   // beats between two actions, at least 1
+    size_t wakeRadius;   // baddies further than this from every hero sleep until one comes this close; 0 = none sleep
+
+    ActionSchedule() : hero(1), monster(1), superMonster(1), bat(1), wakeRadius(0) {}
+
+    // true for the default, every baddie acting once per hero move
+    bool lockstep() const {
+        return hero == 1 && monster == 1 && superMonster == 1 && bat == 1 && wakeRadius == 0;
+    }
+};
+
+//---------------------------------------------------------------------------------
+// bool validGameParameters(int rows, int cols, int abysses, int monsters, int bats)
+//
+// The limits main.cpp prompts for, plus a cap on the total number of placed
+// cells so that setupBoard() can always find free cells in the middle segment.
+//---------------------------------------------------------------------------------
+inline bool validGameParameters(int rows, int cols, int abysses, int monsters, int bats) {
+    if (rows < 10 || rows > 30 || cols < 15 || cols > 100) {
+        return false;
+    }
+    if (abysses < 0 || abysses > 200 || monsters < 0 || monsters > 30 || bats < 0 || bats > 10) {
+        return false;
+    }
+    int middleCells = rows * (cols - 6);
+    return (abysses + monsters + bats) <= middleCells / 2;
+}
+
+inline bool isBaddieTile(unsigned char tile) {
+    return tile == TileMonster || tile == TileSuperMonster || tile == TileBat;
+}
+
+// What every board offers, independent of how its cells are stored.
+class GameBoardBase {
+    public:
+        virtual ~GameBoardBase() {}
+
+        virtual void setNumMonsters(int num) = 0;
+        virtual void setNumAbysses(int num) = 0;
+        virtual void setNumBats(int num) = 0;
+        virtual void setupBoard(int seed) = 0;
+        virtual void setupFromTiles(const unsigned char* tiles) = 0;
+        virtual void setupFromTerrain(const SharedTerrain& terrain) = 0;
+        virtual void setupFromPlacements(const vector<TilePlacement>& placements) = 0;
+        virtual void getTiles(unsigned char* tiles) = 0;
+        virtual void getObservation(unsigned char* tiles) = 0;
+
+        virtual bool makeMoves(char HeroNextMove) = 0;
+        virtual bool runMoves(const string& moves, size_t& turnsPlayed) = 0;
+
+        virtual void display() = 0;
+        virtual char getCellDisplay(size_t r, size_t c) = 0;
+        virtual unsigned char getCellTile(size_t r, size_t c) = 0;
+        virtual void renderTo(char* buf, size_t stride) = 0;
+        virtual void renderRow(size_t r, size_t firstCol, size_t numCols, char* out) = 0;
+        virtual void renderViewport(size_t top, size_t left, size_t height, size_t width, char* buf, size_t stride) = 0;
+        virtual size_t getNumRows() = 0;
+        virtual size_t getNumCols() = 0;
+        virtual void getHeroPosition(size_t& row, size_t& col) = 0;
+        virtual bool getWonGame() = 0;
+        virtual GameOutcome getOutcome() = 0;
+        virtual unsigned char getOutcomeTile() = 0;
+        virtual void getOutcomeCell(size_t& row, size_t& col) = 0;
+        virtual void setVerbose(bool v) = 0;
+        virtual bool getVerbose() = 0;
+        virtual void setEventLog(EventLog* log, unsigned source) = 0;
+
+        virtual void setCollisionPolicy(CollisionPolicy policy) = 0;
+        virtual CollisionPolicy getCollisionPolicy() = 0;
+        virtual unsigned long getCollisionCount(CollisionPolicy policy) = 0;
+
+        virtual void setTrackChanges(bool on) = 0;
+        virtual void takeChangedCells(vector<size_t>& cells) = 0;
+
+        virtual void setUndoLimit(size_t turns, size_t changes) = 0;
+        virtual size_t getUndoableTurns() = 0;
+        virtual size_t rewind(size_t turns) = 0;
+
+        virtual void setFogOfWar(size_t radius) = 0;
+        virtual size_t getFogOfWar() = 0;
+        virtual const VisibilityMap* getVisibility() = 0;
+
+        virtual void setTrackThreats(bool on) = 0;
+        virtual const ThreatMap* getThreats() = 0;
+
+        virtual void setMultiHero(bool on, size_t bucketSide) = 0;
+        virtual size_t addHero(size_t row, size_t col) = 0;
+        virtual size_t makeTick(const char* heroMoves) = 0;
+        virtual size_t getNumHeroes() = 0;
+        virtual size_t getPlayingHeroes() = 0;
+        virtual GameOutcome getHeroOutcome(size_t id) = 0;
+        virtual void getHeroPosition(size_t id, size_t& row, size_t& col) = 0;
+
+        virtual void setActionSchedule(const ActionSchedule& schedule) = 0;
+        virtual ActionSchedule getActionSchedule() = 0;
+        virtual unsigned long getBaddieActions() = 0;
+};
+
+// Size of a default-constructed board. Fixed grids only come in one size.
+template<typename BoardGrid>
+struct DefaultBoardSize {
+    static const size_t rows = 15;
+    static const size_t cols = 40;
+};
+
+template<size_t R, size_t C>
+struct DefaultBoardSize< FixedGrid<BoardCell*, R, C> > {
+    static const size_t rows = R;
+    static const size_t cols = C;
+};
+
+// How a board stores its cell pointers and tile maps. Dense grids keep a flat
+// array of tiles, row after row, next to the grid.
+template<typename BoardGrid>
+struct BoardStorage {
+    static const bool sparse = false;
+    typedef vector<unsigned char> TileMap;
+
+    static void resetTiles(TileMap& tiles, size_t rows, size_t cols) {
+        tiles.assign(rows * cols, TileEmpty);
+    }
+
+    static unsigned char tile(const TileMap& tiles, size_t cols, size_t r, size_t c) {
+        return tiles[r * cols + c];
+    }
+
+    static void setTile(TileMap& tiles, size_t cols, size_t r, size_t c, unsigned char tile) {
+        tiles[r * cols + c] = tile;
+    }
+
+    static const unsigned char* tileSource(const TileMap& tiles) {
+        return &tiles[0];
+    }
+
+    // appends r * cols + c of every cell that is not TileEmpty, row after row
+    static void nonEmptyCells(const TileMap& tiles, vector<size_t>& cells) {
+        for (size_t i = 0; i < tiles.size(); i++) {
+            if (tiles[i] != TileEmpty) {
+                cells.push_back(i);
+            }
+        }
+    }
+
+    // (r, c) is always on the board here, so the column is not checked again
+    static BoardCell* cell(BoardGrid& grid, size_t r, size_t c, unsigned char tile) {
+        return grid.row(r)[c];
+    }
+
+    static void setCell(BoardGrid& grid, size_t r, size_t c, BoardCell* cell, unsigned char tile) {
+        grid.row(r)[c] = cell;
+    }
+};
+
+// A ChunkedGrid board keeps its tiles in a ChunkedGrid as well and stores the shared
+// cell of a static tile as NULL, so chunks of cells only exist around the entities.
+template<>
+struct BoardStorage< ChunkedGrid<BoardCell*> > {
+    static const bool sparse = true;
+    typedef ChunkedGrid<unsigned char> TileMap;
+
+    static void resetTiles(TileMap& tiles, size_t rows, size_t cols) {
+        tiles.resize(rows, cols);
+    }
+
+    static unsigned char tile(const TileMap& tiles, size_t cols, size_t r, size_t c) {
+        return tiles(r, c);
+    }
+
+    static void setTile(TileMap& tiles, size_t cols, size_t r, size_t c, unsigned char tile) {
+        tiles.set(r, c, tile);
+    }
+
+    static const TileMap* tileSource(const TileMap& tiles) {
+        return &tiles;
+    }
+
+    // in no particular order
+    static void nonEmptyCells(const TileMap& tiles, vector<size_t>& cells) {
+        tiles.usedCells(cells);
+    }
+
+    static BoardCell* cell(ChunkedGrid<BoardCell*>& grid, size_t r, size_t c, unsigned char tile) {
+        BoardCell* cell = grid(r, c);
+        return cell != NULL ? cell : sharedCellForTile(tile);
+    }
+
+    static void setCell(ChunkedGrid<BoardCell*>& grid, size_t r, size_t c, BoardCell* cell, unsigned char tile) {
+        grid.set(r, c, cell == sharedCellForTile(tile) ? NULL : cell);
+    }
+};
+
+template<typename BoardGrid>
+class BasicGameBoard : public GameBoardBase {
+	private:
+        typedef BoardStorage<BoardGrid> Storage;
+        typedef typename Storage::TileMap TileMap;
+        static const size_t NoCell = (size_t)-1;
+
+	    BoardGrid board;
+        TileMap occupancy;                // TileType of every cell
+        bool trackChanges;                // true = record cells whose tile changes
+        vector<size_t> changedCells;      // cells (r * cols + c) changed since the last takeChangedCells()
+        TileMap changedMark;              // 1 for every cell already in changedCells
+        size_t numHeroes;                 // hero tiles on the board, normally 0 or 1
+        size_t heroCell;                  // r * cols + c of the hero put last, NoCell if it is gone
+        vector<size_t> baddieCells;       // every cell holding a baddie, plus cells that did once
+        vector<size_t> scratchCells;      // reused by scans over the non-empty cells
+        vector<BoardCell*> spareCells[NumTileTypes]; // freed cells of each tile, reused before allocating
+        MoveTables moves;                 // resolved moves from every cell, kept in step with the terrain
+        FieldOfView view;                 // what the hero sees in fog-of-war mode, kept in step with the walls
+        bool trackThreats;                // true = keep threats up to date
+        ThreatMap threats;                // where the baddies would catch the hero, kept in step with them
+        bool multiHero;                   // true = several heroes, played with makeTick()
+        size_t heroBucketSide;            // what setMultiHero() was given for the index, 0 = its own choice
+        HeroIndex heroIndex;              // where every hero still playing stands
+        vector<GameOutcome> heroOutcomes; // how each hero's game went, by id
+        vector<size_t> activeHeroes;      // ids of the heroes that started the round playing, lowest first
+
+        // A baddie waiting to act or to wake; void once the baddie's ticket changed or it
+        // is no longer on the board.
+        struct ScheduledBaddie {
+            BoardCell* cell;
+            unsigned long ticket;
+        };
+        ActionSchedule schedule;          // how often everything acts
+        bool scheduled;                   // true = baddies act off the wheel (schedule is not lockstep)
+        TimingWheel<ScheduledBaddie> wheel;   // every awake baddie, on the beat it acts next
+        unordered_map< size_t, vector<ScheduledBaddie> > sleepers;  // sleeping baddies by bucket, wakeRadius cells a side
+        vector<ScheduledBaddie> dueBaddies;   // reused by runBeats()
+        unsigned long nextTicket;
+        unsigned long baddieActions;      // baddie moves since the board was set up
+        size_t sortedBaddies;             // baddieCells.size() when runBeats() last tidied it
+
+        // Undo history: two rings indexed by running counters (counter % ring size). A turn's
+        // changes run from its firstChange to the next turn's (or changesEnd).
+        struct UndoTurn {
+            size_t firstChange;
+            size_t heroRow, heroCol;
+            bool wonGame;
+            GameOutcome outcome;
+            unsigned char outcomeTile;
+            size_t outcomeCell;
+            unsigned long collisions[NumCollisionPolicies];
+        };
+        vector<UndoTurn> undoTurns;       // the board as it was before each recorded turn
+        vector<unsigned> undoChanges;     // cell << 3 | tile it had before the change
+        size_t turnsBegin, turnsEnd;      // recorded turns are [turnsBegin, turnsEnd)
+        size_t changesBegin, changesEnd;  // recorded changes are [changesBegin, changesEnd)
+        bool recordingTurn;               // true while makeMoves() plays a turn that is being recorded
+
+        bool settingUp;                   // true while a setup rewrites the board; moves is cleared at the end
         size_t HeroRow; // Hero's position row
 	    size_t HeroCol; // Hero's position column
         int numMonsters;
@@ -35,219 +430,1146 @@ class GameBoard {
         int numAbysses;
         int numBats;
         bool wonGame; // false, unless the Hero reached the exit successfully
+        GameOutcome outcome; // how the game ended, OutcomePlaying until it does
+        unsigned char outcomeTile; // the tile that ended it (TileLadder, TileAbyss or a baddie), TileEmpty until then
+        size_t outcomeCell; // r * cols + c of the cell the game ended on, NoCell until then
+        bool verbose; // true = report every clamp, deflection, and capture to eventLog
+        EventLog* eventLog; // where reported events go, NULL for nowhere
+        unsigned eventSource; // tags this board's events in eventLog
+        CollisionPolicy collisionPolicy; // what happens when a baddie moves onto another baddie
+        unsigned long collisions[NumCollisionPolicies]; // collisions resolved under each policy this game
+
+        // board dimensions; compile-time constants when BoardGrid is a FixedGrid
+        size_t rows() const {
+            return board.numrows();
+        }
+
+        size_t cols() const {
+            return board.numcols(0);
+        }
+
+        unsigned char tileAt(size_t r, size_t c) const {
+            return Storage::tile(occupancy, cols(), r, c);
+        }
+
+        BoardCell* cellAt(size_t r, size_t c) {
+            return Storage::cell(board, r, c, tileAt(r, c));
+        }
+
+        // what blocks the hero's view, for FieldOfView
+        struct WallAt {
+            const BasicGameBoard& owner;
+            explicit WallAt(const BasicGameBoard& b) : owner(b) {}
+            bool operator()(size_t r, size_t c) const {
+                return owner.tileAt(r, c) == TileWall;
+            }
+        };
+
+        // the cells the hero sees from where it stands, NULL with fog of war off
+        const VisibilityMap* heroView() {
+            if (view.getRadius() == 0) {
+                return NULL;
+            }
+            return &view.visibleFrom(WallAt(*this), HeroRow, HeroCol);
+        }
+
+        // Every cell write goes through put() so the occupancy map never goes stale.
+        void put(size_t r, size_t c, BoardCell* cell, unsigned char tile) {
+            size_t i = r * cols() + c;
+            unsigned char old = tileAt(r, c);
+            bool threatsChange = trackThreats && !settingUp && old != tile;
+            bool terrainChange = isTerrainTile(old) || isTerrainTile(tile);
+            if (threatsChange) {
+                // what old threatened, and what the monsters around threatened past it, as
+                // the tiles were before the change
+                markThreats(r, c, old, false);
+                if (terrainChange) {
+                    markThreatsAround(r, c, false);
+                }
+            }
+            Storage::setCell(board, r, c, cell, tile);
+            if (trackChanges && old != tile && !Storage::tile(changedMark, cols(), r, c)) {
+                Storage::setTile(changedMark, cols(), r, c, 1);
+                changedCells.push_back(i);
+            }
+            Storage::setTile(occupancy, cols(), r, c, tile);
+            if (old == TileHero && tile != TileHero) {
+                numHeroes--;
+                heroCell = (heroCell == i) ? NoCell : heroCell;
+            }
+            else if (tile == TileHero && old != TileHero) {
+                numHeroes++;
+                heroCell = i;
+            }
+            if (isBaddieTile(tile) && !isBaddieTile(old)) {
+                baddieCells.push_back(i);
+            }
+            if (old != tile && !settingUp && (isTerrainTile(old) || isTerrainTile(tile))) {
+                moves.terrainChanged(r, c);
+            }
+            if (old != tile && (old == TileWall || tile == TileWall)) {
+                view.wallsChanged();
+            }
+            if (recordingTurn && old != tile) {
+                recordChange(i, old);
+            }
+            if (threatsChange) {
+                if (terrainChange) {
+                    markThreatsAround(r, c, true);
+                }
+                markThreats(r, c, tile, true);
+            }
+        }
+
+        //---------------------------------------------------------------------------------
+        // void markThreats(size_t r, size_t c, unsigned char tile, bool add)
+        //
+        // Adds to threats (or takes back) what a baddie of this tile at (r, c) threatens.
+        // A monster moving (dr, dc) towards the hero lands on the cell its move table
+        // entry says; it catches a hero there only if that cell is still in the (dr, dc)
+        // direction, or a hero there would have drawn it another way.
+        //---------------------------------------------------------------------------------
+        void markThreats(size_t r, size_t c, unsigned char tile, bool add) {
+            if (tile == TileBat) {
+                threats.markBat(r, add);
+                return;
+            }
+            if (tile != TileMonster && tile != TileSuperMonster) {
+                return;
+            }
+            threats.markMonster(r, c, add);
+            int step = (tile == TileSuperMonster) ? 2 : 1;
+            MoveTables::Table table = (step == 2) ? MoveTables::Step2Table : MoveTables::Step1Table;
+            for (int dr = -1; dr <= 1; dr++) {
+                for (int dc = -1; dc <= 1; dc++) {
+                    unsigned char move = moves.lookup(table, r, c, dr, dc);
+                    if ((dr == 0 && dc == 0) || (move & MoveIntoAbyss)) {
+                        continue;
+                    }
+                    size_t newR, newC;
+                    MoveTables::landing(move, r, c, dr, dc, step, newR, newC);
+                    int landedR = (newR < r) ? -1 : (newR > r ? 1 : 0);
+                    int landedC = (newC < c) ? -1 : (newC > c ? 1 : 0);
+                    if (landedR == dr && landedC == dc) {
+                        threats.markMonster(newR, newC, add);
+                    }
+                }
+            }
+        }
+
+        // markThreats() for every monster whose moves can reach (r, c), (r, c) itself left out
+        void markThreatsAround(size_t r, size_t c, bool add) {
+            for (size_t nr = (r >= 2 ? r - 2 : 0); nr <= r + 2 && nr < rows(); nr++) {
+                for (size_t nc = (c >= 2 ? c - 2 : 0); nc <= c + 2 && nc < cols(); nc++) {
+                    unsigned char tile = tileAt(nr, nc);
+                    if ((nr != r || nc != c) && (tile == TileMonster || tile == TileSuperMonster)) {
+                        markThreats(nr, nc, tile, add);
+                    }
+                }
+            }
+        }
+
+        // works threats out from scratch, after a setup
+        void rebuildThreats() {
+            if (!trackThreats) {
+                return;
+            }
+            threats.reset(rows(), cols());
+            for (size_t k = 0; k < baddieCells.size(); k++) {
+                size_t r = baddieCells[k] / cols();
+                size_t c = baddieCells[k] % cols();
+                markThreats(r, c, tileAt(r, c), true);
+            }
+        }
+
+        // gives every hero on the board an id, row after row, after a setup
+        void rebuildHeroes() {
+            if (!multiHero) {
+                return;
+            }
+            scratchCells.clear();
+            Storage::nonEmptyCells(occupancy, scratchCells);
+            sort(scratchCells.begin(), scratchCells.end());
+            heroIndex.reset(rows(), cols(), heroBucketSide);
+            heroOutcomes.clear();
+            activeHeroes.clear();
+            for (size_t k = 0; k < scratchCells.size(); k++) {
+                size_t r = scratchCells[k] / cols();
+                size_t c = scratchCells[k] % cols();
+                if (tileAt(r, c) == TileHero) {
+                    indexHero(r, c);
+                }
+            }
+            findHero();
+        }
+
+        // hands the hero at (r, c) the next id and indexes it
+        size_t indexHero(size_t r, size_t c) {
+            size_t id = heroOutcomes.size();
+            heroOutcomes.push_back(OutcomePlaying);
+            heroIndex.add(id, r, c);
+            activeHeroes.push_back(id);
+            return id;
+        }
+
+        // hero id's game ended with result; its tile has been taken care of
+        void endHero(size_t id, GameOutcome result) {
+            heroOutcomes[id] = result;
+            heroIndex.remove(id);
+        }
+
+        // beats between two actions of a baddie of this tile
+        unsigned intervalOf(unsigned char tile) const {
+            return tile == TileBat ? schedule.bat : (tile == TileSuperMonster ? schedule.superMonster : schedule.monster);
+        }
+
+        // true if cell is a baddie standing where it thinks it is
+        bool onBoard(BoardCell* cell) {
+            size_t r = cell->getRow();
+            size_t c = cell->getCol();
+            return r < rows() && c < cols() && isBaddieTile(tileAt(r, c)) && cellAt(r, c) == cell;
+        }
+
+        bool stillScheduled(const ScheduledBaddie& s) {
+            return s.cell->getTicket() == s.ticket && onBoard(s.cell);
+        }
+
+        // the sleepers bucket holding (r, c)
+        size_t sleeperBucket(size_t r, size_t c) const {
+            size_t side = schedule.wakeRadius;
+            return (r / side) * ((cols() + side - 1) / side) + c / side;
+        }
+
+        // puts the baddie cell on the wheel, due a full interval from now
+        void wakeBaddie(BoardCell* cell, unsigned char tile) {
+            ScheduledBaddie s = {cell, ++nextTicket};
+            cell->setTicket(s.ticket);
+            cell->setAsleep(false);
+            wheel.schedule(s, wheel.getNow() + intervalOf(tile));
+        }
+
+        // files the baddie cell as sleeping in the bucket of where it stands
+        void putToSleep(BoardCell* cell) {
+            ScheduledBaddie s = {cell, ++nextTicket};
+            cell->setTicket(s.ticket);
+            cell->setAsleep(true);
+            sleepers[sleeperBucket(cell->getRow(), cell->getCol())].push_back(s);
+        }
+
+        //---------------------------------------------------------------------------------
+        // void wakeAround(size_t r, size_t c)
+        //
+        // Wakes every sleeper within wakeRadius of (r, c). Buckets are wakeRadius cells a
+        // side, so only the (at most) 3 x 3 buckets around (r, c) are looked at; sleepers
+        // found there that died or were moved away are dropped on the way.
+        //---------------------------------------------------------------------------------
+        void wakeAround(size_t r, size_t c) {
+            size_t radius = schedule.wakeRadius;
+            size_t top = (r >= radius ? r - radius : 0) / radius;
+            size_t bottom = min(r + min(radius, rows()), rows() - 1) / radius;
+            size_t left = (c >= radius ? c - radius : 0) / radius;
+            size_t right = min(c + min(radius, cols()), cols() - 1) / radius;
+            for (size_t br = top; br <= bottom; br++) {
+                for (size_t bc = left; bc <= right; bc++) {
+                    size_t key = sleeperBucket(br * radius, bc * radius);
+                    typename unordered_map< size_t, vector<ScheduledBaddie> >::iterator found = sleepers.find(key);
+                    if (found == sleepers.end()) {
+                        continue;
+                    }
+                    vector<ScheduledBaddie>& bucket = found->second;
+                    for (size_t k = 0; k < bucket.size(); ) {
+                        BoardCell* cell = bucket[k].cell;
+                        bool valid = stillScheduled(bucket[k]) && sleeperBucket(cell->getRow(), cell->getCol()) == key;
+                        bool near = valid && max(cell->getRow() > r ? cell->getRow() - r : r - cell->getRow(),
+                                                 cell->getCol() > c ? cell->getCol() - c : c - cell->getCol()) <= radius;
+                        if (valid && !near) {
+                            k++;
+                            continue;
+                        }
+                        if (near) {
+                            wakeBaddie(cell, tileAt(cell->getRow(), cell->getCol()));
+                        }
+                        bucket[k] = bucket.back();
+                        bucket.pop_back();
+                    }
+                    if (bucket.empty()) {
+                        sleepers.erase(found);
+                    }
+                }
+            }
+        }
+
+        // wakeAround() every hero still playing
+        void wakeAroundHeroes() {
+            if (schedule.wakeRadius == 0) {
+                return;
+            }
+            if (!multiHero) {
+                if (HeroRow < rows() && HeroCol < cols()) {
+                    wakeAround(HeroRow, HeroCol);
+                }
+                return;
+            }
+            for (size_t k = 0; k < activeHeroes.size(); k++) {
+                if (heroIndex.contains(activeHeroes[k])) {
+                    size_t r, c;
+                    heroIndex.position(activeHeroes[k], r, c);
+                    wakeAround(r, c);
+                }
+            }
+        }
+
+        // puts every baddie on the wheel (or to sleep) from scratch and starts the clock
+        // over, after a setup
+        void rebuildSchedule() {
+            if (!scheduled) {
+                return;
+            }
+            wheel.reset(0);
+            sleepers.clear();
+            sortedBaddies = baddieCells.size();
+            for (size_t k = 0; k < baddieCells.size(); k++) {
+                size_t r = baddieCells[k] / cols();
+                size_t c = baddieCells[k] % cols();
+                BoardCell* cell = cellAt(r, c);
+                cell->setPos(r, c);
+                if (schedule.wakeRadius == 0) {
+                    wakeBaddie(cell, tileAt(r, c));
+                }
+                else {
+                    putToSleep(cell);
+                }
+            }
+            wakeAroundHeroes();
+        }
+
+        // orders baddies row after row by where they stand
+        struct ByPosition {
+            size_t numCols;
+            explicit ByPosition(size_t n) : numCols(n) {}
+            bool operator()(const ScheduledBaddie& a, const ScheduledBaddie& b) const {
+                return a.cell->getRow() * numCols + a.cell->getCol() < b.cell->getRow() * numCols + b.cell->getCol();
+            }
+        };
+
+        //---------------------------------------------------------------------------------
+        // bool runBeats()
+        //
+        // moveBaddies() on a scheduled board. Wakes the sleepers near the heroes, then
+        // runs the clock for schedule.hero beats. On each beat the baddies due act, row
+        // after row as they stand, under the same rules as in lockstep, and go back on
+        // the wheel a full interval later. Stops early once the hero was caught (every
+        // hero, on a multi-hero board). Returns true if a baddie caught the hero.
+        //---------------------------------------------------------------------------------
+        bool runBeats() {
+            TraceSpan span("runBeats");
+            bool gotHero = false;
+            wakeAroundHeroes();
+            for (unsigned beat = 0; beat < schedule.hero; beat++) {
+                if (multiHero ? heroIndex.size() == 0 : gotHero) {
+                    break;
+                }
+                dueBaddies.clear();
+                wheel.advance(dueBaddies);
+                size_t kept = 0;
+                for (size_t k = 0; k < dueBaddies.size(); k++) {
+                    if (stillScheduled(dueBaddies[k])) {
+                        dueBaddies[kept++] = dueBaddies[k];
+                    }
+                }
+                dueBaddies.resize(kept);
+                sort(dueBaddies.begin(), dueBaddies.end(), ByPosition(cols()));
+                for (size_t k = 0; k < dueBaddies.size(); k++) {
+                    dueBaddies[k].cell->setMoved(false);
+                }
+                for (size_t k = 0; k < dueBaddies.size(); k++) {
+                    BoardCell* cell = dueBaddies[k].cell;
+                    if (!stillScheduled(dueBaddies[k])) {
+                        continue;
+                    }
+                    moveBaddie(cell->getRow(), cell->getCol(), gotHero);
+                    if (stillScheduled(dueBaddies[k])) {
+                        wheel.schedule(dueBaddies[k], wheel.getNow() + intervalOf(tileAt(cell->getRow(), cell->getCol())));
+                    }
+                }
+            }
+            // nothing sorts baddieCells once a turn here, so it keeps every cell a baddie
+            // moved onto; tidy it whenever it has doubled
+            if (baddieCells.size() > 2 * sortedBaddies + 64) {
+                sortBaddieCells();
+                sortedBaddies = baddieCells.size();
+            }
+            findHero();
+            return gotHero;
+        }
+
+        UndoTurn& undoTurnAt(size_t n) {
+            return undoTurns[n % undoTurns.size()];
+        }
+
+        void forgetOldestTurn() {
+            turnsBegin++;
+            changesBegin = (turnsBegin < turnsEnd) ? undoTurnAt(turnsBegin).firstChange : changesEnd;
+        }
+
+        void forgetUndoHistory() {
+            turnsBegin = turnsEnd;
+            changesBegin = changesEnd;
+            recordingTurn = false;
+        }
+
+        // starts recording a turn, forgetting the oldest one if the history is full
+        void beginUndoTurn() {
+            if (undoTurns.empty()) {
+                return;
+            }
+            if (turnsEnd - turnsBegin == undoTurns.size()) {
+                forgetOldestTurn();
+            }
+            UndoTurn& turn = undoTurnAt(turnsEnd++);
+            turn.firstChange = changesEnd;
+            turn.heroRow = HeroRow;
+            turn.heroCol = HeroCol;
+            turn.wonGame = wonGame;
+            turn.outcome = outcome;
+            turn.outcomeTile = outcomeTile;
+            turn.outcomeCell = outcomeCell;
+            for (int i = 0; i < NumCollisionPolicies; i++) {
+                turn.collisions[i] = collisions[i];
+            }
+            recordingTurn = true;
+        }
+
+        // Makes room by forgetting the oldest turns. A turn that does not fit into the
+        // ring on its own cannot be taken back, and neither can anything before it.
+        void recordChange(size_t cell, unsigned char oldTile) {
+            while (changesEnd - changesBegin == undoChanges.size()) {
+                if (turnsEnd - turnsBegin <= 1) {
+                    forgetUndoHistory();
+                    return;
+                }
+                forgetOldestTurn();
+            }
+            undoChanges[changesEnd++ % undoChanges.size()] = (unsigned)(cell << 3) | oldTile;
+        }
+
+        // a setup rewrites most of the board, so the move tables are cleared once at the end
+        void beginSetup() {
+            settingUp = true;
+            forgetUndoHistory();
+            baddieActions = 0;
+        }
+
+        void endSetup() {
+            settingUp = false;
+            moves.clear();
+            sortBaddieCells();
+            rebuildThreats();
+            rebuildHeroes();
+            rebuildSchedule();
+        }
+
+        // sorts baddieCells row after row and drops the cells that no longer hold a baddie
+        void sortBaddieCells() {
+            sort(baddieCells.begin(), baddieCells.end());
+            size_t kept = 0;
+            for (size_t k = 0; k < baddieCells.size(); k++) {
+                size_t i = baddieCells[k];
+                if ((kept == 0 || baddieCells[kept - 1] != i) && isBaddieTile(tileAt(i / cols(), i % cols()))) {
+                    baddieCells[kept++] = i;
+                }
+            }
+            baddieCells.resize(kept);
+        }
+
+        // empties every cell that is not empty already
+        void clearBoard() {
+            scratchCells.clear();
+            Storage::nonEmptyCells(occupancy, scratchCells);
+            for (size_t k = 0; k < scratchCells.size(); k++) {
+                replaceTile(scratchCells[k] / cols(), scratchCells[k] % cols(), TileEmpty);
+            }
+        }
+
+        // Empty and terrain squares all point at the shared cell of their tile. Other cells
+        // taken off the board are kept per tile and handed out again, so once a board has
+        // warmed up neither playing a turn nor setting up a new game allocates.
+        BoardCell* takeCell(unsigned char tile, size_t r, size_t c) {
+            if (isStaticTile(tile)) {
+                return sharedCellForTile(tile);
+            }
+            vector<BoardCell*>& spare = spareCells[tile];
+            BoardCell* cell;
+            if (spare.empty()) {
+                cell = newCellForTile(tile, r, c);
+            }
+            else {
+                cell = spare.back();
+                spare.pop_back();
+                cell->setPos(r, c);
+            }
+            if (scheduled && !settingUp && isBaddieTile(tile)) {
+                // a baddie that turns up during a game (a merge) starts out awake
+                wakeBaddie(cell, tile);
+            }
+            return cell;
+        }
 
-		
-	public: 
+        // true if the board allocated the cell at (r, c), i.e. it is not a shared cell
+        bool ownsCell(size_t r, size_t c) {
+            return cellAt(r, c) != sharedCellForTile(tileAt(r, c));
+        }
+
+        void releaseCell(size_t r, size_t c) {
+            if (ownsCell(r, c)) {
+                spareCells[tileAt(r, c)].push_back(cellAt(r, c));
+            }
+        }
+
+        // frees the cell at (r, c) and puts a new cell of the given tile there
+        void replaceTile(size_t r, size_t c, unsigned char tile) {
+            releaseCell(r, c);
+            put(r, c, takeCell(tile, r, c), tile);
+        }
+
+        // moves the cell at (r, c) onto (newR, newC), freeing what was there, and leaves Nothing behind
+        void relocate(size_t r, size_t c, size_t newR, size_t newC) {
+            releaseCell(newR, newC);
+            put(newR, newC, cellAt(r, c), tileAt(r, c));
+            put(r, c, takeCell(TileEmpty, r, c), TileEmpty);
+        }
+
+        // how the game ended, the tile that ended it and the cell (r * cols + c) it happened on
+        void setOutcome(GameOutcome result, unsigned char tile, size_t cell) {
+            outcome = result;
+            outcomeTile = tile;
+            outcomeCell = cell;
+        }
+
+        void resetCollisionCounts() {
+            for (int i = 0; i < NumCollisionPolicies; i++) {
+                collisions[i] = 0;
+            }
+        }
+
+	public:
 		/* default constructor */
-        GameBoard() {
+        BasicGameBoard() : board(DefaultBoardSize<BoardGrid>::rows, DefaultBoardSize<BoardGrid>::cols) {
             numMonsters = 4;
             numSuperMonsters = 2;
             numAbysses = 50;
             numBats = 2;
             wonGame = false;
-            
-            this -> numRows = 15;
-            this -> numCols = 40;
-            
-            Grid<BoardCell*> boardnew(numRows, numCols);
-            board = boardnew;
-            
+            setOutcome(OutcomePlaying, TileEmpty, NoCell);
+            verbose = true;
+            eventLog = NULL;
+            eventSource = 0;
+            collisionPolicy = CollisionBlock;
+            resetCollisionCounts();
+            trackChanges = false;
+            trackThreats = false;
+            multiHero = false;
+            heroBucketSide = 0;
+            scheduled = false;
+            nextTicket = 0;
+            baddieActions = 0;
+            sortedBaddies = 0;
+            turnsBegin = turnsEnd = changesBegin = changesEnd = 0;
+            recordingTurn = false;
+
+            numHeroes = 0;
+            heroCell = NoCell;
+            setHeroPosition(-1, -1);
+
+            Storage::resetTiles(occupancy, rows(), cols());
+            moves.resize(rows(), cols(), Storage::tileSource(occupancy));
+            view.resize(rows(), cols());
+            beginSetup();
             blankBoard();
+            endSetup();
         }
-        
+
         /* param constructor */
-        GameBoard(size_t numRows, size_t numCols) {
+        BasicGameBoard(size_t numRows, size_t numCols) : board(numRows, numCols) {
             numMonsters = 4;
             numSuperMonsters = 2;
             numAbysses = 20;
             numBats = 3;
             wonGame = false;
-            
-            this -> numRows = numRows;
-            this -> numCols = numCols;
-            
-            Grid<BoardCell*> boardnew(numRows, numCols);
-            board = boardnew;
-            
+            setOutcome(OutcomePlaying, TileEmpty, NoCell);
+            verbose = true;
+            eventLog = NULL;
+            eventSource = 0;
+            collisionPolicy = CollisionBlock;
+            resetCollisionCounts();
+            trackChanges = false;
+            trackThreats = false;
+            multiHero = false;
+            heroBucketSide = 0;
+            scheduled = false;
+            nextTicket = 0;
+            baddieActions = 0;
+            sortedBaddies = 0;
+            turnsBegin = turnsEnd = changesBegin = changesEnd = 0;
+            recordingTurn = false;
+
+            numHeroes = 0;
+            heroCell = NoCell;
+            setHeroPosition(-1, -1);
+
+            Storage::resetTiles(occupancy, rows(), cols());
+            moves.resize(rows(), cols(), Storage::tileSource(occupancy));
+            view.resize(rows(), cols());
+            beginSetup();
             blankBoard();
+            endSetup();
+        }
+
+        /* destructor */
+        virtual ~BasicGameBoard() {
+            scratchCells.clear();
+            Storage::nonEmptyCells(occupancy, scratchCells);
+            for (size_t k = 0; k < scratchCells.size(); k++) {
+                size_t row = scratchCells[k] / cols();
+                size_t col = scratchCells[k] % cols();
+                if (ownsCell(row, col)) {
+                    delete cellAt(row, col);
+                }
+            }
+            for (int tile = 0; tile < NumTileTypes; tile++) {
+                for (size_t i = 0; i < spareCells[tile].size(); i++) {
+                    delete spareCells[tile][i];
+                }
+            }
+        }
+
+        void blankBoard() {
+            if (Storage::sparse) {
+                // a chunked board reads as empty wherever nothing was put
+                return;
+            }
+            for (size_t row = 0; row < rows(); row++) {
+                for (size_t col = 0; col < cols(); col++) {
+                    put(row, col, sharedCellForTile(TileEmpty), TileEmpty);
+                }
+            }
+        }
+
+        virtual char getCellDisplay(size_t r, size_t c) {
+            return cellAt(r, c)->display();
+        }
+
+        // TileType of the cell, read from the occupancy map
+        virtual unsigned char getCellTile(size_t r, size_t c) {
+            return tileAt(r, c);
+        }
+
+        void setCell(BoardCell* myCell, size_t r, size_t c) {
+            put(r, c, myCell, tileOfGlyph(myCell->display()));
+        }
+
+        void freeCell(size_t r, size_t c) {
+            if (ownsCell(r, c)) {
+                delete cellAt(r, c);
+            }
+        }
+
+        // fills board with by randomly placing...
+        //  - Hero (H) in the first three columns
+        //  - EscapeLadder (*) in last three columns
+        //  - 3 vertical Walls (+), each 1/2 of board height, in middle segment
+        //  - Abyss cells (#), quantity set by numAbysses, in middle segment
+        //  - Baddies [Monsters (m), Super Monsters (M), & Bats (~)] in middle segment;
+        //    number of Baddies set by numMonsters, numSuperMonsters, & numBats
+        //
+        // setupBoard() draws from its own GameRng (same sequence as srand/rand) instead
+        // of the global rand() state, so boards can be set up on several threads at once.
+        // Whatever was on the board is cleared first, so a board can be set up again for
+        // a new game.
+        virtual void setupBoard(int seed) {
+            TraceSpan span("setupBoard");
+            GameRng rng(seed);
+            beginSetup();
+            resetCollisionCounts();
+            wonGame = false;
+            setOutcome(OutcomePlaying, TileEmpty, NoCell);
+            size_t r,c;
+            size_t numRows = rows();
+            size_t numCols = cols();
+
+            clearBoard();
+
+            r = rng() % numRows;
+            c = rng() % 3;
+            replaceTile(r, c, TileHero);
+            HeroRow = r;
+            HeroCol = c;
+
+            r = rng() % numRows;
+            c = numCols - 1 - (rng() % 3);
+            replaceTile(r, c, TileLadder);
+
+            int sizeMid = numCols - 6;
+
+            c = 3 + (rng() % sizeMid);
+            for (r = 0; r < numRows/2; ++r) {
+                replaceTile(r, c, TileWall);
+            }
+            size_t topc = c;
+
+            while (c == topc || c == topc-1 || c == topc+1) {
+                c = 3 + (rng() % sizeMid);
+            }
+            for (r = numRows-1; r > numRows/2; --r) {
+                replaceTile(r, c, TileWall);
+            }
+            size_t botc = c;
+
+            while (c == topc || c == topc-1 || c == topc+1 || c == botc || c == botc-1 || c == botc+1) {
+                c = 3 + (rng() % sizeMid);
+            }
+            for (r = numRows/4; r < 3*numRows/4; ++r) {
+                replaceTile(r, c, TileWall);
+            }
+
+            for (int i = 0; i < numMonsters; ++i) {
+                r = rng() % numRows;
+                c = 3 + (rng() % sizeMid);
+                while (tileAt(r,c) != TileEmpty) {
+                    r = rng() % numRows;
+                    c = 3 + (rng() % sizeMid);
+                }
+                replaceTile(r, c, TileMonster);
+            }
+
+            for (int i = 0; i < numSuperMonsters; ++i) {
+                r = rng() % numRows;
+                c = 3 + (rng() % sizeMid);
+                while (tileAt(r,c) != TileEmpty) {
+                    r = rng() % numRows;
+                    c = 3 + (rng() % sizeMid);
+                }
+                replaceTile(r, c, TileSuperMonster);
+            }
+
+            for (int i = 0; i < numBats; ++i) {
+                r = rng() % numRows;
+                c = 3 + (rng() % sizeMid);
+                while (tileAt(r,c) != TileEmpty) {
+                    r = rng() % numRows;
+                    c = 3 + (rng() % sizeMid);
+                }
+                replaceTile(r, c, TileBat);
+            }
+
+            for (int i = 0; i < numAbysses; ++i) {
+                r = rng() % numRows;
+                c = 3 + (rng() % sizeMid);
+                while (tileAt(r,c) != TileEmpty) {
+                    r = rng() % numRows;
+                    c = 3 + (rng() % sizeMid);
+                }
+                replaceTile(r, c, TileAbyss);
+            }
+            endSetup();
+        }
+
+        //---------------------------------------------------------------------------------
+        // void setupFromTiles(const unsigned char* tiles)
+        //
+        // Replaces every cell with the layout in tiles (rows x cols TileType codes, row
+        // after row), e.g. a level read back from a LevelLibrary. The hero position is
+        // taken from the layout and the game starts over.
+        //---------------------------------------------------------------------------------
+        virtual void setupFromTiles(const unsigned char* tiles) {
+            TraceSpan span("setupFromTiles");
+            setHeroPosition(-1, -1);
+            beginSetup();
+            resetCollisionCounts();
+            for (size_t r = 0; r < rows(); r++) {
+                for (size_t c = 0; c < cols(); c++) {
+                    unsigned char tile = tiles[r * cols() + c];
+                    if (tile >= NumTileTypes) {
+                        tile = TileEmpty;
+                    }
+                    replaceTile(r, c, tile);
+                    if (tile == TileHero) {
+                        setHeroPosition(r, c);
+                    }
+                }
+            }
+            endSetup();
+            wonGame = false;
+            setOutcome(OutcomePlaying, TileEmpty, NoCell);
+        }
+
+        //---------------------------------------------------------------------------------
+        // void setupFromTerrain(const SharedTerrain& terrain)
+        //
+        // Sets up the layout terrain was built from and starts the game over. The board
+        // reads terrain's move tables instead of resolving moves of its own until a
+        // baddie removes a wall or the ladder, so boards set up from one Terrain share
+        // everything but their grid, occupancy map and entities.
+        //---------------------------------------------------------------------------------
+        virtual void setupFromTerrain(const SharedTerrain& terrain) {
+            TraceSpan span("setupFromTerrain");
+            if (terrain->numRows() != rows() || terrain->numCols() != cols()) {
+                throw invalid_argument("GameBoard setupFromTerrain -> terrain size does not match the board");
+            }
+            setHeroPosition(-1, -1);
+            beginSetup();
+            resetCollisionCounts();
+            for (size_t r = 0; r < rows(); r++) {
+                for (size_t c = 0; c < cols(); c++) {
+                    if (tileAt(r, c) != terrain->tile(r, c)) {
+                        replaceTile(r, c, terrain->tile(r, c));
+                    }
+                }
+            }
+            for (size_t i = 0; i < terrain->numEntities(); i++) {
+                size_t r = terrain->entityCell(i) / cols();
+                size_t c = terrain->entityCell(i) % cols();
+                replaceTile(r, c, terrain->entityTile(i));
+                if (terrain->entityTile(i) == TileHero) {
+                    setHeroPosition(r, c);
+                }
+            }
+            settingUp = false;
+            moves.share(shared_ptr<const MoveTables>(terrain, &terrain->moveTables()));
+            sortBaddieCells();
+            rebuildThreats();
+            rebuildHeroes();
+            rebuildSchedule();
+            wonGame = false;
+            setOutcome(OutcomePlaying, TileEmpty, NoCell);
+        }
+
+        //---------------------------------------------------------------------------------
+        // void setupFromPlacements(const vector<TilePlacement>& placements)
+        //
+        // Empties the board, puts each placement's tile on its square (a later placement
+        // of the same square wins) and starts the game over, the hero where a TileHero
+        // was placed. The cost depends on the number of placements and what was on the
+        // board before, not on its size, so this is how a SparseGameBoard world is made.
+        // Throws out_of_range, before changing anything, if a placement is off the board.
+        //---------------------------------------------------------------------------------
+        virtual void setupFromPlacements(const vector<TilePlacement>& placements) {
+            TraceSpan span("setupFromPlacements");
+            for (size_t i = 0; i < placements.size(); i++) {
+                if (placements[i].row >= rows() || placements[i].col >= cols()) {
+                    throw out_of_range("GameBoard setupFromPlacements -> placement is off the board");
+                }
+            }
+            setHeroPosition(-1, -1);
+            beginSetup();
+            resetCollisionCounts();
+            clearBoard();
+            for (size_t i = 0; i < placements.size(); i++) {
+                const TilePlacement& p = placements[i];
+                unsigned char tile = p.tile < NumTileTypes ? p.tile : (unsigned char)TileEmpty;
+                replaceTile(p.row, p.col, tile);
+                if (tile == TileHero) {
+                    setHeroPosition(p.row, p.col);
+                }
+            }
+            endSetup();
+            wonGame = false;
+            setOutcome(OutcomePlaying, TileEmpty, NoCell);
+        }
+
+        // writes the TileType of every cell into tiles (rows x cols, row after row)
+        virtual void getTiles(unsigned char* tiles) {
+            fill(tiles, tiles + rows() * cols(), (unsigned char)TileEmpty);
+            scratchCells.clear();
+            Storage::nonEmptyCells(occupancy, scratchCells);
+            for (size_t k = 0; k < scratchCells.size(); k++) {
+                size_t i = scratchCells[k];
+                tiles[i] = tileAt(i / cols(), i % cols());
+            }
+        }
+
+        // getTiles() as the hero sees it: with fog of war on, every cell it cannot see
+        // is written as kHiddenTile
+        virtual void getObservation(unsigned char* tiles) {
+            const VisibilityMap* seen = heroView();
+            if (seen == NULL) {
+                getTiles(tiles);
+                return;
+            }
+            fill(tiles, tiles + rows() * cols(), kHiddenTile);
+            for (size_t i = 0; i < seen->getHeight(); i++) {
+                size_t r = seen->getTop() + i;
+                const uint64_t* bits = seen->rowBits(i);
+                for (size_t w = 0; w * 64 < seen->getWidth(); w++) {
+                    for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                        size_t c = seen->getLeft() + w * 64 + __builtin_ctzll(word);
+                        tiles[r * cols() + c] = tileAt(r, c);
+                    }
+                }
+            }
+        }
+
+        //---------------------------------------------------------------------------------
+        // void renderViewport(size_t top, size_t left, size_t height, size_t width,
+        //                     char* buf, size_t stride)
+        //
+        // Writes the display characters of the height x width rectangle whose top left
+        // cell is (top, left) into buf: row top+i goes to buf + i*stride. Nothing else in
+        // buf is touched (no separators or terminators). Throws out_of_range if the
+        // rectangle does not fit on the board. With fog of war on, cells the hero cannot
+        // see are drawn as kHiddenGlyph.
+        //---------------------------------------------------------------------------------
+        virtual void renderViewport(size_t top, size_t left, size_t height, size_t width, char* buf, size_t stride) {
+            if (top > rows() || height > rows() - top || left > cols() || width > cols() - left) {
+                throw out_of_range("GameBoard renderViewport -> viewport is off the board");
+            }
+            const VisibilityMap* seen = heroView();
+            for (size_t i = 0; i < height; i++) {
+                char* out = buf + i * stride;
+                if (seen != NULL) {
+                    for (size_t j = 0; j < width; j++) {
+                        bool shown = seen->visible(top + i, left + j);
+                        out[j] = shown ? kTileGlyphs[tileAt(top + i, left + j)] : kHiddenGlyph;
+                    }
+                    continue;
+                }
+                for (size_t j = 0; j < width; j++) {
+                    out[j] = kTileGlyphs[tileAt(top + i, left + j)];
+                }
+            }
+        }
+
+        // the whole board, row r at buf + r*stride (stride >= cols)
+        virtual void renderTo(char* buf, size_t stride) {
+            renderViewport(0, 0, rows(), cols(), buf, stride);
+        }
+
+        // numCols display characters of row r starting at firstCol
+        virtual void renderRow(size_t r, size_t firstCol, size_t numCols, char* out) {
+            renderViewport(r, firstCol, 1, numCols, out, numCols);
+        }
+
+        // neatly displaying the game board
+		virtual void display( ) {
+            TraceSpan span("display");
+            size_t width = cols() + 3;  // '|', the row, '|', '\n'
+            string text((rows() + 2) * width, '|');
+            string border = '-' + string(cols(), '-') + "-\n";
+            text.replace(0, width, border);
+            text.replace((rows() + 1) * width, width, border);
+            renderTo(&text[width + 1], width);
+            for (size_t row = 1; row <= rows(); row++) {
+                text[row * width + width - 1] = '\n';
+            }
+            cout << text << flush;
+        }
+
+        virtual bool getWonGame() {
+            return wonGame;
+        }
+
+        virtual GameOutcome getOutcome() {
+            return outcome;
+        }
+
+        // the tile that ended the game: TileLadder, TileAbyss or the baddie that caught
+        // the hero (TileEmpty while it is still going)
+        virtual unsigned char getOutcomeTile() {
+            return outcomeTile;
+        }
+
+        // the cell the game ended on, the one the hero escaped, fell or was caught on;
+        // (-1, -1) while it is still going
+        virtual void getOutcomeCell(size_t& row, size_t& col) {
+            row = (outcomeCell == NoCell) ? (size_t)-1 : outcomeCell / cols();
+            col = (outcomeCell == NoCell) ? (size_t)-1 : outcomeCell % cols();
         }
-        
-        /* destructor */
-        virtual ~GameBoard() {
-            for (size_t row = 0; row < board.numrows(); row++) {
-                for (size_t col = 0; col < board.numcols(row); col++) {
-                    delete board(row, col);
-                }
-            }
+
+        // the outcome when the hero runs into (or is caught by) a baddie with this tile
+        static GameOutcome outcomeOfBaddie(unsigned char tile) {
+            return tile == TileBat ? OutcomeBat : OutcomeMonster;
         }
 
-        void blankBoard() {
-            for (size_t row = 0; row < board.numrows(); row++) {
-                for (size_t col = 0; col < board.numcols(row); col++) {
-                    board(row, col) = new Nothing(row,col);
-                }
-            }
+        // turns the per-move diagnostic events on or off; boards driven by
+        // something other than a person at the terminal should turn them off
+        virtual void setVerbose(bool v) {
+            verbose = v;
         }
 
-        char getCellDisplay(size_t r, size_t c) {
-            return board(r,c)->display();
+        virtual bool getVerbose() {
+            return verbose;
         }
 
-        void setCell(BoardCell* myCell, size_t r, size_t c) {
-            board(r,c) = myCell;
+        // where the diagnostic events go (NULL for nowhere), each tagged with source;
+        // the board never waits on the log, see eventlog.h
+        virtual void setEventLog(EventLog* log, unsigned source) {
+            eventLog = log;
+            eventSource = source;
         }
-    
-        void freeCell(size_t r, size_t c) {
-            delete board(r,c);
+
+        // CollisionBlock unless changed; CollisionLegacy reproduces the original engine
+        virtual void setCollisionPolicy(CollisionPolicy policy) {
+            collisionPolicy = policy;
         }
 
-        // fills board with by randomly placing...
-        //  - Hero (H) in the first three columns
-        //  - EscapeLadder (*) in last three columns
-        //  - 3 vertical Walls (+), each 1/2 of board height, in middle segment
-        //  - Abyss cells (#), quantity set by numAbysses, in middle segment
-        //  - Baddies [Monsters (m), Super Monsters (M), & Bats (~)] in middle segment;
-        //    number of Baddies set by numMonsters, numSuperMonsters, & numBats
-        void setupBoard(int seed) {
-            srand(seed);
-            size_t r,c;
+        virtual CollisionPolicy getCollisionPolicy() {
+            return collisionPolicy;
+        }
 
-            r = rand() % numRows;
-            c = rand() % 3;
-            delete board(r,c);
-            board(r,c) = new Hero(r,c);
-            HeroRow = r;
-            HeroCol = c;
+        // number of baddie-on-baddie collisions resolved with policy since the board was set up
+        virtual unsigned long getCollisionCount(CollisionPolicy policy) {
+            return (policy >= 0 && policy < NumCollisionPolicies) ? collisions[policy] : 0;
+        }
 
-            r = rand() % numRows;
-            c = numCols - 1 - (rand() % 3);
-            delete board(r,c);
-            board(r,c) = new EscapeLadder(r,c);
-            
-            int sizeMid = numCols - 6;
+        // starts (or stops) recording changed cells; either way nothing is recorded yet
+        virtual void setTrackChanges(bool on) {
+            trackChanges = on;
+            changedCells.clear();
+            Storage::resetTiles(changedMark, on ? rows() : 0, cols());
+        }
 
-            c = 3 + (rand() % sizeMid);
-            for (r = 0; r < numRows/2; ++r) {
-                delete board(r,c);
-                board(r,c) = new Wall(r,c);
+        // appends the cells whose tile changed since the last call (row * cols + col, in the
+        // order they first changed) and starts recording afresh
+        virtual void takeChangedCells(vector<size_t>& cells) {
+            for (size_t i = 0; i < changedCells.size(); i++) {
+                Storage::setTile(changedMark, cols(), changedCells[i] / cols(), changedCells[i] % cols(), 0);
             }
-            size_t topc = c;
+            cells.insert(cells.end(), changedCells.begin(), changedCells.end());
+            changedCells.clear();
+        }
 
-            while (c == topc || c == topc-1 || c == topc+1) {
-                c = 3 + (rand() % sizeMid);
-            }
-            for (r = numRows-1; r > numRows/2; --r) {
-                delete board(r,c);
-                board(r,c) = new Wall(r,c);           
+        //---------------------------------------------------------------------------------
+        // void setUndoLimit(size_t turns, size_t changes)
+        //
+        // Keeps the last turns turns for rewind(), as long as together they changed no
+        // more than changes cells (a move usually changes 2 cells per entity that moved).
+        // Memory is fixed at about 64 bytes a turn plus 4 bytes a change. 0 turns (the
+        // default) records nothing. The history is cleared here and by every setup.
+        //---------------------------------------------------------------------------------
+        virtual void setUndoLimit(size_t turns, size_t changes) {
+            if (rows() * cols() > ((size_t)1 << 29)) {
+                throw invalid_argument("GameBoard setUndoLimit -> board too large to record");
             }
-            size_t botc = c;
-
-            while (c == topc || c == topc-1 || c == topc+1 || c == botc || c == botc-1 || c == botc+1) {
-                c = 3 + (rand() % sizeMid);
+            if (multiHero && turns > 0 && changes > 0) {
+                throw logic_error("GameBoard setUndoLimit -> undo follows a single hero");
             }
-            for (r = numRows/4; r < 3*numRows/4; ++r) {
-                delete board(r,c);
-                board(r,c) = new Wall(r,c);
+            if (scheduled && turns > 0 && changes > 0) {
+                throw logic_error("GameBoard setUndoLimit -> undo does not rewind the action schedule");
             }
+            undoTurns.assign(changes > 0 ? turns : 0, UndoTurn());
+            undoChanges.assign(turns > 0 ? changes : 0, 0);
+            forgetUndoHistory();
+        }
 
-            for (int i = 0; i < numMonsters; ++i) {
-                r = rand() % numRows;
-                c = 3 + (rand() % sizeMid);
-                while (board(r,c)->display() != ' ') {
-                    r = rand() % numRows;
-                    c = 3 + (rand() % sizeMid);
-                }
-                delete board(r,c);
-                board(r,c) = new Monster(r,c);  
-                board(r,c)->setPower(1);        
-            }
+        // number of turns rewind() can take back right now
+        virtual size_t getUndoableTurns() {
+            return turnsEnd - turnsBegin;
+        }
 
-            for (int i = 0; i < numSuperMonsters; ++i) {
-                r = rand() % numRows;
-                c = 3 + (rand() % sizeMid);
-                while (board(r,c)->display() != ' ') {
-                    r = rand() % numRows;
-                    c = 3 + (rand() % sizeMid);
+        //---------------------------------------------------------------------------------
+        // size_t rewind(size_t turns)
+        //
+        // Takes back the last turns turns (fewer if the history is shorter) and returns
+        // how many were taken back. Each changed tile is put back in reverse order, so the
+        // cost is the number of changes, not the size of the board. Change tracking sees
+        // the restored cells like any other change.
+        //---------------------------------------------------------------------------------
+        virtual size_t rewind(size_t turns) {
+            TraceSpan span("rewind");
+            size_t undone = 0;
+            while (undone < turns && turnsEnd > turnsBegin) {
+                UndoTurn& turn = undoTurnAt(turnsEnd - 1);
+                while (changesEnd > turn.firstChange) {
+                    unsigned change = undoChanges[--changesEnd % undoChanges.size()];
+                    size_t cell = change >> 3;
+                    replaceTile(cell / cols(), cell % cols(), change & 7);
                 }
-                delete board(r,c);
-                board(r,c) = new Monster(r,c); 
-                board(r,c)->setPower(2);               
-            }
-
-            for (int i = 0; i < numBats; ++i) {
-                r = rand() % numRows;
-                c = 3 + (rand() % sizeMid);
-                while (board(r,c)->display() != ' ') {
-                    r = rand() % numRows;
-                    c = 3 + (rand() % sizeMid);
+                HeroRow = turn.heroRow;
+                HeroCol = turn.heroCol;
+                wonGame = turn.wonGame;
+                setOutcome(turn.outcome, turn.outcomeTile, turn.outcomeCell);
+                for (int i = 0; i < NumCollisionPolicies; i++) {
+                    collisions[i] = turn.collisions[i];
                 }
-                delete board(r,c);
-                board(r,c) = new Bat(r,c); 
+                turnsEnd--;
+                undone++;
             }
+            return undone;
+        }
 
-            for (int i = 0; i < numAbysses; ++i) {
-                r = rand() % numRows;
-                c = 3 + (rand() % sizeMid);
-                while (board(r,c)->display() != ' ') {
-                    r = rand() % numRows;
-                    c = 3 + (rand() % sizeMid);
-                }
-                delete board(r,c);
-                board(r,c) = new Abyss(r,c);              
+        //---------------------------------------------------------------------------------
+        // void setFogOfWar(size_t radius)
+        //
+        // Hides every cell the hero cannot see: further than radius away (as the crow
+        // flies) or behind a wall. Only rendering and getObservation() are affected, the
+        // game plays the same. 0 (the default) shows the whole board.
+        //---------------------------------------------------------------------------------
+        virtual void setFogOfWar(size_t radius) {
+            if (multiHero && radius > 0) {
+                throw logic_error("GameBoard setFogOfWar -> fog of war follows a single hero");
             }
+            view.setRadius(radius);
+        }
+
+        virtual size_t getFogOfWar() {
+            return view.getRadius();
         }
 
-        // neatly displaying the game board 
-		void display( ) {
-            cout << '-';
-            for (size_t col = 0; col < board.numcols(0); col++) {
-                cout << '-';
+        // the cells the hero sees right now (valid until the board changes), NULL with fog of war off
+        virtual const VisibilityMap* getVisibility() {
+            return heroView();
+        }
+
+        //---------------------------------------------------------------------------------
+        // void setTrackThreats(bool on)
+        //
+        // Starts (or stops) keeping the ThreatMap getThreats() returns. Worked out from
+        // scratch here and after every setup, and kept up to date by every move in between.
+        // Takes a byte and a bit per cell, so it is not offered on a SparseGameBoard.
+        //---------------------------------------------------------------------------------
+        virtual void setTrackThreats(bool on) {
+            if (on && Storage::sparse) {
+                throw invalid_argument("GameBoard setTrackThreats -> not offered on a sparse board");
             }
-            cout << '-';
-            cout << endl;
-            for (size_t row = 0; row < board.numrows(); row++) {
-                cout << '|';
-                for (size_t col = 0; col < board.numcols(row); col++) {
-                    cout << board(row,col)->display();
-                }
-                cout << '|';
-                cout << endl;
+            if (on && multiHero) {
+                throw logic_error("GameBoard setTrackThreats -> the threat map follows a single hero");
             }
-            cout << '-';
-            for (size_t col = 0; col < board.numcols(0); col++) {
-                cout << '-';
+            if (on && scheduled) {
+                throw logic_error("GameBoard setTrackThreats -> the threat map assumes every baddie moves once a turn");
             }
-            cout << '-';
-            cout << endl;
-            
+            trackThreats = on;
+            threats.reset(0, 0);
+            sortBaddieCells();
+            rebuildThreats();
         }
-		
-        bool getWonGame() {
-            return wonGame;
+
+        // where the hero would be caught right now (valid until the board changes), NULL unless tracked
+        virtual const ThreatMap* getThreats() {
+            return trackThreats ? &threats : NULL;
         }
-        
-        // distributing total number of monsters so that 
+
+        // distributing total number of monsters so that
         //  ~1/3 of num are Super Monsters (M), and
         //  ~2/3 of num are Regular Monsters (m)
-        void setNumMonsters(int num) {
+        virtual void setNumMonsters(int num) {
             numSuperMonsters = num/3;
             numMonsters = num - numSuperMonsters;
         }
 
-        void setNumAbysses(int num) {
+        virtual void setNumAbysses(int num) {
             numAbysses = num;
         }
 
-        void setNumBats(int num) {
+        virtual void setNumBats(int num) {
             numBats = num;
         }
 
-        size_t getNumRows() {
-            return numRows;
+        virtual size_t getNumRows() {
+            return rows();
         }
 
-        size_t getNumCols() {
-            return numCols;
+        virtual size_t getNumCols() {
+            return cols();
         }
 
         
@@ -259,7 +1581,7 @@ class GameBoard {
 	    //      int HeroCol;
         // note: row and col are passed-by-reference
         //---------------------------------------------------------------------------------
-        void getHeroPosition(size_t& row, size_t& col) {
+        virtual void getHeroPosition(size_t& row, size_t& col) {
             row = this->HeroRow;
             col = this->HeroCol;
         }
@@ -287,26 +1609,46 @@ class GameBoard {
         // this function should find Hero in board and update
         //      HeroRow and HeroCol with the Hero's updated position;
         // if Hero cannot be found in board, then set Hero's position to (-1,-1)
+        //
+        // put() keeps track of the hero's cell, so only a board with several heroes on
+        // it has to look for the first one (row after row). In multi-hero mode the hero
+        // is the one with the lowest id still playing, read from the hero index.
         //---------------------------------------------------------------------------------
         void findHero() {
-            
-            for(size_t r = 0; r < this->board.numrows(); r++){
-
-                for(size_t c = 0; c < this->board.numcols(r); c++){
-                    
-                    if(this->board(r, c)->display() == 'H'){
-                        this->HeroRow = r;
-                        this->HeroCol = c;
-                        setHeroPosition(r, c);
-                        return;
-                    }
+            TraceSpan span("findHero");
 
+            if(multiHero){
+                size_t k = 0;
+                while(k < activeHeroes.size() && !heroIndex.contains(activeHeroes[k])){
+                    k++;
                 }
+                if(k == activeHeroes.size()){
+                    setHeroPosition(-1, -1);
+                    return;
+                }
+                heroIndex.position(activeHeroes[k], HeroRow, HeroCol);
+                return;
+            }
 
+            if(numHeroes == 0){
+                setHeroPosition(-1, -1);
+                return;
             }
 
-            setHeroPosition(-1, -1);
-        
+            if(numHeroes > 1 || heroCell == NoCell){
+                scratchCells.clear();
+                Storage::nonEmptyCells(occupancy, scratchCells);
+                heroCell = NoCell;
+                for(size_t k = 0; k < scratchCells.size(); k++){
+                    size_t i = scratchCells[k];
+                    if(i < heroCell && tileAt(i / cols(), i % cols()) == TileHero){
+                        heroCell = i;
+                    }
+                }
+            }
+
+            setHeroPosition(heroCell / cols(), heroCell % cols());
+
         }
 
         /*
@@ -315,161 +1657,240 @@ class GameBoard {
         */
         bool moveBaddies(){
 
+            if (scheduled) {
+                return runBeats();
+            }
+
+            TraceSpan span("moveBaddies");
             bool gotHero = false;
 
-            // Traverse the board
-            for(size_t r = 0; r < board.numrows(); r++){
+            // Visit the baddies row after row as they stood when the round began. A baddie
+            // only ever lands on a cell once it has moved, so this moves them in the same
+            // order as a scan over the whole board would.
+            sortBaddieCells();
+            size_t numBaddies = baddieCells.size();  // cells baddies move onto are appended behind
+            for(size_t k = 0; k < numBaddies; k++){
+                moveBaddie(baddieCells[k] / cols(), baddieCells[k] % cols(), gotHero);
+            }
 
-                for(size_t c = 0; c < board.numcols(r); c++){
+            findHero();
+            return gotHero;
 
-                    if(board(r, c)->isBaddie() && board(r, c)->getMoved() == false){
+        }
 
-                        
-                        // TODO: at some point, update the myRow & myCol values in each monster object.
-                        size_t newR, newC;
-                        board(r, c)->attemptMoveTo(newR, newC, HeroRow, HeroCol);
+        /*
+            One baddie's part of a round: moves the baddie at (r, c) unless there is none there
+            or it already moved this round. Sets gotHero if it captured the hero.
+        */
+        void moveBaddie(size_t r, size_t c, bool& gotHero){
 
+            unsigned char tile = tileAt(r, c);
+            if(!isBaddieTile(tile) || cellAt(r, c)->getMoved()){
+                return;
+            }
 
-                        // 1. Baddie tries to move out-of-bounds in rows. 
-                        try {
-                            if (newR < 0 || newR >= numRows) { 
-                                throw runtime_error("Baddie trying to move out-of-bounds with an invalid row");
-                            } 
-                        }
-                        catch (runtime_error& excpt) {
-                            
-                            cout << excpt.what() << endl;
-                            newR = r;
-                            cout << "Changing row for Baddie position to stay in-bounds" << endl;
+            TraceSpan baddieSpan("moveBaddie");
+            baddieActions++;
 
-                        }
+            // 1.-3. Where the move lands after the edges, walls and the ladder
+            //       have had their say, and whether that is an abyss.
+            size_t heroR = HeroRow, heroC = HeroCol;
+            if (multiHero) {
+                nearestHero(r, c, heroR, heroC);
+            }
+            size_t newR, newC;
+            unsigned char move = (tile == TileBat) ? batMove(r, c, heroC, newR, newC)
+                                                   : monsterMove(tile, r, c, heroR, heroC, newR, newC);
+            if (verbose) {
+                reportMove(tile, r, c, move);
+            }
 
-                        // 2. Baddie tries to move out-of-bounds in columns. 
-                        try{
-                            if(newC < 0 || newC >= numCols){
-                                throw runtime_error("Baddie trying to move out-of-bounds with an invalid column");
-                            }
-                        }
-                        catch(runtime_error& excpt){
-                            cout << excpt.what() << endl;
-                            newC = c;
-                        }
+            // 4. Baddie Tries to move on an Abyss cell.
+            if(move & MoveIntoAbyss){
 
-                        // 3. Baddie tries to move on a Wall cell OR the escape cell.
-                        try{
-                            if(board(newR, newC)->display() == '+' || board(newR, newC)->display() == '*'){
-                                throw runtime_error("Baddie is trying to move on a Wall cell or Escape Cell");
-                            }
-                        }
-                        catch(runtime_error& excpt){
-
-                            cout << excpt.what() << endl;
-
-                            
-                            // Moving perfeclty horizontal to a wall
-                            if((newR == r && board(newR, newC)->display() == '+') || (newR == r && board(newR, newC)->display() == '*')){
-                                newC = c;
-                                newR = r;
-                            } // Moving perfeclty vertical to a wall
-                            else if((newC == c && board(newR, newC)->display() == '+') || (newC == c && board(newR, newC)->display() == '*')){
-                                newC = c;
-                                newR = r;
-                            } // Moving diagonal to a wall. 
-                            else{
-                                // 1. Horizontal Movement is ignored. 
-                                if(board(newR, c)->display() != '+' || board(newR, c)->display() != '*'){
-                                    newC = c;
-                                }
-                                else{
-                                    newR = r;
-                                    newC = c;
-                                }
-                                // Check if ignoring horizontal still hits a wall.
-                            }
-                        
-
-                            cout << "Changing Row and/or Column for Baddie position to avoid wall or escape cell" << endl;
+                if (verbose) logEvent(EventAbyss, tile, r, c);
+                replaceTile(r, c, TileEmpty);
+                return;
 
-                        }
+            }
 
-                        // 4. Baddie Tries to move on an Abyss cell.
-                        try{
-                            if(board(newR, newC)->display() == '#'){
-                                throw runtime_error("Baddie is trying to move on a abyss cell");
-                            }
-                        }
-                        catch(runtime_error& excpt){
+            // 5. Baddie moves into another baddie.
+            if((newR != r || newC != c) && isBaddieTile(tileAt(newR, newC))){
 
-                            cout << excpt.what() << endl;
-                            delete board(r, c);
-                            board(r, c) = new Nothing(r, c);
-                            continue;
+                if(collisionPolicy != CollisionLegacy){
+                    if (verbose) logEvent(EventCollision, tile, r, c);
+                    resolveCollision(r, c, newR, newC);
+                    return;
+                }
+                // legacy: the move below replaces the other baddie
+                collisions[CollisionLegacy]++;
 
-                        }
+            }
 
-                        // 5. TODO: Do we need this? -> Baddie moves into another baddie
+            // 6. Baddie moves into the hero.
+            if(tileAt(newR, newC) == TileHero){
 
-                        // 6. Baddie moves into the hero.
-                        try{
-                            if(board(newR, newC)->display() == 'H'){
-                                throw runtime_error("Baddie is trying to move on the hero cell");
-                            }
-                        }
-                        catch(runtime_error& excpt){
-
-                            cout << excpt.what() << endl;
-                            board(r, c)->setMoved(true);
-                            delete board(newR, newC);
-                            BoardCell* temp = board(r, c);
-                            board(newR, newC) = temp;
-                            board(r, c) = new Nothing(r, c);
-                            this->wonGame = false;
-                            gotHero = true;
-                            continue;
+                if (verbose) logEvent(EventCapture, tile, r, c);
+                cellAt(r, c)->setMoved(true);
+                if (multiHero) {
+                    endHero(heroIndex.heroAt(newR, newC), outcomeOfBaddie(tile));
+                }
+                else if (!gotHero) {
+                    setOutcome(outcomeOfBaddie(tileAt(r, c)), tileAt(r, c), newR * cols() + newC);
+                }
+                cellAt(r, c)->update(newR, newC);
+                relocate(r, c, newR, newC);
+                this->wonGame = false;
+                gotHero = true;
+                return;
 
-                        }
+            }
 
-                        // Set moved to true
-                        board(r, c)->setMoved(true);
+            // Set moved to true
+            cellAt(r, c)->setMoved(true);
 
-                        // Execture the move.
-                        if(newR == r && newC == c){
-                            // same position so no new move.
-                            continue;
-                        }
-                        else{
+            // Execture the move.
+            if(newR == r && newC == c){
+                // same position so no new move.
+                return;
+            }
+            else{
 
-                            board(r, c)->update(newR, newC);
-    
-                            delete board(newR, newC);
-                            BoardCell* temp = board(r, c);
-                            board(newR, newC) = temp;
-                            board(r, c) = new Nothing(r, c);
+                cellAt(r, c)->update(newR, newC);
+                relocate(r, c, newR, newC);
 
-                            
-                        }
+            }
 
-                    }
+        }
 
-                }
+        // the hero nearest to (r, c) in multi-hero mode; (r, c) itself once none is left,
+        // so the baddie stays where it is
+        void nearestHero(size_t r, size_t c, size_t& heroR, size_t& heroC) {
+            size_t id = heroIndex.nearest(r, c);
+            if (id == HeroIndex::NoHero) {
+                heroR = r;
+                heroC = c;
+                return;
+            }
+            heroIndex.position(id, heroR, heroC);
+        }
+
+        //---------------------------------------------------------------------------------
+        // unsigned char monsterMove(unsigned char tile, size_t r, size_t c, size_t heroR, size_t heroC,
+        //                           size_t& newR, size_t& newC)
+        //
+        // A monster steps 1 cell (a super monster 2) towards the hero at (heroR, heroC) in
+        // each direction where the hero is not level with it. The outcome is one lookup in
+        // the move tables.
+        //---------------------------------------------------------------------------------
+        unsigned char monsterMove(unsigned char tile, size_t r, size_t c, size_t heroR, size_t heroC, size_t& newR, size_t& newC) {
+            int step = (tile == TileSuperMonster) ? 2 : 1;
+            int dr = (heroR < r) ? -1 : (heroR > r ? 1 : 0);
+            int dc = (heroC < c) ? -1 : (heroC > c ? 1 : 0);
+            unsigned char move = moves.lookup(step == 2 ? MoveTables::Step2Table : MoveTables::Step1Table, r, c, dr, dc);
+            MoveTables::landing(move, r, c, dr, dc, step, newR, newC);
+            return move;
+        }
 
+        //---------------------------------------------------------------------------------
+        // unsigned char batMove(size_t r, size_t c, size_t heroC, size_t& newR, size_t& newC)
+        //
+        // A bat flies straight to the hero's column (heroC) in its own row. It can land
+        // anywhere in the row, so it has no table; it follows the same rules and returns
+        // the same flags as a table entry.
+        //---------------------------------------------------------------------------------
+        unsigned char batMove(size_t r, size_t c, size_t heroC, size_t& newR, size_t& newC) {
+            unsigned char flags = 0;
+            newR = r;
+            newC = heroC;
+            if (newC >= cols()) {
+                newC = c;
+                flags |= MoveColClamped;
+            }
+            unsigned char target = tileAt(newR, newC);
+            if (target == TileWall || target == TileLadder) {
+                newC = c;
+                flags |= MoveBlocked;
             }
+            if (tileAt(newR, newC) == TileAbyss) {
+                flags |= MoveIntoAbyss;
+            }
+            return flags | (newC == c ? MoveStay : MoveHorizontal);
+        }
 
-            findHero();
-            return gotHero;
+        // pushes one event to the event log, if there is one and it wants the type
+        void logEvent(GameEventType type, unsigned char actor, size_t r, size_t c, unsigned char move = 0) {
+            if (eventLog == NULL || !eventLog->wants(type)) {
+                return;
+            }
+            GameEvent e = GameEvent();
+            e.source = eventSource;
+            e.row = (unsigned)r;
+            e.col = (unsigned)c;
+            e.type = type;
+            e.actor = actor;
+            e.move = move;
+            eventLog->push(e);
+        }
 
+        // the clamps and deflections of a move that actor made from (r, c)
+        void reportMove(unsigned char actor, size_t r, size_t c, unsigned char move) {
+            if (move & (MoveRowClamped | MoveColClamped)) {
+                logEvent(EventClamp, actor, r, c, move);
+            }
+            if (move & MoveBlocked) {
+                logEvent(EventDeflect, actor, r, c, move);
+            }
         }
 
-        void setBaddieMovedToFalse(){
+        //---------------------------------------------------------------------------------
+        // void resolveCollision(size_t r, size_t c, size_t newR, size_t newC)
+        //
+        // The baddie at (r, c) wants to move onto the baddie at (newR, newC). Resolves
+        // it with the current (non-legacy) policy and counts it. Both baddies are marked
+        // as moved, so a swapped or merged baddie does not get a second move this round.
+        //---------------------------------------------------------------------------------
+        void resolveCollision(size_t r, size_t c, size_t newR, size_t newC) {
+
+            collisions[collisionPolicy]++;
+
+            if (collisionPolicy == CollisionSwap) {
+                BoardCell* mover = cellAt(r, c);
+                BoardCell* other = cellAt(newR, newC);
+                unsigned char moverTile = tileAt(r, c);
+                unsigned char otherTile = tileAt(newR, newC);
+                mover->update(newR, newC);
+                other->update(r, c);
+                mover->setMoved(true);
+                other->setMoved(true);
+                put(newR, newC, mover, moverTile);
+                put(r, c, other, otherTile);
+                if (scheduled && other->getAsleep()) {
+                    // file it again under the bucket it was pushed into
+                    putToSleep(other);
+                }
+            }
+            else if (collisionPolicy == CollisionMerge) {
+                replaceTile(r, c, TileEmpty);
+                replaceTile(newR, newC, TileSuperMonster);
+                cellAt(newR, newC)->setMoved(true);
+            }
+            else {
+                cellAt(r, c)->setMoved(true);
+            }
 
-            for(size_t r = 0; r < numRows; r++){
-                for(size_t c = 0; c < numCols; c++){
+        }
 
-                    if(board(r, c)->isBaddie()){
-                        board(r, c)->setMoved(false);
-                    }
+        void setBaddieMovedToFalse(){
+            if (scheduled) {
+                // runBeats() clears the flag of the baddies due on each beat
+                return;
+            }
+            TraceSpan span("setBaddieMovedToFalse");
 
-                }
+            sortBaddieCells();
+            for(size_t k = 0; k < baddieCells.size(); k++){
+                cellAt(baddieCells[k] / cols(), baddieCells[k] % cols())->setMoved(false);
             }
 
         }
@@ -479,124 +1900,68 @@ class GameBoard {
             input heroNextMove deicision. The function returns true if the hero is still on the board
             at the end of the round & false if the hero is not on the board at the end of the round.
         */
-        bool makeMoves(char HeroNextMove) {
-
-
-            // determine where hero proposes to move to
-            setBaddieMovedToFalse();
-            size_t newR, newC;
-            board(HeroRow,HeroCol)->setNextMove(HeroNextMove);
-            board(HeroRow,HeroCol)->attemptMoveTo(newR,newC,HeroRow,HeroCol);
-
-            // 1. Hero tries to move out-of-bounds in rows. 
-            
-            try {
-                // hero attempts to move out-of-bounds in rows
-                if (newR < 0 || newR >= numRows) { 
-                    throw runtime_error("Hero trying to move out-of-bounds with an invalid row");
-                } 
-            }
-            catch (runtime_error& excpt) {
-                
-                cout << excpt.what() << endl;
-                newR = HeroRow;
-                cout << "Changing row for Hero position to stay in-bounds" << endl;
+        virtual bool makeMoves(char HeroNextMove) {
 
+            if (multiHero) {
+                throw logic_error("GameBoard makeMoves -> a multi-hero board is played with makeTick()");
             }
-
-            // 2. Hero tries to move out-of-bounds in columns. 
-            try{
-                if(newC < 0 || newC >= numCols){
-                    throw runtime_error("Hero trying to move out-of-bounds with an invalid column");
-                }
-            }
-            catch(runtime_error& excpt){
-                cout << excpt.what() << endl;
-                newC = HeroCol;
-            }
-
-            // 3. Hero tries to move on a Wall cell. 
-            try{
-                if(board(newR, newC)->display() == '+'){
-                    throw runtime_error("Hero is trying to move on a Wall cell");
-                }
+            if (HeroRow >= rows() || HeroCol >= cols()) {
+                throw out_of_range("GameBoard makeMoves -> the hero is not on the board");
             }
-            catch(runtime_error& excpt){
 
-                cout << excpt.what() << endl;
+            TraceSpan span("makeMoves");
+            beginUndoTurn();
+            bool alive = playTurn(HeroNextMove);
+            recordingTurn = false;
+            return alive;
 
-                
-                // Moving perfeclty horizontal to a wall
-                if(newR == HeroRow && board(newR, newC)->display() == '+'){
-                    newC = HeroCol;
-                    newR = HeroRow;
-                } // Moving perfeclty vertical to a wall
-                else if(newC == HeroCol && board(newR, newC)->display() == '+'){
-                    newC = HeroCol;
-                    newR = HeroRow;
-                } // Moving diagonal to a wall. 
-                else{
-                    // 1. Horizontal Movement is ignored. 
-                    if(board(newR, HeroCol)->display() != '+'){
-                        newC = HeroCol;
-                    }
-                    else{
-                        newR = HeroRow;
-                        newC = HeroCol;
-                    }
-                    // Check if ignoring horizontal still hits a wall.
-                }
-            
+        }
 
-                cout << "Changing Row and/or Column for Hero position to avoid wall" << endl;
+        // one round of makeMoves(), the hero known to be on the board
+        bool playTurn(char HeroNextMove) {
 
+            // 1.-3. Where the hero lands after the edges and walls have had their say.
+            setBaddieMovedToFalse();
+            TraceSpan heroSpan("moveHero");
+            int dr, dc;
+            heroDirection(HeroNextMove, dr, dc);
+            unsigned char move = moves.lookup(MoveTables::HeroTable, HeroRow, HeroCol, dr, dc);
+            size_t newR, newC;
+            MoveTables::landing(move, HeroRow, HeroCol, dr, dc, 1, newR, newC);
+            if (verbose) {
+                reportMove(TileHero, HeroRow, HeroCol, move);
             }
 
             // 4. Hero reaches escape ladder.
-            try{
-                if(board(newR, newC)->display() == '*'){
-                    throw runtime_error("Hero is trying to escape");
-                }
-            }
-            catch(runtime_error& excpt){
+            if(move & MoveOntoLadder){
 
-                cout << excpt.what() << endl;
+                if (verbose) logEvent(EventEscape, TileHero, HeroRow, HeroCol);
                 findHero();
-                delete board(HeroRow, HeroCol);
-                board(HeroRow, HeroCol) = new Nothing(HeroRow, HeroCol);
+                replaceTile(HeroRow, HeroCol, TileEmpty);
                 this->wonGame = true;
+                setOutcome(OutcomeEscaped, TileLadder, newR * cols() + newC);
                 return false;
 
             }
 
-            // 5. Hero tries to move on an abyss cell. 
-            try{
-                if(board(newR, newC)->display() == '#'){
-                    throw runtime_error("Hero is trying to move on a abyss cell");
-                }
-            }
-            catch(runtime_error& excpt){
+            // 5. Hero tries to move on an abyss cell.
+            if(move & MoveIntoAbyss){
 
-                cout << excpt.what() << endl;
-                delete board(HeroRow, HeroCol);
-                board(HeroRow, HeroCol) = new Nothing(HeroRow, HeroCol);
+                if (verbose) logEvent(EventAbyss, TileHero, HeroRow, HeroCol);
+                replaceTile(HeroRow, HeroCol, TileEmpty);
+                setOutcome(OutcomeAbyss, TileAbyss, newR * cols() + newC);
                 findHero();
                 return false;
 
             }
 
             // 6. Hero tries to move on a baddie.
-            try{
-                if(board(newR, newC)->isBaddie()){
-                    throw runtime_error("Hero is trying to move on a baddie cell");
-                }
-            }
-            catch(runtime_error& excpt){
+            if(isBaddieTile(tileAt(newR, newC))){
 
-                cout << excpt.what() << endl;
+                if (verbose) logEvent(EventCapture, TileHero, HeroRow, HeroCol);
+                setOutcome(outcomeOfBaddie(tileAt(newR, newC)), tileAt(newR, newC), newR * cols() + newC);
                 findHero();
-                delete board(HeroRow, HeroCol);
-                board(HeroRow, HeroCol) = new Nothing(HeroRow, HeroCol);
+                replaceTile(HeroRow, HeroCol, TileEmpty);
                 return false;
 
             }
@@ -606,19 +1971,17 @@ class GameBoard {
 
             if(newR == HeroRow && newC == HeroCol){
                 findHero();
-                // Move baddies
-                moveBaddies();
-                return true;
+                heroSpan.end();
+                // Move baddies, the hero can still be captured while standing still
+                return !moveBaddies();
             }
             else{
-                board(HeroRow, HeroCol)->update(newR, newC);
-                delete board(newR, newC);
-                BoardCell* temp = board(HeroRow, HeroCol);
-                board(newR, newC) = temp;
-                board(HeroRow, HeroCol) = new Nothing(HeroRow, HeroCol);
+                cellAt(HeroRow, HeroCol)->update(newR, newC);
+                relocate(HeroRow, HeroCol, newR, newC);
 
                 findHero();
             }
+            heroSpan.end();
 
             // Move baddies
             bool baddieGotHero = moveBaddies();
@@ -632,7 +1995,254 @@ class GameBoard {
 
         }
 
+        /*
+            Plays a whole script of hero moves back to back, e.g. "dddxxcce". Diagnostics are
+            turned off for the run and nothing is displayed. Stops on the turn the game ended.
+            turnsPlayed is set to the number of moves executed, and the return value has the
+            same meaning as makeMoves(): true if the hero is still on the board.
+        */
+        virtual bool runMoves(const string& moves, size_t& turnsPlayed) {
+
+            bool wasVerbose = verbose;
+            verbose = false;
+
+            bool alive = true;
+            turnsPlayed = 0;
+            while (alive && turnsPlayed < moves.size()) {
+                alive = makeMoves(moves[turnsPlayed]);
+                turnsPlayed++;
+            }
+
+            verbose = wasVerbose;
+            return alive;
+
+        }
+
+        //---------------------------------------------------------------------------------
+        // void setMultiHero(bool on, size_t bucketSide)
+        //
+        // Turns multi-hero mode on or off. Turning it on gives every hero on the board an
+        // id, row after row, and so does every setup after that. bucketSide is the side
+        // of the HeroIndex buckets, 0 to let the index pick it. Throws logic_error if fog
+        // of war, the threat map or undo is on.
+        //---------------------------------------------------------------------------------
+        virtual void setMultiHero(bool on, size_t bucketSide) {
+            if (on && (view.getRadius() > 0 || trackThreats || !undoTurns.empty())) {
+                throw logic_error("GameBoard setMultiHero -> fog of war, threats and undo follow a single hero");
+            }
+            multiHero = on;
+            heroBucketSide = bucketSide;
+            heroIndex.reset(0, 0, 0);
+            heroOutcomes.clear();
+            activeHeroes.clear();
+            if (on) {
+                rebuildHeroes();
+            }
+            else {
+                heroCell = NoCell;
+                findHero();
+            }
+        }
+
+        //---------------------------------------------------------------------------------
+        // size_t addHero(size_t row, size_t col)
+        //
+        // Puts one more hero on the empty cell (row, col) of a multi-hero board and
+        // returns its id. It plays from the next makeTick() on.
+        //---------------------------------------------------------------------------------
+        virtual size_t addHero(size_t row, size_t col) {
+            if (!multiHero) {
+                throw logic_error("GameBoard addHero -> the board is not in multi-hero mode");
+            }
+            if (row >= rows() || col >= cols()) {
+                throw out_of_range("GameBoard addHero -> cell is off the board");
+            }
+            if (tileAt(row, col) != TileEmpty) {
+                throw invalid_argument("GameBoard addHero -> cell is not empty");
+            }
+            replaceTile(row, col, TileHero);
+            size_t id = indexHero(row, col);
+            findHero();
+            return id;
+        }
+
+        //---------------------------------------------------------------------------------
+        // size_t makeTick(const char* heroMoves)
+        //
+        // Plays one round of a multi-hero board. Every hero still playing makes its move,
+        // heroMoves[id] (one per id getNumHeroes() handed out), lowest id first, under
+        // the same rules as makeMoves(); a hero that would step onto another hero stays
+        // where it is. Then every baddie moves once, row after row, towards the hero
+        // nearest to it as the heroes stand at that moment. Returns the number of heroes
+        // still playing. getOutcome() and friends are left as they are; every hero's
+        // own result is read with getHeroOutcome().
+        //---------------------------------------------------------------------------------
+        virtual size_t makeTick(const char* heroMoves) {
+            if (!multiHero) {
+                throw logic_error("GameBoard makeTick -> the board is not in multi-hero mode");
+            }
+            TraceSpan span("makeTick");
+            setBaddieMovedToFalse();
+            TraceSpan heroSpan("moveHeroes");
+            for (size_t k = 0; k < activeHeroes.size(); k++) {
+                moveHero(activeHeroes[k], heroMoves[activeHeroes[k]]);
+            }
+            heroSpan.end();
+            if (heroIndex.size() > 0) {
+                moveBaddies();
+            }
+            size_t kept = 0;
+            for (size_t k = 0; k < activeHeroes.size(); k++) {
+                if (heroOutcomes[activeHeroes[k]] == OutcomePlaying) {
+                    activeHeroes[kept++] = activeHeroes[k];
+                }
+            }
+            activeHeroes.resize(kept);
+            findHero();
+            return kept;
+        }
+
+        // one hero's part of makeTick()
+        void moveHero(size_t id, char heroNextMove) {
+            size_t r, c;
+            heroIndex.position(id, r, c);
+            int dr, dc;
+            heroDirection(heroNextMove, dr, dc);
+            unsigned char move = moves.lookup(MoveTables::HeroTable, r, c, dr, dc);
+            size_t newR, newC;
+            MoveTables::landing(move, r, c, dr, dc, 1, newR, newC);
+            if (verbose) {
+                reportMove(TileHero, r, c, move);
+            }
+            unsigned char target = tileAt(newR, newC);
+            if (move & MoveOntoLadder) {
+                if (verbose) logEvent(EventEscape, TileHero, r, c);
+                replaceTile(r, c, TileEmpty);
+                endHero(id, OutcomeEscaped);
+            }
+            else if (move & MoveIntoAbyss) {
+                if (verbose) logEvent(EventAbyss, TileHero, r, c);
+                replaceTile(r, c, TileEmpty);
+                endHero(id, OutcomeAbyss);
+            }
+            else if (isBaddieTile(target)) {
+                if (verbose) logEvent(EventCapture, TileHero, r, c);
+                replaceTile(r, c, TileEmpty);
+                endHero(id, outcomeOfBaddie(target));
+            }
+            else if (target != TileHero) {
+                cellAt(r, c)->update(newR, newC);
+                relocate(r, c, newR, newC);
+                heroIndex.move(id, newR, newC);
+            }
+        }
+
+        //---------------------------------------------------------------------------------
+        // void setActionSchedule(const ActionSchedule& schedule)
+        //
+        // Sets how often the hero and each kind of baddie act, in beats, and the wake
+        // radius. Every baddie goes back on the wheel a full interval from now (or to
+        // sleep, with a wake radius), and so does every baddie after each setup. The
+        // default ActionSchedule is the original lockstep game. Throws invalid_argument
+        // for an interval of 0 and logic_error if the threat map or undo is on.
+        //---------------------------------------------------------------------------------
+        virtual void setActionSchedule(const ActionSchedule& newSchedule) {
+            if (newSchedule.hero == 0 || newSchedule.monster == 0 || newSchedule.superMonster == 0 || newSchedule.bat == 0) {
+                throw invalid_argument("GameBoard setActionSchedule -> every interval has to be at least 1 beat");
+            }
+            if (!newSchedule.lockstep() && (trackThreats || !undoTurns.empty())) {
+                throw logic_error("GameBoard setActionSchedule -> the threat map and undo assume lockstep");
+            }
+            schedule = newSchedule;
+            scheduled = !schedule.lockstep();
+            wheel.reset(0);
+            sleepers.clear();
+            sortBaddieCells();
+            rebuildSchedule();
+        }
+
+        virtual ActionSchedule getActionSchedule() {
+            return schedule;
+        }
+
+        // baddie moves since the board was set up (a baddie that could not move counts too)
+        virtual unsigned long getBaddieActions() {
+            return baddieActions;
+        }
+
+        // heroes handed an id since multi-hero mode was turned on or the board was set up
+        virtual size_t getNumHeroes() {
+            return heroOutcomes.size();
+        }
+
+        // heroes of a multi-hero board still playing
+        virtual size_t getPlayingHeroes() {
+            return heroIndex.size();
+        }
+
+        virtual GameOutcome getHeroOutcome(size_t id) {
+            if (id >= heroOutcomes.size()) {
+                throw out_of_range("GameBoard getHeroOutcome -> no hero with this id");
+            }
+            return heroOutcomes[id];
+        }
+
+        // where hero id stands, (-1, -1) once it stopped playing
+        virtual void getHeroPosition(size_t id, size_t& row, size_t& col) {
+            if (id >= heroOutcomes.size()) {
+                throw out_of_range("GameBoard getHeroPosition -> no hero with this id");
+            }
+            row = col = (size_t)-1;
+            if (heroIndex.contains(id)) {
+                heroIndex.position(id, row, col);
+            }
+        }
+
+    private:
+        BasicGameBoard(const BasicGameBoard&);
+        BasicGameBoard& operator=(const BasicGameBoard&);
     
 };
 
+// runtime-sized board (any size main.cpp accepts)
+typedef BasicGameBoard< Grid<BoardCell*> > GameBoard;
+
+// compile-time sized board
+template<size_t R, size_t C>
+using FixedGameBoard = BasicGameBoard< FixedGrid<BoardCell*, R, C> >;
+
+// board stored in chunks, for huge and mostly empty worlds
+typedef BasicGameBoard< ChunkedGrid<BoardCell*> > SparseGameBoard;
+
+// boards with more squares than this are made as a SparseGameBoard by makeGameBoard()
+static const size_t kSparseBoardCells = (size_t)1 << 20;
+
+//---------------------------------------------------------------------------------
+// GameBoardBase* makeGameBoard(size_t rows, size_t cols)
+//
+// Returns a heap allocated board of the given size, using a compile-time sized
+// board for the sizes most games are played on, SparseGameBoard for boards of
+// more than kSparseBoardCells squares and GameBoard for everything else. The
+// caller owns the returned board.
+//---------------------------------------------------------------------------------
+inline GameBoardBase* makeGameBoard(size_t rows, size_t cols) {
+    if (rows == 15 && cols == 40) {
+        return new FixedGameBoard<15, 40>(rows, cols);
+    }
+    if (rows == 30 && cols == 100) {
+        return new FixedGameBoard<30, 100>(rows, cols);
+    }
+    if (cols > 0 && rows > kSparseBoardCells / cols) {
+        return new SparseGameBoard(rows, cols);
+    }
+    return new GameBoard(rows, cols);
+}
+
+// builds a Terrain from the layout board is set up with right now
+inline SharedTerrain terrainOfBoard(GameBoardBase& board) {
+    vector<unsigned char> layout(board.getNumRows() * board.getNumCols());
+    board.getTiles(&layout[0]);
+    return makeTerrain(board.getNumRows(), board.getNumCols(), &layout[0]);
+}
+
 #endif //_GAMEBOARD_H
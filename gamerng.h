@@ -0,0 +1,75 @@
+/*
+    Filename: "gamerng.h"
+    Author: Viraj Saudagar
+
+    This file defines the GameRng class, the random number generator used
+    by setupBoard(). It produces exactly the sequence glibc's srand()/rand()
+    produce (the additive feedback generator behind random(), degree 31,
+    separation 3), so every seed keeps generating the layout it always did.
+    Unlike rand() the state lives in the object, which lets many boards be
+    set up at the same time on different threads.
+
+*/
+
+#ifndef _GAMERNG_H
+#define _GAMERNG_H
+
+#include <stdint.h>
+
+class GameRng {
+    private:
+        static const int kDegree = 31;
+        static const int kSeparation = 3;
+
+        uint32_t state[kDegree];
+        int front;  // index of the tap that is updated (glibc's fptr)
+        int rear;   // index of the other tap (glibc's rptr)
+
+    public:
+        static const int kMax = 2147483647;  // same as RAND_MAX with glibc
+
+        explicit GameRng(unsigned int seed = 1) {
+            reseed(seed);
+        }
+
+        // same as srand(seed)
+        void reseed(unsigned int seed) {
+            if (seed == 0) {
+                seed = 1;
+            }
+
+            // state[i] = (16807 * state[i - 1]) % 2147483647 without overflowing 31 bits
+            int32_t word = (int32_t)seed;
+            state[0] = (uint32_t)word;
+            for (int i = 1; i < kDegree; i++) {
+                int32_t hi = word / 127773;
+                int32_t lo = word % 127773;
+                word = 16807 * lo - 2836 * hi;
+                if (word < 0) {
+                    word += 2147483647;
+                }
+                state[i] = (uint32_t)word;
+            }
+
+            front = kSeparation;
+            rear = 0;
+            for (int i = 0; i < 10 * kDegree; i++) {
+                next();
+            }
+        }
+
+        // same as rand(), a value in [0, kMax]
+        int next() {
+            state[front] += state[rear];
+            int result = (int)(state[front] >> 1);
+            front = (front + 1 == kDegree) ? 0 : front + 1;
+            rear = (rear + 1 == kDegree) ? 0 : rear + 1;
+            return result;
+        }
+
+        int operator()() {
+            return next();
+        }
+};
+
+#endif //_GAMERNG_H
@@ -0,0 +1,893 @@
+/*
+    Filename: "gameserver.h"
+    Author: Viraj Saudagar
+
+    This file defines the GameServer class which hosts many GameBoard
+    sessions inside of one process. Clients connect over a Unix domain
+    socket and speak a line protocol (one command per line):
+
+        NEW <rows> <cols> <abysses> <monsters> <bats> <seed>  -> CREATED <id>
+        LEVEL [<n>]                                           -> CREATED <id>
+        MOVE <id> <move>                                      -> MOVED <id> <alive> <won>
+        FRAME <id>                                            -> FRAME <id> <rows> <cols>, then <rows> lines
+        DIFF <id>                                             -> DIFF <id> <n> [<r> <c> <tile>]...
+        WATCH <id>                                            -> WATCHING <id>, then stream frames
+        UNWATCH <id>                                          -> UNWATCHED <id>
+        END <id>                                              -> ENDED <id>
+        STATS                                                 -> STATS sessions=.. moves=.. cpu_ms=.. workers=..
+
+    LEVEL starts a game on level n (or a random level) of the level library
+    given to setLevelLibrary(), so no board has to be generated and checked
+    while the server is under load.
+
+    Sessions started on the same layout (LEVEL with the same level, or NEW
+    with the same parameters and a seed >= 0) share one Terrain (see
+    terrain.h) for as long as any of them is alive, so every extra session
+    only costs its own cells and entities.
+
+    With setEventLog() every session reports its game events (see
+    eventlog.h), tagged with the session id, without the worker thread
+    ever waiting on the log's file.
+
+    MOVE, FRAME, DIFF and END are only taken from the connection that
+    created the session (FRAME and DIFF share one baseline per session, so
+    a stranger's DIFF would skew the owner's); anyone else is answered
+    with "ERR <id> not your session". WATCH and UNWATCH are open to every
+    connection, so any client that knows a session id can spectate it.
+
+    Empty cells are sent as '.' so every tile is a single visible token.
+    DIFF lists the cells that changed since the last FRAME or DIFF for that
+    session. Failures are answered with "ERR <id|-> <message>".
+
+    A spectator that WATCHes a session gets a keyframe right away and then
+    one delta per move, each sent as the line "STREAM <id>" followed by one
+    binary frame (see deltastream.h); ENDED is sent when the game is ended.
+    Each frame is encoded once and the same buffer is queued on every
+    watching connection, so the cost of a move barely grows with the number
+    of spectators.
+
+    One thread runs an epoll loop that owns every socket and the session
+    table. Commands that touch a session are queued on that session and a
+    WorkerPool thread drains the queue, so commands for one session run in
+    the order they arrived while different sessions run in parallel.
+    Replies for different sessions may come back in any order, which is why
+    every reply carries its session id.
+
+*/
+
+#ifndef _GAMESERVER_H
+#define _GAMESERVER_H
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <sstream>
+#include <deque>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+
+#include "gameboard.h"
+#include "workerpool.h"
+#include "levellibrary.h"
+#include "gamerng.h"
+#include "deltastream.h"
+
+using namespace std;
+
+class GameServer {
+    private:
+        // One queued command for a session. conn == 0 means nobody is waiting for the reply.
+        struct SessionCommand {
+            unsigned long long conn;
+            char kind;   // 'M' = move, 'F' = frame, 'D' = diff, 'E' = end, 'W' = watch, 'U' = unwatch
+            char move;
+        };
+
+        struct GameSession {
+            size_t id;
+            unsigned long long owner;
+            GameBoardBase* board;
+            string lastFrame;  // tiles as of the last FRAME/DIFF, used to compute DIFF
+            bool over;
+            bool ended;        // END ran; every later command is refused
+            unique_ptr<DeltaEncoder> stream;   // only while someone is watching
+            set<unsigned long long> watchers;  // connections that get the stream
+
+            mutex lock;        // guards pending & scheduled
+            deque<SessionCommand> pending;
+            bool scheduled;    // true while a worker task owns this session
+
+            GameSession() : id(0), owner(0), board(NULL), over(false), ended(false), scheduled(false) {}
+            ~GameSession() { stream.reset(); delete board; }
+        };
+
+        // A reply produced on a worker thread, handed back to the loop thread.
+        struct Reply {
+            unsigned long long conn;
+            string text;          // sent as a line unless empty
+            SharedFrame frame;    // sent after text when set, shared with other spectators
+            size_t endedSession;  // != 0 when the session should be dropped from the table
+            bool answer;          // true for the one reply to a command, false for what spectators get
+
+            Reply(unsigned long long c = 0, const string& t = "") : conn(c), text(t), endedSession(0), answer(false) {}
+        };
+
+        struct Connection {
+            int fd;
+            unsigned long long id;
+            string inbuf;
+            string outText;               // reply lines not yet moved to outQueue
+            deque<SharedFrame> outQueue;  // buffers to send, in order
+            size_t outOffset;             // bytes of outQueue.front() already sent
+            bool wantWrite;
+            bool draining;                // the client shut down its side; close once every answer is sent
+            size_t unanswered;            // commands queued on sessions whose reply has not come back
+            set<size_t> sessions;  // sessions created over this connection
+            set<size_t> watching;  // sessions this connection is a spectator of
+        };
+
+        string socketPath;
+        int listenFd;
+        int epollFd;
+        int wakeFd;   // eventfd, written by workers (and stop()) to wake the loop
+        WorkerPool workers;
+
+        unordered_map<size_t, shared_ptr<GameSession> > sessions;
+        unordered_map<int, Connection*> connsByFd;
+        unordered_map<unsigned long long, Connection*> connsById;
+        size_t nextSessionId;
+        unsigned long long nextConnId;
+
+        mutex replyLock;
+        vector<Reply> replies;
+
+        const LevelLibrary* levels;  // optional, used by LEVEL
+        GameRng levelPicker;
+        EventLog* eventLog;          // optional, every session's game events tagged with its id
+
+        unordered_map<string, weak_ptr<const Terrain> > terrains;  // layout key -> terrain of live sessions
+        size_t terrainPruneAt;  // expired entries are dropped when terrains grows this big
+
+        atomic<bool> stopping;
+        atomic<unsigned long long> movesProcessed;
+
+        static const size_t kMaxLineLength = 4096;
+        static const size_t kMaxBatchPerTask = 32;
+        static const size_t kMaxQueuedBuffers = 4096;  // a spectator this far behind is dropped
+
+        void wakeLoop() {
+            unsigned long long one = 1;
+            ssize_t ignored = write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+
+        //---------------------------------------------------------------------------------
+        // Terrain sharing. Only the loop thread creates sessions, so no lock is needed.
+        //---------------------------------------------------------------------------------
+        SharedTerrain findTerrain(const string& key) {
+            unordered_map<string, weak_ptr<const Terrain> >::iterator found = terrains.find(key);
+            return found == terrains.end() ? SharedTerrain() : found->second.lock();
+        }
+
+        void rememberTerrain(const string& key, const SharedTerrain& terrain) {
+            if (terrains.size() >= terrainPruneAt) {
+                for (unordered_map<string, weak_ptr<const Terrain> >::iterator it = terrains.begin(); it != terrains.end(); ) {
+                    if (it->second.expired()) {
+                        it = terrains.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+                terrainPruneAt = 2 * terrains.size() + 64;
+            }
+            terrains[key] = terrain;
+        }
+
+        //---------------------------------------------------------------------------------
+        // Board text helpers. These only run on the worker that currently owns the session.
+        //---------------------------------------------------------------------------------
+        static char tileToken(char tile) {
+            return tile == ' ' ? '.' : tile;
+        }
+
+        static string boardTiles(GameBoardBase& board) {
+            string tiles(board.getNumRows() * board.getNumCols(), ' ');
+            board.renderTo(&tiles[0], board.getNumCols());
+            for (size_t i = 0; i < tiles.size(); i++) {
+                tiles[i] = tileToken(tiles[i]);
+            }
+            return tiles;
+        }
+
+        // a "STREAM <id>" line followed by the next frame (or a keyframe) of the session
+        static SharedFrame streamFrame(GameSession& s, bool keyframe) {
+            ostringstream header;
+            header << "STREAM " << s.id << '\n';
+            string line = header.str();
+            shared_ptr<FrameBuffer> frame(new FrameBuffer(line.begin(), line.end()));
+            if (keyframe) {
+                s.stream->keyframe(*frame, s.over);
+            }
+            else {
+                s.stream->nextFrame(*frame, s.over);
+            }
+            return frame;
+        }
+
+        // runs one command and appends its reply (plus anything for spectators) to produced
+        void executeCommand(GameSession& s, const SessionCommand& cmd, vector<Reply>& produced) {
+            ostringstream out;
+            size_t endedSession = 0;
+            size_t firstSpectatorReply = produced.size();
+
+            if (s.ended) {
+                // commands queued behind END never reach the board
+                out << "ERR " << s.id << " session ended";
+                produced.push_back(Reply(cmd.conn, out.str()));
+                produced.back().answer = true;
+                return;
+            }
+
+            switch (cmd.kind) {
+                case 'M': {
+                    if (s.over) {
+                        out << "ERR " << s.id << " game over";
+                        break;
+                    }
+                    bool alive = s.board->makeMoves(cmd.move);
+                    s.over = !alive;
+                    movesProcessed++;
+                    out << "MOVED " << s.id << ' ' << (alive ? 1 : 0) << ' ' << (s.board->getWonGame() ? 1 : 0);
+
+                    if (s.stream) {
+                        SharedFrame frame = streamFrame(s, false);
+                        for (set<unsigned long long>::iterator it = s.watchers.begin(); it != s.watchers.end(); ++it) {
+                            produced.push_back(Reply(*it));
+                            produced.back().frame = frame;
+                        }
+                    }
+                    break;
+                }
+
+                case 'W': {
+                    if (!s.stream) {
+                        s.stream.reset(new DeltaEncoder(*s.board));
+                    }
+                    s.watchers.insert(cmd.conn);
+                    out << "WATCHING " << s.id;
+                    produced.push_back(Reply(cmd.conn, out.str()));
+                    produced.back().frame = streamFrame(s, true);
+                    produced.back().answer = true;
+                    return;
+                }
+
+                case 'U':
+                    s.watchers.erase(cmd.conn);
+                    if (s.watchers.empty()) {
+                        s.stream.reset();
+                    }
+                    out << "UNWATCHED " << s.id;
+                    break;
+
+                case 'F': {
+                    s.lastFrame = boardTiles(*s.board);
+                    size_t cols = s.board->getNumCols();
+                    out << "FRAME " << s.id << ' ' << s.board->getNumRows() << ' ' << cols;
+                    for (size_t r = 0; r < s.board->getNumRows(); r++) {
+                        out << '\n' << s.lastFrame.substr(r * cols, cols);
+                    }
+                    break;
+                }
+
+                case 'D': {
+                    string tiles = boardTiles(*s.board);
+                    size_t cols = s.board->getNumCols();
+                    ostringstream cells;
+                    size_t changed = 0;
+                    for (size_t i = 0; i < tiles.size(); i++) {
+                        if (i >= s.lastFrame.size() || tiles[i] != s.lastFrame[i]) {
+                            cells << ' ' << (i / cols) << ' ' << (i % cols) << ' ' << tiles[i];
+                            changed++;
+                        }
+                    }
+                    s.lastFrame.swap(tiles);
+                    out << "DIFF " << s.id << ' ' << changed << cells.str();
+                    break;
+                }
+
+                case 'E':
+                    out << "ENDED " << s.id;
+                    s.over = true;
+                    s.ended = true;
+                    endedSession = s.id;
+                    for (set<unsigned long long>::iterator it = s.watchers.begin(); it != s.watchers.end(); ++it) {
+                        if (*it != cmd.conn) {
+                            produced.push_back(Reply(*it, out.str()));
+                        }
+                    }
+                    break;
+
+                default:
+                    out << "ERR " << s.id << " unknown command";
+                    break;
+            }
+
+            // the reply to the command goes before what it sent to spectators
+            produced.insert(produced.begin() + firstSpectatorReply, Reply(cmd.conn, out.str()));
+            produced[firstSpectatorReply].endedSession = endedSession;
+            produced[firstSpectatorReply].answer = true;
+        }
+
+        // Worker task: drains up to kMaxBatchPerTask commands from one session,
+        // then requeues itself if more are waiting so one busy session cannot
+        // starve the others.
+        void runSession(shared_ptr<GameSession> s) {
+            vector<Reply> produced;
+
+            for (size_t n = 0; n < kMaxBatchPerTask; n++) {
+                SessionCommand cmd;
+                {
+                    lock_guard<mutex> guard(s->lock);
+                    if (s->pending.empty()) {
+                        s->scheduled = false;
+                        break;
+                    }
+                    cmd = s->pending.front();
+                    s->pending.pop_front();
+                }
+
+                executeCommand(*s, cmd, produced);
+
+                if (n + 1 == kMaxBatchPerTask) {
+                    workers.submit(bind(&GameServer::runSession, this, s));
+                }
+            }
+
+            if (!produced.empty()) {
+                {
+                    lock_guard<mutex> guard(replyLock);
+                    for (size_t i = 0; i < produced.size(); i++) {
+                        replies.push_back(produced[i]);
+                    }
+                }
+                wakeLoop();
+            }
+        }
+
+        void enqueue(shared_ptr<GameSession>& s, const SessionCommand& cmd) {
+            bool schedule = false;
+            {
+                lock_guard<mutex> guard(s->lock);
+                s->pending.push_back(cmd);
+                if (!s->scheduled) {
+                    s->scheduled = true;
+                    schedule = true;
+                }
+            }
+            if (schedule) {
+                workers.submit(bind(&GameServer::runSession, this, s));
+            }
+        }
+
+        //---------------------------------------------------------------------------------
+        // Loop-thread helpers
+        //---------------------------------------------------------------------------------
+        void send(Connection* conn, const string& line) {
+            conn->outText += line;
+            conn->outText += '\n';
+        }
+
+        // moves the pending reply lines into outQueue so they keep their place before later frames
+        void sealText(Connection* conn) {
+            if (!conn->outText.empty()) {
+                conn->outQueue.push_back(SharedFrame(new FrameBuffer(conn->outText.begin(), conn->outText.end())));
+                conn->outText.clear();
+            }
+        }
+
+        // queues a shared frame without copying it
+        void sendFrame(Connection* conn, const SharedFrame& frame) {
+            sealText(conn);
+            conn->outQueue.push_back(frame);
+        }
+
+        // a draining connection is no longer read from, so its EOF does not keep waking the loop
+        void updateInterest(Connection* conn, bool force = false) {
+            bool want = !conn->outQueue.empty();
+            if (want == conn->wantWrite && !force) {
+                return;
+            }
+            conn->wantWrite = want;
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = (conn->draining ? 0 : EPOLLIN) | (want ? EPOLLOUT : 0);
+            ev.data.fd = conn->fd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, conn->fd, &ev);
+        }
+
+        // returns false if the connection failed and was closed
+        bool flush(Connection* conn) {
+            sealText(conn);
+            if (conn->outQueue.size() > kMaxQueuedBuffers) {
+                closeConnection(conn);
+                return false;
+            }
+            while (!conn->outQueue.empty()) {
+                struct iovec iov[64];
+                struct msghdr msg;
+                memset(&msg, 0, sizeof(msg));
+                size_t count = min(conn->outQueue.size(), sizeof(iov) / sizeof(iov[0]));
+                for (size_t i = 0; i < count; i++) {
+                    const FrameBuffer& buf = *conn->outQueue[i];
+                    size_t skip = (i == 0) ? conn->outOffset : 0;
+                    iov[i].iov_base = (void*)(buf.data() + skip);
+                    iov[i].iov_len = buf.size() - skip;
+                }
+                msg.msg_iov = iov;
+                msg.msg_iovlen = count;
+
+                ssize_t n = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+                if (n > 0) {
+                    size_t sent = n;
+                    while (sent > 0) {
+                        size_t left = conn->outQueue.front()->size() - conn->outOffset;
+                        if (sent < left) {
+                            conn->outOffset += sent;
+                            break;
+                        }
+                        sent -= left;
+                        conn->outQueue.pop_front();
+                        conn->outOffset = 0;
+                    }
+                }
+                else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                }
+                else if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                else {
+                    closeConnection(conn);
+                    return false;
+                }
+            }
+            updateInterest(conn);
+            return true;
+        }
+
+        void acceptConnections() {
+            while (true) {
+                int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    return;
+                }
+                Connection* conn = new Connection();
+                conn->fd = fd;
+                conn->id = nextConnId++;
+                conn->outOffset = 0;
+                conn->wantWrite = false;
+                conn->draining = false;
+                conn->unanswered = 0;
+                connsByFd[fd] = conn;
+                connsById[conn->id] = conn;
+
+                struct epoll_event ev;
+                memset(&ev, 0, sizeof(ev));
+                ev.events = EPOLLIN;
+                ev.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+            }
+        }
+
+        // Closes the socket and ends every session the connection created.
+        void closeConnection(Connection* conn) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, NULL);
+            close(conn->fd);
+            for (set<size_t>::iterator it = conn->sessions.begin(); it != conn->sessions.end(); ++it) {
+                unordered_map<size_t, shared_ptr<GameSession> >::iterator found = sessions.find(*it);
+                if (found != sessions.end()) {
+                    SessionCommand end = {0, 'E', 's'};
+                    enqueue(found->second, end);
+                }
+            }
+            for (set<size_t>::iterator it = conn->watching.begin(); it != conn->watching.end(); ++it) {
+                unordered_map<size_t, shared_ptr<GameSession> >::iterator found = sessions.find(*it);
+                if (found != sessions.end()) {
+                    SessionCommand unwatch = {conn->id, 'U', 's'};
+                    enqueue(found->second, unwatch);
+                }
+            }
+            connsByFd.erase(conn->fd);
+            connsById.erase(conn->id);
+            delete conn;
+        }
+
+        void handleLine(Connection* conn, const string& line) {
+            istringstream in(line);
+            string verb;
+            in >> verb;
+
+            if (verb.empty()) {
+                return;
+            }
+
+            if (verb == "NEW" || verb == "LEVEL") {
+                shared_ptr<GameSession> s(new GameSession());
+
+                if (verb == "NEW") {
+                    int rows = -1, cols = -1, abysses = -1, monsters = -1, bats = -1, seed = -1;
+                    in >> rows >> cols >> abysses >> monsters >> bats >> seed;
+                    if (!in || !validGameParameters(rows, cols, abysses, monsters, bats)) {
+                        send(conn, "ERR - bad game parameters");
+                        return;
+                    }
+                    s->board = makeGameBoard(rows, cols);
+                    s->board->setNumAbysses(abysses);
+                    s->board->setNumMonsters(monsters);
+                    s->board->setNumBats(bats);
+                    if (seed < 0) {
+                        s->board->setupBoard(time(0));
+                    }
+                    else {
+                        ostringstream key;
+                        key << "NEW " << rows << ' ' << cols << ' ' << abysses << ' ' << monsters << ' ' << bats << ' ' << seed;
+                        SharedTerrain terrain = findTerrain(key.str());
+                        if (!terrain) {
+                            s->board->setupBoard(seed);
+                            terrain = terrainOfBoard(*s->board);
+                            rememberTerrain(key.str(), terrain);
+                        }
+                        s->board->setupFromTerrain(terrain);
+                    }
+                }
+                else {
+                    if (levels == NULL || levels->size() == 0) {
+                        send(conn, "ERR - no level library loaded");
+                        return;
+                    }
+                    long long n = -1;
+                    if (!(in >> n)) {
+                        n = levelPicker() % levels->size();
+                    }
+                    if (n < 0 || (size_t)n >= levels->size()) {
+                        send(conn, "ERR - no such level");
+                        return;
+                    }
+                    s->board = makeGameBoard(levels->numRows(), levels->numCols());
+                    ostringstream key;
+                    key << "LEVEL " << n;
+                    SharedTerrain terrain = findTerrain(key.str());
+                    if (!terrain) {
+                        levels->loadInto(n, *s->board);
+                        terrain = terrainOfBoard(*s->board);
+                        rememberTerrain(key.str(), terrain);
+                    }
+                    s->board->setupFromTerrain(terrain);
+                }
+
+                s->id = nextSessionId++;
+                s->owner = conn->id;
+                s->board->setVerbose(eventLog != NULL);
+                s->board->setEventLog(eventLog, (unsigned)s->id);
+                sessions[s->id] = s;
+                conn->sessions.insert(s->id);
+
+                ostringstream out;
+                out << "CREATED " << s->id;
+                send(conn, out.str());
+                return;
+            }
+
+            if (verb == "STATS") {
+                struct rusage usage;
+                getrusage(RUSAGE_SELF, &usage);
+                long long cpuMs = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000LL
+                                + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+                ostringstream out;
+                out << "STATS sessions=" << sessions.size() << " moves=" << movesProcessed.load()
+                    << " cpu_ms=" << cpuMs << " workers=" << workers.size();
+                send(conn, out.str());
+                return;
+            }
+
+            SessionCommand cmd;
+            cmd.conn = conn->id;
+            cmd.move = 's';
+            if (verb == "MOVE") {
+                cmd.kind = 'M';
+            }
+            else if (verb == "FRAME") {
+                cmd.kind = 'F';
+            }
+            else if (verb == "DIFF") {
+                cmd.kind = 'D';
+            }
+            else if (verb == "END") {
+                cmd.kind = 'E';
+            }
+            else if (verb == "WATCH") {
+                cmd.kind = 'W';
+            }
+            else if (verb == "UNWATCH") {
+                cmd.kind = 'U';
+            }
+            else {
+                send(conn, "ERR - unknown command");
+                return;
+            }
+
+            size_t id = 0;
+            in >> id;
+            if (cmd.kind == 'M') {
+                in >> cmd.move;
+            }
+            unordered_map<size_t, shared_ptr<GameSession> >::iterator found = sessions.find(id);
+            if (!in || found == sessions.end()) {
+                send(conn, "ERR - no such session");
+                return;
+            }
+            if (cmd.kind != 'W' && cmd.kind != 'U' && found->second->owner != conn->id) {
+                ostringstream out;
+                out << "ERR " << id << " not your session";
+                send(conn, out.str());
+                return;
+            }
+            if (cmd.kind == 'E') {
+                conn->sessions.erase(id);
+            }
+            if (cmd.kind == 'W') {
+                conn->watching.insert(id);
+            }
+            if (cmd.kind == 'U') {
+                conn->watching.erase(id);
+            }
+            conn->unanswered++;
+            enqueue(found->second, cmd);
+        }
+
+        void readConnection(Connection* conn) {
+            char buf[4096];
+            bool atEnd = false;  // EOF or a hard error; the lines that did arrive still run
+            while (true) {
+                ssize_t n = recv(conn->fd, buf, sizeof(buf), 0);
+                if (n > 0) {
+                    conn->inbuf.append(buf, n);
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                }
+                atEnd = true;
+                break;
+            }
+
+            size_t start = 0;
+            size_t end;
+            while ((end = conn->inbuf.find('\n', start)) != string::npos) {
+                handleLine(conn, conn->inbuf.substr(start, end - start));
+                start = end + 1;
+            }
+            conn->inbuf.erase(0, start);
+
+            if (conn->inbuf.size() > kMaxLineLength) {
+                send(conn, "ERR - line too long");
+                if (flush(conn)) {
+                    closeConnection(conn);
+                }
+                return;
+            }
+            if (!flush(conn) || !atEnd) {
+                return;
+            }
+            // the commands that did arrive are still answered; the socket is closed once
+            // those answers are out (see finishDraining())
+            conn->draining = true;
+            updateInterest(conn, true);
+            finishDraining(conn);
+        }
+
+        // closes a draining connection once every command it sent was answered and sent
+        void finishDraining(Connection* conn) {
+            if (conn->draining && conn->unanswered == 0 && conn->outQueue.empty() && conn->outText.empty()) {
+                closeConnection(conn);
+            }
+        }
+
+        // Delivers worker replies to their connections and drops ended sessions.
+        void deliverReplies() {
+            unsigned long long count;
+            ssize_t ignored = read(wakeFd, &count, sizeof(count));
+            (void)ignored;
+
+            vector<Reply> ready;
+            {
+                lock_guard<mutex> guard(replyLock);
+                ready.swap(replies);
+            }
+
+            set<Connection*> touched;
+            for (size_t i = 0; i < ready.size(); i++) {
+                if (ready[i].endedSession != 0) {
+                    sessions.erase(ready[i].endedSession);
+                }
+                unordered_map<unsigned long long, Connection*>::iterator found = connsById.find(ready[i].conn);
+                if (found != connsById.end()) {
+                    if (ready[i].answer) {
+                        found->second->unanswered--;
+                    }
+                    if (!ready[i].text.empty()) {
+                        send(found->second, ready[i].text);
+                    }
+                    if (ready[i].frame) {
+                        sendFrame(found->second, ready[i].frame);
+                    }
+                    touched.insert(found->second);
+                }
+            }
+            for (set<Connection*>::iterator it = touched.begin(); it != touched.end(); ++it) {
+                if (flush(*it)) {
+                    finishDraining(*it);
+                }
+            }
+        }
+
+    public:
+        /* param constructor -> binds the socket; 0 workers means one per core */
+        GameServer(const string& path, size_t numWorkers = 0)
+            : socketPath(path), listenFd(-1), epollFd(-1), wakeFd(-1), workers(numWorkers),
+              nextSessionId(1), nextConnId(1), levels(NULL), levelPicker(time(0)), eventLog(NULL), terrainPruneAt(64),
+              stopping(false), movesProcessed(0) {
+
+            struct sockaddr_un addr;
+            if (path.size() >= sizeof(addr.sun_path)) {
+                throw invalid_argument("GameServer constructor -> socket path too long");
+            }
+
+            listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (listenFd < 0) {
+                throw runtime_error("GameServer constructor -> could not create socket");
+            }
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+            unlink(path.c_str());
+            if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, SOMAXCONN) < 0) {
+                close(listenFd);
+                throw runtime_error("GameServer constructor -> could not bind " + path);
+            }
+
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+            wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.fd = listenFd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+            ev.data.fd = wakeFd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+        }
+
+        /* destructor */
+        virtual ~GameServer() {
+            // tasks still running lock replyLock, fill replies and write to wakeFd; the
+            // pool is a member declared before those, so it would only be stopped after
+            // they are gone
+            workers.join();
+
+            vector<Connection*> open;
+            for (unordered_map<int, Connection*>::iterator it = connsByFd.begin(); it != connsByFd.end(); ++it) {
+                open.push_back(it->second);
+            }
+            for (size_t i = 0; i < open.size(); i++) {
+                close(open[i]->fd);
+                delete open[i];
+            }
+            close(listenFd);
+            close(epollFd);
+            close(wakeFd);
+            unlink(socketPath.c_str());
+        }
+
+        // Runs the event loop until stop() is called.
+        void run() {
+            const int kMaxEvents = 256;
+            struct epoll_event events[kMaxEvents];
+
+            while (!stopping) {
+                int n = epoll_wait(epollFd, events, kMaxEvents, -1);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw runtime_error("GameServer run -> epoll_wait failed");
+                }
+
+                for (int i = 0; i < n; i++) {
+                    int fd = events[i].data.fd;
+
+                    if (fd == listenFd) {
+                        acceptConnections();
+                        continue;
+                    }
+                    if (fd == wakeFd) {
+                        deliverReplies();
+                        continue;
+                    }
+
+                    unordered_map<int, Connection*>::iterator found = connsByFd.find(fd);
+                    if (found == connsByFd.end()) {
+                        continue;  // closed earlier in this batch
+                    }
+                    Connection* conn = found->second;
+                    if (events[i].events & EPOLLERR) {
+                        closeConnection(conn);
+                        continue;
+                    }
+                    if (events[i].events & EPOLLOUT) {
+                        if (!flush(conn)) {
+                            continue;
+                        }
+                        if (conn->draining) {
+                            finishDraining(conn);
+                            continue;
+                        }
+                    }
+                    if (events[i].events & (EPOLLIN | EPOLLHUP)) {
+                        if (conn->draining) {
+                            // hung up on both sides: nobody is left to read the answers
+                            closeConnection(conn);
+                            continue;
+                        }
+                        readConnection(conn);
+                    }
+                }
+            }
+        }
+
+        // Asks run() to return. Safe to call from a signal handler.
+        void stop() {
+            stopping = true;
+            wakeLoop();
+        }
+
+        // lets LEVEL start games from a pre-generated library (must outlive the server)
+        void setLevelLibrary(const LevelLibrary* library) {
+            levels = library;
+            terrains.clear();
+        }
+
+        // sessions created from now on report their game events to log (NULL for none);
+        // the log must outlive them
+        void setEventLog(EventLog* log) {
+            eventLog = log;
+        }
+
+        size_t numSessions() const {
+            return sessions.size();
+        }
+
+    private:
+        GameServer(const GameServer&);
+        GameServer& operator=(const GameServer&);
+};
+
+#endif //_GAMESERVER_H
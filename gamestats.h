@@ -0,0 +1,193 @@
+/*
+    Filename: "gamestats.h"
+    Author: Viraj Saudagar
+
+    Streaming statistics for tools that play many games: RunningStats keeps
+    count, mean and variance of a stream of numbers in constant memory
+    (Welford's method) and merges with the stats of another thread;
+    wilsonInterval() gives a confidence interval for a rate such as the
+    fraction of games won.
+
+    For comparing two players on the same games, mcNemarPValue() says how
+    likely a split of the games only one of them won is under "both are
+    equally good". LogHistogram keeps the distribution of a positive
+    quantity such as a latency in a fixed number of buckets, to within
+    about 19%, for percentiles.
+
+*/
+
+#ifndef _GAMESTATS_H
+#define _GAMESTATS_H
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+using namespace std;
+
+// z for a two-sided 95% confidence interval
+static const double kZ95 = 1.959964;
+
+class RunningStats {
+    private:
+        size_t n;
+        double mu;   // running mean
+        double m2;   // sum of squared differences from the mean
+
+    public:
+        RunningStats() : n(0), mu(0), m2(0) {}
+
+        void add(double x) {
+            n++;
+            double delta = x - mu;
+            mu += delta / n;
+            m2 += delta * (x - mu);
+        }
+
+        // folds in the values another RunningStats has seen (Chan et al.)
+        void merge(const RunningStats& other) {
+            if (other.n == 0) {
+                return;
+            }
+            size_t total = n + other.n;
+            double delta = other.mu - mu;
+            mu += delta * other.n / total;
+            m2 += other.m2 + delta * delta * ((double)n * other.n / total);
+            n = total;
+        }
+
+        size_t count() const {
+            return n;
+        }
+
+        double mean() const {
+            return mu;
+        }
+
+        // sample variance, 0 with fewer than two values
+        double variance() const {
+            return n > 1 ? m2 / (n - 1) : 0;
+        }
+
+        double stddev() const {
+            return sqrt(variance());
+        }
+
+        // half width of the normal confidence interval for the mean
+        double meanHalfWidth(double z = kZ95) const {
+            return n > 1 ? z * stddev() / sqrt((double)n) : 0;
+        }
+};
+
+//---------------------------------------------------------------------------------
+// void wilsonInterval(size_t hits, size_t n, double& low, double& high, double z)
+//
+// Wilson score interval for the rate hits / n. Unlike the plain normal interval
+// it stays inside [0, 1] and behaves for rates near 0 or 1 and for small n.
+//---------------------------------------------------------------------------------
+inline void wilsonInterval(size_t hits, size_t n, double& low, double& high, double z = kZ95) {
+    if (n == 0) {
+        low = 0;
+        high = 1;
+        return;
+    }
+    double p = (double)hits / n;
+    double z2 = z * z;
+    double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+    double spread = z * sqrt(p * (1 - p) / n + z2 / (4.0 * n * n)) / (1 + z2 / n);
+    low = max(0.0, center - spread);
+    high = min(1.0, center + spread);
+}
+
+//---------------------------------------------------------------------------------
+// double mcNemarPValue(size_t onlyFirst, size_t onlySecond)
+//
+// Two-sided p-value of McNemar's test for paired outcomes: onlyFirst games were won
+// by the first player only, onlySecond by the second only (games both or neither won
+// say nothing about which is better). Exact binomial up to 100 such games, the
+// chi-square approximation with continuity correction above that.
+//---------------------------------------------------------------------------------
+inline double mcNemarPValue(size_t onlyFirst, size_t onlySecond) {
+    size_t n = onlyFirst + onlySecond;
+    if (n == 0) {
+        return 1;
+    }
+    size_t k = min(onlyFirst, onlySecond);
+    if (n <= 100) {
+        // 2 * P(X <= k) for X ~ Binomial(n, 1/2)
+        double tail = 0;
+        for (size_t i = 0; i <= k; i++) {
+            tail += exp(lgamma(n + 1.0) - lgamma(i + 1.0) - lgamma(n - i + 1.0) - n * log(2.0));
+        }
+        return min(1.0, 2 * tail);
+    }
+    double diff = fabs((double)onlyFirst - (double)onlySecond) - 1;
+    double chi2 = max(0.0, diff) * max(0.0, diff) / n;
+    return erfc(sqrt(chi2 / 2));
+}
+
+//---------------------------------------------------------------------------------
+// class LogHistogram
+//
+// Counts values >= 0 in buckets four to every power of two (bucket 0 holds values
+// below 1), so quantile() is within about 19% of the true value whatever the range.
+// Merges with the histogram of another thread. The largest value is kept exactly.
+//---------------------------------------------------------------------------------
+class LogHistogram {
+    private:
+        static const int NumBuckets = 4 * 64 + 1;
+        size_t counts[NumBuckets];
+        size_t n;
+        double largest;
+
+        static int bucketOf(double x) {
+            if (x < 1) {
+                return 0;
+            }
+            int b = 1 + (int)(4 * log2(x));
+            return b < NumBuckets ? b : NumBuckets - 1;
+        }
+
+    public:
+        LogHistogram() : n(0), largest(0) {
+            fill(counts, counts + NumBuckets, 0);
+        }
+
+        void add(double x) {
+            counts[bucketOf(x)]++;
+            n++;
+            largest = max(largest, x);
+        }
+
+        void merge(const LogHistogram& other) {
+            for (int b = 0; b < NumBuckets; b++) {
+                counts[b] += other.counts[b];
+            }
+            n += other.n;
+            largest = max(largest, other.largest);
+        }
+
+        size_t count() const {
+            return n;
+        }
+
+        double maximum() const {
+            return largest;
+        }
+
+        // about the value q (0..1) of the way through the sorted values: the upper edge of
+        // the bucket it falls in, but never more than the largest value; 0 if empty
+        double quantile(double q) const {
+            size_t rank = (size_t)ceil(q * n);
+            size_t seen = 0;
+            for (int b = 0; b < NumBuckets; b++) {
+                seen += counts[b];
+                if (seen >= rank && seen > 0) {
+                    return b == 0 ? min(1.0, largest) : min(exp2(b / 4.0), largest);
+                }
+            }
+            return largest;
+        }
+};
+
+#endif //_GAMESTATS_H
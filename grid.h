@@ -10,6 +10,12 @@ to a heap allocated array of the elements. Default
 grids are 4x4 but any valid combination of row/column
 size can be specified. These 2D grids will be used later 
 for the creation of the mazes and labyrinths. 
+
+Each row is one array, so row(r) hands it out as a
+GridSpan that loops index without range checks, and
+begin()/end() walk every element row after row like any
+STL container. gridalgo.h runs for_each, find_if and
+count_if over a grid on several threads.
 -------------------------------------------------*/
 
 #pragma once
@@ -18,9 +24,39 @@ for the creation of the mazes and labyrinths.
 #include <exception>
 #include <stdexcept>
 #include <algorithm>
+#include <iterator>
+#include <cstddef>
 
 using namespace std;
 
+// A run of Count elements side by side in memory, e.g. one row of a grid. Indexing
+// does no range checks; the grid checked the row when it handed the span out.
+template<typename T>
+class GridSpan {
+private:
+  T* First;
+  size_t Count;
+
+public:
+  GridSpan(T* first, size_t count) : First(first), Count(count) {}
+
+  T* begin() const {
+    return First;
+  }
+
+  T* end() const {
+    return First + Count;
+  }
+
+  size_t size() const {
+    return Count;
+  }
+
+  T& operator[](size_t i) const {
+    return First[i];
+  }
+};
+
 // template allows for the array of columns within the class to contain elements of any type. 
 template<typename T>
 class Grid {
@@ -33,6 +69,63 @@ private:
   ROW* Rows;     // array of ROWs
   size_t  NumRows;  // total # of rows (0..NumRows-1)
 
+  // Walks the elements row after row; V is T or const T.
+  template<typename V>
+  class Iterator {
+  private:
+    const ROW* Rows;
+    size_t R, C;
+
+  public:
+    typedef forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef V* pointer;
+    typedef V& reference;
+
+    Iterator() : Rows(NULL), R(0), C(0) {}
+    Iterator(const ROW* rows, size_t r, size_t c) : Rows(rows), R(r), C(c) {}
+
+    V& operator*() const {
+      return Rows[R].Cols[C];
+    }
+
+    V* operator->() const {
+      return &Rows[R].Cols[C];
+    }
+
+    Iterator& operator++() {
+      if (++C == Rows[R].NumCols) {
+        C = 0;
+        ++R;
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator before = *this;
+      ++*this;
+      return before;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return R == other.R && C == other.C;
+    }
+
+    bool operator!=(const Iterator& other) const {
+      return !(*this == other);
+    }
+
+    // where the element is
+    size_t row() const {
+      return R;
+    }
+
+    size_t col() const {
+      return C;
+    }
+  };
+
   // Frees the allocated memory within the grid object
   void clear(){
 
@@ -111,8 +204,7 @@ public:
   // to other functions to ensure the local object does not point to same memory as original object.
   Grid(const Grid<T>& other) {
     
-    // Frees the memory of what is current in the object
-    clear();
+    // Nothing to free yet: the object is being constructed.
       
     // Allocates memory for new grid Rows array based on copying object number of rows.
     Rows = new ROW[other.NumRows];
@@ -192,6 +284,43 @@ public:
   }
 
 
+  typedef Iterator<T> iterator;
+  typedef Iterator<const T> const_iterator;
+
+  // Iterators over every element, row after row.
+  iterator begin() {
+    return iterator(Rows, 0, 0);
+  }
+
+  iterator end() {
+    return iterator(Rows, NumRows, 0);
+  }
+
+  const_iterator begin() const {
+    return const_iterator(Rows, 0, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(Rows, NumRows, 0);
+  }
+
+  // Returns row r as a span of its elements. Throws if there is no row r; the span
+  // itself does no range checks.
+  GridSpan<T> row(size_t r) {
+    if (r >= NumRows) {
+        throw invalid_argument("Grid row -> Invalid row argument provided");
+    }
+    return GridSpan<T>(Rows[r].Cols, Rows[r].NumCols);
+  }
+
+  GridSpan<const T> row(size_t r) const {
+    if (r >= NumRows) {
+        throw invalid_argument("Grid row -> Invalid row argument provided");
+    }
+    return GridSpan<const T>(Rows[r].Cols, Rows[r].NumCols);
+  }
+
+
   // Parenthesis Operator overload -> allows passing row and column value as parameters 
   // and returns a reference to the element at that position if valid row & column
   // values are given. 
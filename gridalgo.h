@@ -0,0 +1,197 @@
+/*
+    Filename: "gridalgo.h"
+    Author: Viraj Saudagar
+
+    This file defines bulk algorithms over any grid that hands out its rows
+    as GridSpans (Grid and FixedGrid, see grid.h):
+
+        gridForEach(grid, fn, team)          fn(element) for every element
+        gridCountIf(grid, pred, team)        elements pred(element) is true for
+        gridFindIf(grid, pred, r, c, team)   the first such element, row after row
+
+    The grid is cut into chunks of whole rows, about kGridChunkCells elements
+    each, and every thread of the ThreadTeam (see workerpool.h) keeps taking
+    the next chunk off a shared counter until none are left, so a thread
+    that gets cheap rows simply does more of them. Inside a chunk the rows
+    are looped over as spans, without a range check per element.
+
+    Grids of kGridChunkCells elements or fewer, and calls without a team,
+    run on the calling thread. fn and pred are taken by value, as in
+    <algorithm>, so a temporary functor or lambda can be passed; the one
+    copy is called from every thread of the team at once, so it must be
+    safe to call that way. fn may change the element it is given and
+    nothing else of the grid.
+
+*/
+
+#ifndef _GRIDALGO_H
+#define _GRIDALGO_H
+
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+#include "grid.h"
+#include "workerpool.h"
+
+using namespace std;
+
+// elements in one chunk of work, give or take a row
+static const size_t kGridChunkCells = 1 << 14;
+
+// How a grid is cut into chunks of rows, and the counter handing them out.
+template<typename GridT>
+struct GridChunks {
+    GridT& grid;
+    size_t rowsPerChunk;
+    size_t numChunks;
+    atomic<size_t> next;
+
+    explicit GridChunks(GridT& g) : grid(g), next(0) {
+        size_t cols = grid.numrows() > 0 ? grid.numcols(0) : 1;
+        rowsPerChunk = max((size_t)1, kGridChunkCells / max((size_t)1, cols));
+        numChunks = (grid.numrows() + rowsPerChunk - 1) / rowsPerChunk;
+    }
+
+    // takes the next chunk, [first, last) of the rows; false once there are none left
+    bool take(size_t& chunk, size_t& first, size_t& last) {
+        chunk = next++;
+        if (chunk >= numChunks) {
+            return false;
+        }
+        first = chunk * rowsPerChunk;
+        last = min(grid.numrows(), first + rowsPerChunk);
+        return true;
+    }
+};
+
+// runs job(context, ...) once on every thread of team, or once here if there is no team
+// or the grid is small
+inline void runGridJob(ThreadTeam* team, size_t cells, ThreadTeam::Job job, void* context) {
+    if (team == NULL || team->size() == 1 || cells <= kGridChunkCells) {
+        job(context, 0, 1);
+        return;
+    }
+    team->run(team->size(), job, context);
+}
+
+template<typename GridT, typename Fn>
+struct GridForEachJob {
+    GridChunks<GridT> chunks;
+    Fn fn;
+
+    GridForEachJob(GridT& grid, const Fn& f) : chunks(grid), fn(f) {}
+
+    static void run(void* context, size_t, size_t) {
+        GridForEachJob& job = *(GridForEachJob*)context;
+        size_t chunk, first, last;
+        while (job.chunks.take(chunk, first, last)) {
+            for (size_t r = first; r < last; r++) {
+                auto span = job.chunks.grid.row(r);
+                for (size_t c = 0; c < span.size(); c++) {
+                    job.fn(span[c]);
+                }
+            }
+        }
+    }
+};
+
+template<typename GridT, typename Pred>
+struct GridCountIfJob {
+    GridChunks<GridT> chunks;
+    Pred pred;
+    atomic<size_t> total;
+
+    GridCountIfJob(GridT& grid, const Pred& p) : chunks(grid), pred(p), total(0) {}
+
+    static void run(void* context, size_t, size_t) {
+        GridCountIfJob& job = *(GridCountIfJob*)context;
+        size_t chunk, first, last;
+        size_t count = 0;
+        while (job.chunks.take(chunk, first, last)) {
+            for (size_t r = first; r < last; r++) {
+                auto span = job.chunks.grid.row(r);
+                for (size_t c = 0; c < span.size(); c++) {
+                    count += job.pred(span[c]) ? 1 : 0;
+                }
+            }
+        }
+        job.total += count;
+    }
+};
+
+// The first match lies in the lowest chunk that has one, so chunks past the lowest
+// found so far are skipped.
+template<typename GridT, typename Pred>
+struct GridFindIfJob {
+    GridChunks<GridT> chunks;
+    Pred pred;
+    atomic<size_t> bestChunk;   // lowest chunk with a match so far, numChunks if none
+    mutex lock;
+    size_t bestRow, bestCol;    // the first match in bestChunk
+
+    GridFindIfJob(GridT& grid, const Pred& p) : chunks(grid), pred(p), bestRow(0), bestCol(0) {
+        bestChunk = chunks.numChunks;
+    }
+
+    static void run(void* context, size_t, size_t) {
+        GridFindIfJob& job = *(GridFindIfJob*)context;
+        size_t chunk, first, last;
+        while (job.chunks.take(chunk, first, last)) {
+            if (chunk > job.bestChunk) {
+                continue;
+            }
+            for (size_t r = first; r < last; r++) {
+                auto span = job.chunks.grid.row(r);
+                for (size_t c = 0; c < span.size(); c++) {
+                    if (job.pred(span[c])) {
+                        job.found(chunk, r, c);
+                        r = last;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    void found(size_t chunk, size_t r, size_t c) {
+        lock_guard<mutex> guard(lock);
+        if (chunk < bestChunk) {
+            bestChunk = chunk;
+            bestRow = r;
+            bestCol = c;
+        }
+    }
+};
+
+// fn(element) for every element of grid; fn may change the element
+template<typename GridT, typename Fn>
+void gridForEach(GridT& grid, Fn fn, ThreadTeam* team = NULL) {
+    GridForEachJob<GridT, Fn> job(grid, fn);
+    runGridJob(team, grid.size(), &GridForEachJob<GridT, Fn>::run, &job);
+}
+
+// number of elements of grid pred(element) is true for
+template<typename GridT, typename Pred>
+size_t gridCountIf(GridT& grid, Pred pred, ThreadTeam* team = NULL) {
+    GridCountIfJob<GridT, Pred> job(grid, pred);
+    runGridJob(team, grid.size(), &GridCountIfJob<GridT, Pred>::run, &job);
+    return job.total;
+}
+
+// true if pred(element) is true for some element of grid; (r, c) is set to the first
+// one, row after row
+template<typename GridT, typename Pred>
+bool gridFindIf(GridT& grid, Pred pred, size_t& r, size_t& c, ThreadTeam* team = NULL) {
+    GridFindIfJob<GridT, Pred> job(grid, pred);
+    runGridJob(team, grid.size(), &GridFindIfJob<GridT, Pred>::run, &job);
+    if (job.bestChunk == job.chunks.numChunks) {
+        return false;
+    }
+    r = job.bestRow;
+    c = job.bestCol;
+    return true;
+}
+
+#endif //_GRIDALGO_H
@@ -0,0 +1,173 @@
+/*
+    Filename: "gridtest.cpp"
+    Author: Viraj Saudagar
+
+    Check of the bulk grid algorithms in gridalgo.h. gridForEach(),
+    gridCountIf() and gridFindIf() are run on a Grid and on a FixedGrid,
+    on the calling thread and on a ThreadTeam, and every result is
+    compared with a plain loop over the same grid:
+
+      - gridForEach() has to change every element exactly once
+      - gridCountIf() has to count what the loop counts
+      - gridFindIf() has to find the first match row after row: in the
+        first chunk, in the last chunk with a later match behind it, in
+        the last chunk with matches in no other, and not at all
+
+    The grids span several chunks (kGridChunkCells) so the team really
+    splits them; a grid of a single chunk is checked as well.
+
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+#include "grid.h"
+#include "fixedgrid.h"
+#include "gridalgo.h"
+#include "gamerng.h"
+
+static const size_t kRows = 300;
+static const size_t kCols = 500;   // kRows * kCols is about 9 chunks
+static const int kMarker = -1;     // no filled element has this value
+
+// element = element * 3 + 1
+struct Triple {
+    void operator()(int& x) const {
+        x = x * 3 + 1;
+    }
+};
+
+// true for multiples of n
+struct MultipleOf {
+    int n;
+    explicit MultipleOf(int m) : n(m) {}
+    bool operator()(int x) const {
+        return x % n == 0;
+    }
+};
+
+struct IsMarker {
+    bool operator()(int x) const {
+        return x == kMarker;
+    }
+};
+
+size_t failures = 0;
+
+void expect(bool ok, const string& what) {
+    if (!ok) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+template<typename GridT>
+void fill(GridT& grid, int seed) {
+    GameRng rng(seed);
+    for (size_t r = 0; r < grid.numrows(); r++) {
+        for (size_t c = 0; c < grid.numcols(r); c++) {
+            grid(r, c) = rng() % 1000;
+        }
+    }
+}
+
+// gridFindIf() for kMarker placed at the first numCells of cells, compared with
+// the first of them row after row
+template<typename GridT>
+void checkFind(GridT& grid, ThreadTeam* team, const string& name, const size_t (*cells)[2], size_t numCells) {
+    for (size_t k = 0; k < numCells; k++) {
+        grid(cells[k][0], cells[k][1]) = kMarker;
+    }
+    bool wantFound = false;
+    size_t wantR = 0, wantC = 0;
+    for (size_t r = 0; r < grid.numrows() && !wantFound; r++) {
+        for (size_t c = 0; c < grid.numcols(r); c++) {
+            if (grid(r, c) == kMarker) {
+                wantFound = true;
+                wantR = r;
+                wantC = c;
+                break;
+            }
+        }
+    }
+    size_t r = 0, c = 0;
+    bool found = gridFindIf(grid, IsMarker(), r, c, team);
+    expect(found == wantFound && (!found || (r == wantR && c == wantC)),
+           name + " gridFindIf with " + to_string(numCells) + " matches, first at (" + to_string(wantR) + ","
+           + to_string(wantC) + ") found (" + to_string(r) + "," + to_string(c) + ")");
+    for (size_t k = 0; k < numCells; k++) {
+        grid(cells[k][0], cells[k][1]) = 0;
+    }
+}
+
+template<typename GridT>
+void checkGrid(GridT& grid, ThreadTeam* team, const string& name) {
+    size_t rows = grid.numrows();
+    size_t cols = grid.numcols(0);
+
+    // gridForEach against the same change made in a loop
+    fill(grid, 7);
+    Grid<int> want(rows, cols);
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < cols; c++) {
+            want(r, c) = grid(r, c) * 3 + 1;
+        }
+    }
+    gridForEach(grid, Triple(), team);
+    size_t wrong = 0;
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < cols; c++) {
+            wrong += (grid(r, c) != want(r, c)) ? 1 : 0;
+        }
+    }
+    expect(wrong == 0, name + " gridForEach left " + to_string(wrong) + " elements wrong");
+
+    // gridCountIf, with a functor and with a lambda, both temporaries
+    size_t count = 0;
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t c = 0; c < cols; c++) {
+            count += (grid(r, c) % 7 == 0) ? 1 : 0;
+        }
+    }
+    expect(gridCountIf(grid, MultipleOf(7), team) == count, name + " gridCountIf(MultipleOf(7))");
+    expect(gridCountIf(grid, [](int x) { return x % 7 == 0; }, team) == count, name + " gridCountIf(lambda)");
+
+    // gridFindIf: the fill is never negative, so only the markers match
+    fill(grid, 11);
+    size_t last = rows - 1;
+    const size_t firstChunk[][2] = {{0, cols - 1}, {1, 0}, {last, cols - 1}};
+    const size_t lateThenLater[][2] = {{last - 1, 5}, {last, 0}};
+    const size_t lastCell[][2] = {{last, cols - 1}};
+    checkFind(grid, team, name, firstChunk, 3);
+    checkFind(grid, team, name, lateThenLater, 2);
+    checkFind(grid, team, name, lastCell, 1);
+    checkFind(grid, team, name, lastCell, 0);
+}
+
+int main() {
+
+    ThreadTeam team(4);
+    ThreadTeam* teams[] = {NULL, &team};
+    const char* teamNames[] = {"serial", "team of 4"};
+
+    Grid<int> grid(kRows, kCols);
+    Grid<int> small(20, 30);
+    unique_ptr< FixedGrid<int, kRows, kCols> > fixed(new FixedGrid<int, kRows, kCols>());
+    for (size_t t = 0; t < 2; t++) {
+        checkGrid(grid, teams[t], string("Grid ") + teamNames[t]);
+        checkGrid(*fixed, teams[t], string("FixedGrid ") + teamNames[t]);
+        checkGrid(small, teams[t], string("small Grid ") + teamNames[t]);
+    }
+
+    if (failures > 0) {
+        cout << failures << " grid algorithm checks failed" << endl;
+        return 1;
+    }
+    cout << "All grid algorithm checks passed." << endl;
+    return 0;
+
+} // main
@@ -0,0 +1,215 @@
+/*
+    Filename: "heatmap.h"
+    Author: Viraj Saudagar
+
+    This file defines Heatmaps, per-cell counts gathered over many simulated
+    games on boards of one size, for seeing where things happen:
+
+        hero_visits            turns the hero started on the cell
+        death_abyss            heroes that fell into the abyss on the cell
+        death_monster          heroes caught on the cell by a Monster (m)
+        death_super_monster    heroes caught on the cell by a Super Monster (M)
+        death_bat              heroes caught on the cell by a Bat
+        monster_traffic        times a monster or super monster moved onto the cell
+
+    Collecting costs O(1) per turn plus O(1) per cell the turn changed: the
+    hero is read from getHeroPosition(), deaths from getOutcomeCell(), and
+    monster moves from the board's change tracking (setTrackChanges()), so
+    nothing scans the board. Counts are 32 bits and stop at the largest
+    value instead of wrapping.
+
+    Each thread keeps a Heatmaps of its own and merge()s it into the total
+    once it is done, so threads never share a counter. The result can be
+    written out as a 16-bit binary PGM image or as CSV, one file per layer.
+
+*/
+
+#ifndef _HEATMAP_H
+#define _HEATMAP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <fstream>
+#include <stdexcept>
+
+#include "gameboard.h"
+
+using namespace std;
+
+enum HeatLayer {
+    HeatHeroVisits = 0,
+    HeatDeathAbyss = 1,
+    HeatDeathMonster = 2,
+    HeatDeathSuperMonster = 3,
+    HeatDeathBat = 4,
+    HeatMonsterTraffic = 5,
+    NumHeatLayers = 6
+};
+
+static const char* const kHeatLayerNames[NumHeatLayers] = {
+    "hero_visits", "death_abyss", "death_monster", "death_super_monster", "death_bat", "monster_traffic"
+};
+
+class Heatmaps {
+    private:
+        size_t rows, cols;
+        vector<uint32_t> counts;     // layer after layer, each rows x cols, row after row
+        vector<size_t> changed;      // reused by afterTurn()
+
+        void bump(HeatLayer layer, size_t cell) {
+            uint32_t& count = counts[layer * rows * cols + cell];
+            count += (count != UINT32_MAX);
+        }
+
+        void visitHero(GameBoardBase& board) {
+            size_t r, c;
+            board.getHeroPosition(r, c);
+            if (r < rows && c < cols) {
+                bump(HeatHeroVisits, r * cols + c);
+            }
+        }
+
+    public:
+        /* param constructor -> every count 0 for rows x cols boards */
+        Heatmaps(size_t numRows, size_t numCols) : rows(numRows), cols(numCols), counts(NumHeatLayers * numRows * numCols, 0) {}
+
+        size_t numRows() const {
+            return rows;
+        }
+
+        size_t numCols() const {
+            return cols;
+        }
+
+        // rows x cols counts of one layer, row after row
+        const uint32_t* layer(HeatLayer l) const {
+            return &counts[l * rows * cols];
+        }
+
+        uint32_t count(HeatLayer l, size_t r, size_t c) const {
+            return counts[l * rows * cols + r * cols + c];
+        }
+
+        // the largest count in a layer
+        uint32_t maxCount(HeatLayer l) const {
+            const uint32_t* values = layer(l);
+            uint32_t largest = 0;
+            for (size_t i = 0; i < rows * cols; i++) {
+                largest = max(largest, values[i]);
+            }
+            return largest;
+        }
+
+        //---------------------------------------------------------------------------------
+        // Collecting a game: startGame() right after the board was set up, afterTurn()
+        // after every makeMoves(), endGame() once the game is over (or given up on).
+        // startGame() turns on the board's change tracking, which stays on.
+        //---------------------------------------------------------------------------------
+        void startGame(GameBoardBase& board) {
+            if (board.getNumRows() != rows || board.getNumCols() != cols) {
+                throw invalid_argument("Heatmaps startGame -> board size does not match the heatmaps");
+            }
+            board.setTrackChanges(true);
+            visitHero(board);
+        }
+
+        void afterTurn(GameBoardBase& board) {
+            changed.clear();
+            board.takeChangedCells(changed);
+            for (size_t k = 0; k < changed.size(); k++) {
+                unsigned char tile = board.getCellTile(changed[k] / cols, changed[k] % cols);
+                if (tile == TileMonster || tile == TileSuperMonster) {
+                    bump(HeatMonsterTraffic, changed[k]);
+                }
+            }
+            if (board.getOutcome() == OutcomePlaying) {
+                visitHero(board);
+            }
+        }
+
+        void endGame(GameBoardBase& board) {
+            size_t r, c;
+            board.getOutcomeCell(r, c);
+            if (r >= rows || c >= cols) {
+                return;
+            }
+            switch (board.getOutcomeTile()) {
+                case TileAbyss:        bump(HeatDeathAbyss, r * cols + c);        break;
+                case TileMonster:      bump(HeatDeathMonster, r * cols + c);      break;
+                case TileSuperMonster: bump(HeatDeathSuperMonster, r * cols + c); break;
+                case TileBat:          bump(HeatDeathBat, r * cols + c);          break;
+                default:               break;
+            }
+        }
+
+        // adds the counts of other (same size) to these
+        void merge(const Heatmaps& other) {
+            if (other.rows != rows || other.cols != cols) {
+                throw invalid_argument("Heatmaps merge -> heatmaps of different sizes");
+            }
+            for (size_t i = 0; i < counts.size(); i++) {
+                uint64_t sum = (uint64_t)counts[i] + other.counts[i];
+                counts[i] = sum > UINT32_MAX ? UINT32_MAX : (uint32_t)sum;
+            }
+        }
+
+        //---------------------------------------------------------------------------------
+        // void writePGM(HeatLayer l, ostream& out)
+        //
+        // Writes one layer as a binary 16-bit PGM (P5), one pixel per cell. Counts are
+        // written as they are when the largest fits into 16 bits, and scaled to 0..65535
+        // otherwise.
+        //---------------------------------------------------------------------------------
+        void writePGM(HeatLayer l, ostream& out) const {
+            const uint32_t* values = layer(l);
+            uint32_t largest = maxCount(l);
+            uint32_t maxval = largest < 1 ? 1 : (largest > 65535 ? 65535 : largest);
+            out << "P5\n" << cols << " " << rows << "\n" << maxval << "\n";
+            vector<unsigned char> row(cols * 2);
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t c = 0; c < cols; c++) {
+                    uint32_t v = values[r * cols + c];
+                    if (largest > 65535) {
+                        v = (uint32_t)(((uint64_t)v * 65535 + largest / 2) / largest);
+                    }
+                    row[2 * c] = (unsigned char)(v >> 8);  // PGM samples are big-endian
+                    row[2 * c + 1] = (unsigned char)v;
+                }
+                out.write((const char*)&row[0], row.size());
+            }
+        }
+
+        // one layer as CSV, one line of counts per row
+        void writeCSV(HeatLayer l, ostream& out) const {
+            const uint32_t* values = layer(l);
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t c = 0; c < cols; c++) {
+                    if (c > 0) {
+                        out << ',';
+                    }
+                    out << values[r * cols + c];
+                }
+                out << '\n';
+            }
+        }
+
+        // writes prefix + "_" + layer name + ".pgm" and ".csv" for every layer; false if a
+        // file could not be written
+        bool save(const string& prefix) const {
+            for (int l = 0; l < NumHeatLayers; l++) {
+                string base = prefix + "_" + kHeatLayerNames[l];
+                ofstream pgm((base + ".pgm").c_str(), ios::binary);
+                writePGM((HeatLayer)l, pgm);
+                ofstream csv((base + ".csv").c_str());
+                writeCSV((HeatLayer)l, csv);
+                if (!pgm || !csv) {
+                    return false;
+                }
+            }
+            return true;
+        }
+};
+
+#endif //_HEATMAP_H
@@ -0,0 +1,244 @@
+/*
+    Filename: "heroindex.h"
+    Author: Viraj Saudagar
+
+    This file defines HeroIndex, where the heroes of a board with several
+    of them stand (see GameBoardBase::setMultiHero()), kept so that the
+    hero nearest to a baddie is found without looking at every hero.
+
+    The board is cut into square buckets of side x side cells and every
+    bucket lists the heroes standing in it. nearest() looks through the
+    buckets in rings around the one asked about, closest ring first, and
+    stops as soon as no hero in the next ring could be nearer than the
+    best one found. A hero moving within its bucket only updates its cell;
+    moving to another bucket takes it out of one short list and puts it
+    into another.
+
+    Distances are counted in moves of a monster, which steps diagonally as
+    easily as straight (max(|dr|, |dc|)), and ties go to the lowest hero
+    id, so the answer does not depend on the order heroes sit in their
+    buckets.
+
+    With side 0 the index picks the side itself, so that a bucket holds
+    about kHeroesPerBucket heroes if they are spread evenly, and picks it
+    again whenever the number of heroes has doubled. The number of
+    buckets then follows the number of heroes rather than the area of the
+    board, which keeps a million by million world cheap.
+
+*/
+
+#ifndef _HEROINDEX_H
+#define _HEROINDEX_H
+
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+// heroes a bucket is sized for when the index picks the side
+static const size_t kHeroesPerBucket = 4;
+
+// smallest side the index picks
+static const size_t kMinHeroBucketSide = 8;
+
+// most buckets an index may have
+static const size_t kMaxHeroBuckets = (size_t)1 << 24;
+
+class HeroIndex {
+    public:
+        static const size_t NoHero = (size_t)-1;
+
+    private:
+        static const size_t NoCell = (size_t)-1;
+
+        size_t rows, cols;
+        bool autoSide;                    // true = the side follows the number of heroes
+        size_t side;                      // cells across a bucket
+        size_t bucketRows, bucketCols;
+        size_t sizedFor;                  // heroes the side was picked for
+        vector< vector<size_t> > buckets; // ids of the heroes in each bucket, row after row
+        vector<size_t> cellOf;            // r * cols + c of each hero, NoCell if it is not indexed
+        size_t count;
+
+        size_t bucketOf(size_t cell) const {
+            return (cell / cols / side) * bucketCols + (cell % cols) / side;
+        }
+
+        // sizes the buckets for side (0 = picked for heroes heroes); empties them
+        void layOut(size_t bucketSide, size_t heroes) {
+            if (bucketSide == 0) {
+                double area = (double)rows * cols * kHeroesPerBucket / max((size_t)1, heroes);
+                bucketSide = max(kMinHeroBucketSide, (size_t)ceil(sqrt(area)));
+            }
+            side = bucketSide;
+            bucketRows = (rows + side - 1) / side;
+            bucketCols = (cols + side - 1) / side;
+            if (bucketCols > 0 && bucketRows > kMaxHeroBuckets / bucketCols) {
+                throw invalid_argument("HeroIndex -> buckets too small for the board");
+            }
+            sizedFor = heroes;
+            buckets.assign(bucketRows * bucketCols, vector<size_t>());
+        }
+
+        // picks the side again for the heroes there are now and puts them back
+        void rebucket() {
+            layOut(0, count);
+            for (size_t id = 0; id < cellOf.size(); id++) {
+                if (cellOf[id] != NoCell) {
+                    buckets[bucketOf(cellOf[id])].push_back(id);
+                }
+            }
+        }
+
+        void takeOut(size_t id) {
+            vector<size_t>& ids = buckets[bucketOf(cellOf[id])];
+            for (size_t k = 0; k < ids.size(); k++) {
+                if (ids[k] == id) {
+                    ids[k] = ids.back();
+                    ids.pop_back();
+                    return;
+                }
+            }
+        }
+
+        // the heroes of bucket (br, bc) nearer to (r, c) than best, or as near with a lower id
+        void searchBucket(size_t br, size_t bc, size_t r, size_t c, size_t& best, size_t& bestDistance) const {
+            const vector<size_t>& ids = buckets[br * bucketCols + bc];
+            for (size_t k = 0; k < ids.size(); k++) {
+                size_t hr = cellOf[ids[k]] / cols;
+                size_t hc = cellOf[ids[k]] % cols;
+                size_t distance = max(hr > r ? hr - r : r - hr, hc > c ? hc - c : c - hc);
+                if (distance < bestDistance || (distance == bestDistance && ids[k] < best)) {
+                    best = ids[k];
+                    bestDistance = distance;
+                }
+            }
+        }
+
+    public:
+        HeroIndex() : rows(0), cols(0), autoSide(true), side(1), bucketRows(0), bucketCols(0), sizedFor(0), count(0) {}
+
+        // sizes the index for a rows x cols board with no heroes in it; side 0 lets it pick
+        void reset(size_t numRows, size_t numCols, size_t bucketSide) {
+            rows = numRows;
+            cols = numCols;
+            autoSide = (bucketSide == 0);
+            cellOf.clear();
+            count = 0;
+            layOut(bucketSide, 1);
+        }
+
+        // puts hero id, which is not indexed yet, at (r, c)
+        void add(size_t id, size_t r, size_t c) {
+            if (id >= cellOf.size()) {
+                cellOf.resize(id + 1, (size_t)NoCell);
+            }
+            cellOf[id] = r * cols + c;
+            count++;
+            if (autoSide && count > 2 * sizedFor) {
+                rebucket();
+                return;
+            }
+            buckets[bucketOf(cellOf[id])].push_back(id);
+        }
+
+        // takes hero id out of the index
+        void remove(size_t id) {
+            takeOut(id);
+            cellOf[id] = NoCell;
+            count--;
+        }
+
+        // hero id now stands at (r, c)
+        void move(size_t id, size_t r, size_t c) {
+            size_t cell = r * cols + c;
+            if (bucketOf(cell) != bucketOf(cellOf[id])) {
+                takeOut(id);
+                buckets[bucketOf(cell)].push_back(id);
+            }
+            cellOf[id] = cell;
+        }
+
+        bool contains(size_t id) const {
+            return id < cellOf.size() && cellOf[id] != NoCell;
+        }
+
+        // where hero id stands; it has to be indexed
+        void position(size_t id, size_t& r, size_t& c) const {
+            r = cellOf[id] / cols;
+            c = cellOf[id] % cols;
+        }
+
+        // the hero standing at (r, c), NoHero if none is
+        size_t heroAt(size_t r, size_t c) const {
+            size_t cell = r * cols + c;
+            const vector<size_t>& ids = buckets[bucketOf(cell)];
+            for (size_t k = 0; k < ids.size(); k++) {
+                if (cellOf[ids[k]] == cell) {
+                    return ids[k];
+                }
+            }
+            return NoHero;
+        }
+
+        //---------------------------------------------------------------------------------
+        // size_t nearest(size_t r, size_t c) const
+        //
+        // The hero fewest monster moves away from (r, c), the lowest id of those as near,
+        // NoHero if the index is empty. A bucket k rings out is at least (k - 1) * side + 1
+        // cells away, so the search ends with the first ring that cannot do better.
+        //---------------------------------------------------------------------------------
+        size_t nearest(size_t r, size_t c) const {
+            size_t best = NoHero;
+            size_t bestDistance = (size_t)-1;
+            if (count == 0) {
+                return best;
+            }
+            size_t br = r / side;
+            size_t bc = c / side;
+            size_t lastRing = max(bucketRows, bucketCols);
+            for (size_t k = 0; k <= lastRing; k++) {
+                if (k > 0 && (k - 1) * side + 1 > bestDistance) {
+                    break;
+                }
+                size_t top = (br >= k) ? br - k : 0;
+                size_t bottom = min(bucketRows - 1, br + k);
+                for (size_t i = top; i <= bottom; i++) {
+                    bool edgeRow = (i + k == br || i == br + k);
+                    if (edgeRow) {
+                        size_t left = (bc >= k) ? bc - k : 0;
+                        size_t right = min(bucketCols - 1, bc + k);
+                        for (size_t j = left; j <= right; j++) {
+                            searchBucket(i, j, r, c, best, bestDistance);
+                        }
+                        continue;
+                    }
+                    if (bc >= k) {
+                        searchBucket(i, bc - k, r, c, best, bestDistance);
+                    }
+                    if (bc + k < bucketCols) {
+                        searchBucket(i, bc + k, r, c, best, bestDistance);
+                    }
+                }
+            }
+            return best;
+        }
+
+        // heroes indexed
+        size_t size() const {
+            return count;
+        }
+
+        size_t bucketSide() const {
+            return side;
+        }
+
+        size_t numBuckets() const {
+            return buckets.size();
+        }
+};
+
+#endif //_HEROINDEX_H
@@ -0,0 +1,501 @@
+/*
+    Filename: "heropolicy.h"
+    Author: Viraj Saudagar
+
+    This file defines HeroPolicy, something that picks the hero's next move
+    by looking at a board, so games can be played without a person at the
+    keyboard. A policy only gets a BoardView of the board, which can be read
+    but not changed. Five policies come with it:
+
+        random    one of the 9 moves, uniformly
+        greedy    the move that gets closest to the ladder as the crow flies,
+                  preferring cells no baddie can reach next turn
+        planner   follows the shortest walkable path to the ladder (walls and
+                  abysses block it), preferring cells no baddie can reach
+        safe      follows the shortest path to the ladder that avoids every
+                  cell a baddie can reach next turn, worked out again every
+                  turn; plays like planner when there is no such path
+        search    plays every sequence of the next kSearchDepth moves on a
+                  copy of the board and picks the one that ends up best:
+                  escaped soonest, else alive and nearest the ladder
+
+    A cell is threatened when some baddie could land on it in the baddies'
+    next round: a monster next to it, a super monster exactly two cells away
+    in a straight or diagonal line, or a bat in the same row. When the board
+    keeps a ThreatMap (see GameBoardBase::setTrackThreats()) the policies
+    read that instead, which also knows where walls deflect a monster and is
+    one bit test per cell rather than a look around it.
+
+    Every policy owns its own state, so use one instance per thread.
+
+*/
+
+#ifndef _HEROPOLICY_H
+#define _HEROPOLICY_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+
+#include "gameboard.h"
+#include "gamerng.h"
+#include "tiles.h"
+
+using namespace std;
+
+// the 9 hero moves and where each one goes
+static const char kHeroMoves[9] = {'s', 'q', 'w', 'e', 'a', 'd', 'z', 'x', 'c'};
+static const int kHeroMoveRow[9] = {0, -1, -1, -1, 0, 0, 1, 1, 1};
+static const int kHeroMoveCol[9] = {0, -1, 0, 1, -1, 1, -1, 0, 1};
+
+// names makeHeroPolicy() knows, in the order tools list them
+static const char* const kHeroPolicyNames[] = {"random", "greedy", "planner", "safe", "search"};
+static const size_t kNumHeroPolicies = 5;
+
+// moves the search policy looks ahead
+static const int kSearchDepth = 3;
+
+//---------------------------------------------------------------------------------
+// class BoardView
+//
+// What a policy can see of a board: its size, its tiles, the hero and the rules
+// it is played with. Nothing through it changes the board.
+//---------------------------------------------------------------------------------
+class BoardView {
+    private:
+        GameBoardBase& board;
+
+    public:
+        explicit BoardView(GameBoardBase& b) : board(b) {}
+
+        size_t getNumRows() const {
+            return board.getNumRows();
+        }
+
+        size_t getNumCols() const {
+            return board.getNumCols();
+        }
+
+        unsigned char getCellTile(size_t r, size_t c) const {
+            return board.getCellTile(r, c);
+        }
+
+        void getHeroPosition(size_t& row, size_t& col) const {
+            board.getHeroPosition(row, col);
+        }
+
+        // every tile, rows x cols, row after row
+        void getTiles(unsigned char* tiles) const {
+            board.getTiles(tiles);
+        }
+
+        CollisionPolicy getCollisionPolicy() const {
+            return board.getCollisionPolicy();
+        }
+
+        // the board's threat map, NULL unless it keeps one
+        const ThreatMap* getThreats() const {
+            return board.getThreats();
+        }
+
+    private:
+        BoardView& operator=(const BoardView&);
+};
+
+//---------------------------------------------------------------------------------
+// bool heroThreatened(const BoardView& board, size_t r, size_t c)
+//
+// True if a baddie where it stands now could move onto (r, c) in its next move.
+// Walls that would deflect a monster are ignored, so this errs on the safe side,
+// unless the board keeps a threat map, which is read instead.
+//---------------------------------------------------------------------------------
+inline bool heroThreatened(const BoardView& board, size_t r, size_t c) {
+    const ThreatMap* threats = board.getThreats();
+    if (threats != NULL) {
+        return threats->threatened(r, c);
+    }
+    size_t rows = board.getNumRows();
+    size_t cols = board.getNumCols();
+
+    for (int dr = -2; dr <= 2; dr++) {
+        for (int dc = -2; dc <= 2; dc++) {
+            size_t br = r + dr;
+            size_t bc = c + dc;
+            if ((dr == 0 && dc == 0) || br >= rows || bc >= cols) {
+                continue;
+            }
+            unsigned char tile = board.getCellTile(br, bc);
+            bool near = (abs(dr) <= 1 && abs(dc) <= 1);
+            bool inLine = (abs(dr) == 2 || dr == 0) && (abs(dc) == 2 || dc == 0);
+            if ((tile == TileMonster && near) || (tile == TileSuperMonster && inLine)) {
+                return true;
+            }
+        }
+    }
+    for (size_t bc = 0; bc < cols; bc++) {
+        if (board.getCellTile(r, bc) == TileBat) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// true if the hero can stand on (r, c) at all
+inline bool heroCanEnter(const BoardView& board, size_t r, size_t c) {
+    unsigned char tile = board.getCellTile(r, c);
+    return tile == TileEmpty || tile == TileHero || tile == TileLadder;
+}
+
+
+class HeroPolicy {
+    public:
+        virtual ~HeroPolicy() {}
+
+        // called once a game has been set up, before the first nextMove()
+        virtual void startGame(const BoardView& board, unsigned seed) {}
+
+        // the move to play now, one of kHeroMoves
+        virtual char nextMove(const BoardView& board) = 0;
+
+        virtual string name() const = 0;
+};
+
+
+//---------------------------------------------------------------------------------
+// void markThreatenedCells(const BoardView& board, vector<unsigned char>& threatened)
+//
+// Sets threatened[r * cols + c] to 1 for every cell heroThreatened() is true for, and
+// to 0 for the others, in one pass over the board (or over the threat map, if the
+// board keeps one).
+//---------------------------------------------------------------------------------
+inline void markThreatenedCells(const BoardView& board, vector<unsigned char>& threatened) {
+    size_t rows = board.getNumRows();
+    size_t cols = board.getNumCols();
+    threatened.assign(rows * cols, 0);
+    const ThreatMap* threats = board.getThreats();
+    if (threats != NULL) {
+        for (size_t r = 0; r < rows; r++) {
+            const uint64_t* bits = threats->rowBits(r);
+            for (size_t w = 0; w * 64 < cols; w++) {
+                for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                    threatened[r * cols + w * 64 + __builtin_ctzll(word)] = 1;
+                }
+            }
+        }
+        return;
+    }
+    for (size_t br = 0; br < rows; br++) {
+        for (size_t bc = 0; bc < cols; bc++) {
+            unsigned char tile = board.getCellTile(br, bc);
+            if (tile == TileBat) {
+                fill(threatened.begin() + br * cols, threatened.begin() + (br + 1) * cols, 1);
+                continue;
+            }
+            if (tile != TileMonster && tile != TileSuperMonster) {
+                continue;
+            }
+            int reach = (tile == TileSuperMonster) ? 2 : 1;
+            for (int dr = -reach; dr <= reach; dr += reach) {
+                for (int dc = -reach; dc <= reach; dc += reach) {
+                    size_t r = br + dr;
+                    size_t c = bc + dc;
+                    if ((dr != 0 || dc != 0) && r < rows && c < cols) {
+                        threatened[r * cols + c] = 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+class RandomPolicy : public HeroPolicy {
+    private:
+        GameRng rng;
+
+    public:
+        virtual void startGame(const BoardView& board, unsigned seed) {
+            rng.reseed(seed);
+        }
+
+        virtual char nextMove(const BoardView& board) {
+            return kHeroMoves[rng() % 9];
+        }
+
+        virtual string name() const {
+            return "random";
+        }
+};
+
+
+// Base for policies that score the 9 moves and play the best one. Moves onto walls,
+// abysses, baddies or off the board are never chosen; a threatened cell is only chosen
+// when every other choice is threatened too. Ties go to the first move in kHeroMoves.
+class ScoredPolicy : public HeroPolicy {
+    protected:
+        size_t ladderRow, ladderCol;
+
+        // lower is better; only called for cells the hero can enter
+        virtual long score(const BoardView& board, size_t r, size_t c) = 0;
+
+    public:
+        virtual void startGame(const BoardView& board, unsigned seed) {
+            ladderRow = ladderCol = 0;
+            for (size_t r = 0; r < board.getNumRows(); r++) {
+                for (size_t c = 0; c < board.getNumCols(); c++) {
+                    if (board.getCellTile(r, c) == TileLadder) {
+                        ladderRow = r;
+                        ladderCol = c;
+                    }
+                }
+            }
+        }
+
+        virtual char nextMove(const BoardView& board) {
+            size_t heroRow, heroCol;
+            board.getHeroPosition(heroRow, heroCol);
+
+            char best = 's';
+            long bestScore = 0;
+            bool found = false;
+            for (int i = 0; i < 9; i++) {
+                size_t r = heroRow + kHeroMoveRow[i];
+                size_t c = heroCol + kHeroMoveCol[i];
+                if (r >= board.getNumRows() || c >= board.getNumCols() || !heroCanEnter(board, r, c)) {
+                    continue;
+                }
+                long s = score(board, r, c);
+                if (board.getCellTile(r, c) != TileLadder && heroThreatened(board, r, c)) {
+                    s += 1000000;
+                }
+                if (!found || s < bestScore) {
+                    best = kHeroMoves[i];
+                    bestScore = s;
+                    found = true;
+                }
+            }
+            return best;
+        }
+};
+
+
+class GreedyPolicy : public ScoredPolicy {
+    protected:
+        virtual long score(const BoardView& board, size_t r, size_t c) {
+            long dr = labs((long)r - (long)ladderRow);
+            long dc = labs((long)c - (long)ladderCol);
+            return max(dr, dc);
+        }
+
+    public:
+        virtual string name() const {
+            return "greedy";
+        }
+};
+
+
+class PlannerPolicy : public ScoredPolicy {
+    private:
+        deque<size_t> frontier;
+
+    protected:
+        vector<long> distance;  // moves from each cell to the ladder, -1 if it cannot get there
+
+        virtual long score(const BoardView& board, size_t r, size_t c) {
+            long d = distance[r * board.getNumCols() + c];
+            return d < 0 ? 100000 : d;
+        }
+
+    public:
+        // walls and abysses stay put during a game (apart from the odd wall a deflected
+        // baddie lands on), so the distances are worked out once per game
+        virtual void startGame(const BoardView& board, unsigned seed) {
+            ScoredPolicy::startGame(board, seed);
+            size_t rows = board.getNumRows();
+            size_t cols = board.getNumCols();
+            distance.assign(rows * cols, -1);
+            frontier.clear();
+            distance[ladderRow * cols + ladderCol] = 0;
+            frontier.push_back(ladderRow * cols + ladderCol);
+            while (!frontier.empty()) {
+                size_t at = frontier.front();
+                frontier.pop_front();
+                for (int i = 1; i < 9; i++) {
+                    size_t r = at / cols + kHeroMoveRow[i];
+                    size_t c = at % cols + kHeroMoveCol[i];
+                    if (r >= rows || c >= cols || distance[r * cols + c] >= 0) {
+                        continue;
+                    }
+                    unsigned char tile = board.getCellTile(r, c);
+                    if (tile == TileWall || tile == TileAbyss) {
+                        continue;
+                    }
+                    distance[r * cols + c] = distance[at] + 1;
+                    frontier.push_back(r * cols + c);
+                }
+            }
+        }
+
+        virtual string name() const {
+            return "planner";
+        }
+};
+
+class SafePathPolicy : public PlannerPolicy {
+    private:
+        vector<unsigned char> threatened;
+        vector<long> safeDistance;  // moves to the ladder over cells no baddie can reach, -1 if none
+        deque<size_t> queue;
+
+    public:
+        virtual char nextMove(const BoardView& board) {
+            size_t rows = board.getNumRows();
+            size_t cols = board.getNumCols();
+            markThreatenedCells(board, threatened);
+            safeDistance.assign(rows * cols, -1);
+            queue.clear();
+            safeDistance[ladderRow * cols + ladderCol] = 0;
+            queue.push_back(ladderRow * cols + ladderCol);
+            while (!queue.empty()) {
+                size_t at = queue.front();
+                queue.pop_front();
+                for (int i = 1; i < 9; i++) {
+                    size_t r = at / cols + kHeroMoveRow[i];
+                    size_t c = at % cols + kHeroMoveCol[i];
+                    if (r >= rows || c >= cols || safeDistance[r * cols + c] >= 0) {
+                        continue;
+                    }
+                    if (!heroCanEnter(board, r, c) || threatened[r * cols + c]) {
+                        continue;
+                    }
+                    safeDistance[r * cols + c] = safeDistance[at] + 1;
+                    queue.push_back(r * cols + c);
+                }
+            }
+
+            size_t heroRow, heroCol;
+            board.getHeroPosition(heroRow, heroCol);
+            char best = 0;
+            long bestDistance = 0;
+            for (int i = 0; i < 9; i++) {
+                size_t r = heroRow + kHeroMoveRow[i];
+                size_t c = heroCol + kHeroMoveCol[i];
+                if (r >= rows || c >= cols) {
+                    continue;
+                }
+                long d = safeDistance[r * cols + c];
+                if (d >= 0 && (best == 0 || d < bestDistance)) {
+                    best = kHeroMoves[i];
+                    bestDistance = d;
+                }
+            }
+            return best != 0 ? best : PlannerPolicy::nextMove(board);
+        }
+
+        virtual string name() const {
+            return "safe";
+        }
+};
+
+
+// Looks ahead by playing moves for real on a board of its own, set up from the tiles
+// of the board it is asked about and rewound after every try, so the baddies move
+// exactly as they will in the game (as long as their moves depend only on the tiles,
+// which they do).
+class SearchPolicy : public PlannerPolicy {
+    private:
+        unique_ptr<GameBoardBase> sim;
+        vector<unsigned char> tiles;
+
+        // how good it is to be where sim stands now; higher is better
+        long leafValue() {
+            size_t r, c;
+            sim->getHeroPosition(r, c);
+            long d = distance[r * sim->getNumCols() + c];
+            return -(d < 0 ? 100000 : d);
+        }
+
+        // the value of playing move on sim and then the best depth - 1 moves after it
+        long tryMove(char move, int depth) {
+            long value;
+            if (!sim->makeMoves(move)) {
+                // escaping sooner beats escaping later; dying later beats dying sooner
+                value = sim->getWonGame() ? 1000000 + depth : -1000000 - depth;
+            }
+            else if (depth == 1) {
+                value = leafValue();
+            }
+            else {
+                value = bestMove(depth - 1, NULL);
+            }
+            sim->rewind(1);
+            return value;
+        }
+
+        // the best value of the next depth moves; *move is set to the first of them
+        long bestMove(int depth, char* move) {
+            long best = 0;
+            for (int i = 0; i < 9; i++) {
+                long value = tryMove(kHeroMoves[i], depth);
+                if (i == 0 || value > best) {
+                    best = value;
+                    if (move != NULL) {
+                        *move = kHeroMoves[i];
+                    }
+                }
+            }
+            return best;
+        }
+
+    public:
+        virtual void startGame(const BoardView& board, unsigned seed) {
+            PlannerPolicy::startGame(board, seed);
+            size_t rows = board.getNumRows();
+            size_t cols = board.getNumCols();
+            if (!sim || sim->getNumRows() != rows || sim->getNumCols() != cols) {
+                sim.reset(makeGameBoard(rows, cols));
+                sim->setVerbose(false);
+                // every move changes at most two cells per entity on the board
+                sim->setUndoLimit(kSearchDepth, kSearchDepth * 2 * rows * cols);
+                tiles.resize(rows * cols);
+            }
+        }
+
+        virtual char nextMove(const BoardView& board) {
+            board.getTiles(&tiles[0]);
+            sim->setupFromTiles(&tiles[0]);
+            sim->setCollisionPolicy(board.getCollisionPolicy());
+            char move = 's';
+            bestMove(kSearchDepth, &move);
+            return move;
+        }
+
+        virtual string name() const {
+            return "search";
+        }
+};
+
+// returns a new policy by name (see kHeroPolicyNames), or NULL for an unknown name
+inline HeroPolicy* makeHeroPolicy(const string& name) {
+    if (name == "random") {
+        return new RandomPolicy();
+    }
+    if (name == "greedy") {
+        return new GreedyPolicy();
+    }
+    if (name == "planner") {
+        return new PlannerPolicy();
+    }
+    if (name == "safe") {
+        return new SafePathPolicy();
+    }
+    if (name == "search") {
+        return new SearchPolicy();
+    }
+    return NULL;
+}
+
+#endif //_HEROPOLICY_H
@@ -0,0 +1,238 @@
+/*
+    Filename: "levelgen.cpp"
+    Author: Viraj Saudagar
+
+    Level corpus generator. Runs setupBoard() over consecutive seeds on
+    every core, keeps the boards that pass the requested constraints, and
+    writes them into a level library (see levellibrary.h) that servers can
+    draw pre-validated levels from in O(1).
+
+    Seeds are handed out in fixed-size batches and accepted boards are
+    written in seed order, so the same arguments always produce the same
+    library no matter how many threads ran.
+
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+#include "gameboard.h"
+#include "levellibrary.h"
+
+struct GeneratorOptions {
+    int rows, cols, abysses, monsters, bats;
+    long long startSeed;
+    size_t count;           // boards to accept
+    size_t maxSeeds;        // give up after trying this many seeds
+    bool requireSolvable;
+    int minEscape, maxEscape;
+    double minDensity, maxDensity;  // baddies per cell of the middle segment
+    int minHeroDistance;
+};
+
+// Accepted boards of one batch of seeds, in seed order.
+struct Batch {
+    size_t tried;
+    vector<LevelInfo> infos;
+    vector<unsigned char> tiles;  // infos.size() boards back to back
+};
+
+static const size_t kBatchSeeds = 256;
+
+bool accept(const GeneratorOptions& opt, const LevelInfo& info) {
+    if (opt.requireSolvable && info.escapeDistance == kUnreachable) {
+        return false;
+    }
+    if (info.escapeDistance < opt.minEscape || (opt.maxEscape >= 0 && info.escapeDistance > opt.maxEscape)) {
+        return false;
+    }
+    double density = (double)info.baddies / (opt.rows * (opt.cols - 6));
+    if (density < opt.minDensity || density > opt.maxDensity) {
+        return false;
+    }
+    return info.heroBaddieDistance >= opt.minHeroDistance;
+}
+
+Batch generateBatch(const GeneratorOptions& opt, size_t batch) {
+    Batch out;
+    out.tried = 0;
+    size_t cells = (size_t)opt.rows * opt.cols;
+    vector<unsigned char> tiles(cells);
+
+    for (size_t i = 0; i < kBatchSeeds; i++) {
+        size_t seedIndex = batch * kBatchSeeds + i;
+        if (seedIndex >= opt.maxSeeds) {
+            break;
+        }
+        int seed = (int)(opt.startSeed + seedIndex);
+
+        unique_ptr<GameBoardBase> board(makeGameBoard(opt.rows, opt.cols));
+        board->setVerbose(false);
+        board->setNumAbysses(opt.abysses);
+        board->setNumMonsters(opt.monsters);
+        board->setNumBats(opt.bats);
+        board->setupBoard(seed);
+        board->getTiles(&tiles[0]);
+        out.tried++;
+
+        LevelInfo info;
+        analyzeLevel(&tiles[0], opt.rows, opt.cols, info);
+        info.seed = seed;
+        if (accept(opt, info)) {
+            out.infos.push_back(info);
+            out.tiles.insert(out.tiles.end(), tiles.begin(), tiles.end());
+        }
+    }
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+
+    GeneratorOptions opt;
+    opt.rows = 15;
+    opt.cols = 40;
+    opt.abysses = 20;
+    opt.monsters = 6;
+    opt.bats = 3;
+    opt.startSeed = 1;
+    opt.count = 10000;
+    opt.maxSeeds = 0;
+    opt.requireSolvable = true;
+    opt.minEscape = 0;
+    opt.maxEscape = -1;
+    opt.minDensity = 0;
+    opt.maxDensity = 1;
+    opt.minHeroDistance = 0;
+    size_t numThreads = 0;
+    string outPath = "levels.lib";
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--rows" && hasValue)                 opt.rows = atoi(argv[++i]);
+        else if (arg == "--cols" && hasValue)            opt.cols = atoi(argv[++i]);
+        else if (arg == "--abysses" && hasValue)         opt.abysses = atoi(argv[++i]);
+        else if (arg == "--monsters" && hasValue)        opt.monsters = atoi(argv[++i]);
+        else if (arg == "--bats" && hasValue)            opt.bats = atoi(argv[++i]);
+        else if (arg == "--start-seed" && hasValue)      opt.startSeed = atoll(argv[++i]);
+        else if (arg == "--count" && hasValue)           opt.count = atoll(argv[++i]);
+        else if (arg == "--max-seeds" && hasValue)       opt.maxSeeds = atoll(argv[++i]);
+        else if (arg == "--allow-unsolvable")            opt.requireSolvable = false;
+        else if (arg == "--min-escape" && hasValue)      opt.minEscape = atoi(argv[++i]);
+        else if (arg == "--max-escape" && hasValue)      opt.maxEscape = atoi(argv[++i]);
+        else if (arg == "--min-density" && hasValue)     opt.minDensity = atof(argv[++i]);
+        else if (arg == "--max-density" && hasValue)     opt.maxDensity = atof(argv[++i]);
+        else if (arg == "--min-hero-distance" && hasValue) opt.minHeroDistance = atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)         numThreads = atoi(argv[++i]);
+        else if (arg == "--out" && hasValue)             outPath = argv[++i];
+        else {
+            cout << "usage: " << argv[0] << " [--rows n] [--cols n] [--abysses n] [--monsters n] [--bats n]" << endl;
+            cout << "       [--count n] [--start-seed n] [--max-seeds n] [--threads n] [--out path]" << endl;
+            cout << "       [--allow-unsolvable] [--min-escape n] [--max-escape n]" << endl;
+            cout << "       [--min-density x] [--max-density x] [--min-hero-distance n]" << endl;
+            return 1;
+        }
+    }
+    if (opt.rows < 10 || opt.cols < 15 || opt.abysses < 0 || opt.monsters < 0 || opt.bats < 0
+        || opt.abysses + opt.monsters + opt.bats > opt.rows * (opt.cols - 6) / 2) {
+        cout << "board parameters out of range" << endl;
+        return 1;
+    }
+    if (opt.maxSeeds == 0) {
+        opt.maxSeeds = opt.count * 1000;
+    }
+    if (numThreads == 0) {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+
+    LevelLibraryWriter writer(outPath, opt.rows, opt.cols);
+
+    // workers claim batch numbers; the main thread writes finished batches in order
+    atomic<size_t> nextBatch(0);
+    atomic<bool> done(false);
+    mutex lock;
+    condition_variable finished;  // a batch was added to ready
+    condition_variable consumed;  // the writer took a batch out of ready
+    map<size_t, Batch> ready;
+    size_t writing = 0;           // batch the writer is waiting for
+    size_t maxAhead = 4 * numThreads;
+    size_t lastBatch = (opt.maxSeeds + kBatchSeeds - 1) / kBatchSeeds;
+
+    vector<thread> workers;
+    for (size_t t = 0; t < numThreads; t++) {
+        workers.push_back(thread([&]() {
+            while (!done) {
+                size_t batch = nextBatch++;
+                if (batch >= lastBatch) {
+                    break;
+                }
+                Batch result = generateBatch(opt, batch);
+                {
+                    // keep the reorder buffer bounded while the writer catches up
+                    unique_lock<mutex> guard(lock);
+                    while (!done && batch > writing + maxAhead) {
+                        consumed.wait(guard);
+                    }
+                    ready[batch] = move(result);
+                }
+                finished.notify_all();
+            }
+        }));
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t tried = 0;
+    size_t cells = (size_t)opt.rows * opt.cols;
+    for (size_t batch = 0; batch < lastBatch && writer.size() < opt.count; batch++) {
+        Batch result;
+        {
+            unique_lock<mutex> guard(lock);
+            while (ready.find(batch) == ready.end()) {
+                finished.wait(guard);
+            }
+            result = move(ready[batch]);
+            ready.erase(batch);
+            writing = batch + 1;
+        }
+        consumed.notify_all();
+        tried += result.tried;
+        for (size_t i = 0; i < result.infos.size() && writer.size() < opt.count; i++) {
+            writer.add(&result.tiles[i * cells], result.infos[i]);
+        }
+        if ((batch + 1) % 400 == 0) {
+            cout << "tried " << tried << " seeds, accepted " << writer.size() << endl;
+        }
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        done = true;
+    }
+    consumed.notify_all();
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    writer.close();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Wrote " << writer.size() << " levels (" << opt.rows << "x" << opt.cols << ") to " << outPath << endl;
+    cout << "tried " << tried << " seeds in " << seconds << " s on " << numThreads << " threads ("
+         << (long long)(tried / seconds) << " boards/s), acceptance " << (tried ? 100.0 * writer.size() / tried : 0) << "%" << endl;
+    if (writer.size() < opt.count) {
+        cout << "stopped after --max-seeds " << opt.maxSeeds << " seeds before reaching --count" << endl;
+        return 1;
+    }
+
+    return 0;
+
+} // main
@@ -0,0 +1,315 @@
+/*
+    Filename: "levellibrary.h"
+    Author: Viraj Saudagar
+
+    This file defines the on-disk level library: a single file of
+    pre-generated, pre-validated boards that all share one size.
+
+        header   (64 bytes)  magic, version, rows, cols, record size, count,
+                             offsets of the records and of the index
+        records  (count x recordBytes)  tiles of one board, two 4-bit
+                             TileType codes per byte, row after row
+        index    (count x LevelInfo)    seed and metrics of each board
+
+    Every record and index entry has a fixed size, so level i is found
+    with one multiplication. LevelLibrary maps the file into memory and
+    hands out levels in O(1) without reading the rest of the file;
+    LevelLibraryWriter appends records and writes the index on close().
+    Numbers are stored in the byte order of the machine that wrote them.
+
+    analyzeLevel() computes the metrics stored in LevelInfo and is what
+    the generator (levelgen.cpp) filters on.
+
+*/
+
+#ifndef _LEVELLIBRARY_H
+#define _LEVELLIBRARY_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tiles.h"
+#include "gameboard.h"
+
+using namespace std;
+
+struct LevelLibraryHeader {
+    char magic[8];          // "HBLEVELS"
+    uint32_t version;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t recordBytes;   // bytes of packed tiles per level
+    uint64_t count;         // number of levels
+    uint64_t recordsOffset;
+    uint64_t indexOffset;
+    char padding[16];
+};
+
+struct LevelInfo {
+    int32_t seed;                 // seed that setupBoard() turned into this level
+    uint16_t escapeDistance;      // fewest hero moves to the ladder over walls/abysses (kUnreachable if none)
+    uint16_t heroBaddieDistance;  // rows/cols between the hero and the closest baddie (kUnreachable if none)
+    uint16_t baddies;             // monsters + super monsters + bats
+    uint16_t abysses;
+    uint16_t reserved[2];
+};
+
+static_assert(sizeof(LevelLibraryHeader) == 64, "LevelLibraryHeader is part of the file format");
+static_assert(sizeof(LevelInfo) == 16, "LevelInfo is part of the file format");
+
+static const char kLevelMagic[8] = {'H', 'B', 'L', 'E', 'V', 'E', 'L', 'S'};
+static const uint32_t kLevelVersion = 1;
+static const uint16_t kUnreachable = 0xFFFF;
+
+//---------------------------------------------------------------------------------
+// void analyzeLevel(const unsigned char* tiles, size_t rows, size_t cols, LevelInfo& info)
+//
+// Fills in every LevelInfo field except seed. The escape distance is a breadth
+// first search over the hero's 8 moves through cells that are not walls or
+// abysses. Baddies are ignored since they will have moved by the time the hero
+// gets there.
+//---------------------------------------------------------------------------------
+inline void analyzeLevel(const unsigned char* tiles, size_t rows, size_t cols, LevelInfo& info) {
+    size_t cells = rows * cols;
+    size_t hero = cells;
+    info.escapeDistance = kUnreachable;
+    info.heroBaddieDistance = kUnreachable;
+    info.baddies = 0;
+    info.abysses = 0;
+    info.reserved[0] = info.reserved[1] = 0;
+
+    for (size_t i = 0; i < cells; i++) {
+        if (tiles[i] == TileHero) {
+            hero = i;
+        }
+        else if (tiles[i] == TileAbyss) {
+            info.abysses++;
+        }
+        else if (tiles[i] == TileMonster || tiles[i] == TileSuperMonster || tiles[i] == TileBat) {
+            info.baddies++;
+        }
+    }
+    if (hero == cells) {
+        return;
+    }
+
+    size_t hr = hero / cols;
+    size_t hc = hero % cols;
+    for (size_t i = 0; i < cells; i++) {
+        if (tiles[i] == TileMonster || tiles[i] == TileSuperMonster || tiles[i] == TileBat) {
+            size_t r = i / cols;
+            size_t c = i % cols;
+            size_t d = max(r > hr ? r - hr : hr - r, c > hc ? c - hc : hc - c);
+            info.heroBaddieDistance = (uint16_t)min((size_t)info.heroBaddieDistance, d);
+        }
+    }
+
+    vector<uint16_t> dist(cells, kUnreachable);
+    deque<size_t> frontier;
+    dist[hero] = 0;
+    frontier.push_back(hero);
+    while (!frontier.empty()) {
+        size_t at = frontier.front();
+        frontier.pop_front();
+        if (tiles[at] == TileLadder) {
+            info.escapeDistance = dist[at];
+            return;
+        }
+        size_t r = at / cols;
+        size_t c = at % cols;
+        for (int dr = -1; dr <= 1; dr++) {
+            for (int dc = -1; dc <= 1; dc++) {
+                size_t nr = r + dr;
+                size_t nc = c + dc;
+                if ((dr == 0 && dc == 0) || nr >= rows || nc >= cols) {
+                    continue;
+                }
+                size_t next = nr * cols + nc;
+                if (dist[next] != kUnreachable || tiles[next] == TileWall || tiles[next] == TileAbyss) {
+                    continue;
+                }
+                dist[next] = dist[at] + 1;
+                frontier.push_back(next);
+            }
+        }
+    }
+}
+
+
+class LevelLibraryWriter {
+    private:
+        FILE* file;
+        LevelLibraryHeader header;
+        vector<LevelInfo> index;
+        vector<unsigned char> packed;
+
+    public:
+        /* param constructor -> creates (or truncates) the library file */
+        LevelLibraryWriter(const string& path, size_t rows, size_t cols) {
+            file = fopen(path.c_str(), "wb");
+            if (file == NULL) {
+                throw runtime_error("LevelLibraryWriter constructor -> could not create " + path);
+            }
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, kLevelMagic, sizeof(kLevelMagic));
+            header.version = kLevelVersion;
+            header.rows = rows;
+            header.cols = cols;
+            header.recordBytes = (rows * cols + 1) / 2;
+            header.recordsOffset = sizeof(header);
+            fwrite(&header, sizeof(header), 1, file);
+            packed.resize(header.recordBytes);
+        }
+
+        /* destructor */
+        virtual ~LevelLibraryWriter() {
+            close();
+        }
+
+        // appends one level (rows x cols TileType codes)
+        void add(const unsigned char* tiles, const LevelInfo& info) {
+            fill(packed.begin(), packed.end(), 0);
+            size_t cells = (size_t)header.rows * header.cols;
+            for (size_t i = 0; i < cells; i++) {
+                packed[i / 2] |= (unsigned char)((tiles[i] & 0x0F) << ((i & 1) * 4));
+            }
+            fwrite(&packed[0], packed.size(), 1, file);
+            index.push_back(info);
+        }
+
+        size_t size() const {
+            return index.size();
+        }
+
+        // writes the index and the final header; called by the destructor if needed
+        void close() {
+            if (file == NULL) {
+                return;
+            }
+            header.count = index.size();
+            header.indexOffset = header.recordsOffset + header.count * header.recordBytes;
+            if (!index.empty()) {
+                fwrite(&index[0], sizeof(LevelInfo), index.size(), file);
+            }
+            fseek(file, 0, SEEK_SET);
+            fwrite(&header, sizeof(header), 1, file);
+            fclose(file);
+            file = NULL;
+        }
+
+    private:
+        LevelLibraryWriter(const LevelLibraryWriter&);
+        LevelLibraryWriter& operator=(const LevelLibraryWriter&);
+};
+
+
+class LevelLibrary {
+    private:
+        int fd;
+        size_t mapSize;
+        const unsigned char* base;
+        const LevelLibraryHeader* header;
+        const LevelInfo* index;
+        const unsigned char* records;
+
+    public:
+        /* param constructor -> maps an existing library file read-only */
+        explicit LevelLibrary(const string& path) {
+            fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw runtime_error("LevelLibrary constructor -> could not open " + path);
+            }
+            struct stat info;
+            fstat(fd, &info);
+            mapSize = info.st_size;
+            if (mapSize < sizeof(LevelLibraryHeader)) {
+                ::close(fd);
+                throw runtime_error("LevelLibrary constructor -> " + path + " is not a level library");
+            }
+            void* mapped = mmap(NULL, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw runtime_error("LevelLibrary constructor -> could not map " + path);
+            }
+            base = (const unsigned char*)mapped;
+            header = (const LevelLibraryHeader*)base;
+
+            bool valid = memcmp(header->magic, kLevelMagic, sizeof(kLevelMagic)) == 0
+                && header->version == kLevelVersion
+                && header->recordBytes == ((uint64_t)header->rows * header->cols + 1) / 2
+                && header->indexOffset == header->recordsOffset + header->count * header->recordBytes
+                && header->indexOffset + header->count * sizeof(LevelInfo) <= mapSize;
+            if (!valid) {
+                munmap((void*)base, mapSize);
+                ::close(fd);
+                throw runtime_error("LevelLibrary constructor -> " + path + " is damaged or from another version");
+            }
+            records = base + header->recordsOffset;
+            index = (const LevelInfo*)(base + header->indexOffset);
+        }
+
+        /* destructor */
+        virtual ~LevelLibrary() {
+            munmap((void*)base, mapSize);
+            ::close(fd);
+        }
+
+        size_t size() const {
+            return header->count;
+        }
+
+        size_t numRows() const {
+            return header->rows;
+        }
+
+        size_t numCols() const {
+            return header->cols;
+        }
+
+        // metrics of level i
+        const LevelInfo& info(size_t i) const {
+            if (i >= header->count) {
+                throw out_of_range("LevelLibrary info -> no such level");
+            }
+            return index[i];
+        }
+
+        // unpacks level i into tiles (rows x cols TileType codes)
+        void tiles(size_t i, unsigned char* out) const {
+            if (i >= header->count) {
+                throw out_of_range("LevelLibrary tiles -> no such level");
+            }
+            const unsigned char* record = records + i * header->recordBytes;
+            size_t cells = (size_t)header->rows * header->cols;
+            for (size_t k = 0; k < cells; k++) {
+                out[k] = (record[k / 2] >> ((k & 1) * 4)) & 0x0F;
+            }
+        }
+
+        // sets up board (which has to be rows x cols) as level i
+        void loadInto(size_t i, GameBoardBase& board) const {
+            if (board.getNumRows() != header->rows || board.getNumCols() != header->cols) {
+                throw invalid_argument("LevelLibrary loadInto -> board size does not match the library");
+            }
+            vector<unsigned char> unpacked((size_t)header->rows * header->cols);
+            tiles(i, &unpacked[0]);
+            board.setupFromTiles(&unpacked[0]);
+        }
+
+    private:
+        LevelLibrary(const LevelLibrary&);
+        LevelLibrary& operator=(const LevelLibrary&);
+};
+
+#endif //_LEVELLIBRARY_H
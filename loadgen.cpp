@@ -0,0 +1,336 @@
+/*
+    Filename: "loadgen.cpp"
+    Author: Viraj Saudagar
+
+    Load generator for the game server. Opens a few connections, creates
+    many sessions, and keeps one MOVE in flight per session until the
+    requested number of moves has been answered. Finished games are ended
+    and replaced with a fresh seed so the session count stays constant.
+
+    Reports p50/p99 move latency, throughput, and - using the server's own
+    CPU time from STATS - how many sessions one core could sustain at the
+    given per-session move rate.
+
+    With --half-close it only checks that commands a client sends right
+    before shutting down its side of the socket are still answered: it
+    creates a session, sends a MOVE and an END, shuts down writing and
+    expects MOVED and ENDED before the server closes the connection. Whether
+    the server sees the EOF in the same read as the commands depends on
+    timing, so this is tried kHalfCloseTries times.
+
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+struct LoadConnection {
+    int fd;
+    string inbuf;
+    string outbuf;
+    deque<size_t> awaitingCreate;  // session slots waiting on a CREATED reply
+};
+
+struct SessionSlot {
+    size_t conn;
+    size_t id;
+    Clock::time_point sentAt;
+};
+
+static string socketPath = "/tmp/heroboard.sock";
+
+int connectToServer() {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        cout << "could not connect to " << socketPath << endl;
+        exit(1);
+    }
+    return fd;
+}
+
+void flushOut(LoadConnection& conn) {
+    while (!conn.outbuf.empty()) {
+        ssize_t n = send(conn.fd, conn.outbuf.data(), conn.outbuf.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            conn.outbuf.erase(0, n);
+        }
+        else if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            break;
+        }
+    }
+}
+
+// Blocking request/reply on a quiet connection, used for STATS.
+string ask(int fd, const string& line) {
+    string msg = line + "\n";
+    ssize_t ignored = send(fd, msg.data(), msg.size(), MSG_NOSIGNAL);
+    (void)ignored;
+    string reply;
+    char ch;
+    while (recv(fd, &ch, 1, 0) == 1 && ch != '\n') {
+        reply += ch;
+    }
+    return reply;
+}
+
+static const int kHalfCloseTries = 20;
+
+//---------------------------------------------------------------------------------
+// bool checkHalfClose(const string& params)
+//
+// Sends MOVE and END for a new session and half-closes right away; true if both
+// were answered before the server hung up.
+//---------------------------------------------------------------------------------
+bool checkHalfClose(const string& params) {
+    int fd = connectToServer();
+    string created = ask(fd, "NEW " + params + " 1");
+    istringstream in(created);
+    string verb;
+    size_t id = 0;
+    in >> verb >> id;
+    if (verb != "CREATED") {
+        cout << "half-close: NEW answered \"" << created << "\"" << endl;
+        close(fd);
+        return false;
+    }
+    ostringstream cmd;
+    cmd << "MOVE " << id << " d\nEND " << id << "\n";
+    string msg = cmd.str();
+    ssize_t ignored = send(fd, msg.data(), msg.size(), MSG_NOSIGNAL);
+    (void)ignored;
+    shutdown(fd, SHUT_WR);
+
+    string replies;
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        replies.append(buf, n);
+    }
+    close(fd);
+
+    ostringstream moved, ended;
+    moved << "MOVED " << id << ' ';
+    ended << "ENDED " << id << '\n';
+    bool ok = replies.find(moved.str()) == 0 && replies.find(ended.str()) != string::npos;
+    if (!ok) {
+        cout << "half-close: session " << id << " got \"" << replies << "\"" << endl;
+    }
+    return ok;
+}
+
+long long statValue(const string& stats, const string& key) {
+    size_t at = stats.find(key + "=");
+    if (at == string::npos) {
+        return 0;
+    }
+    return atoll(stats.c_str() + at + key.size() + 1);
+}
+
+int main(int argc, char* argv[]) {
+
+    size_t numConns = 4;
+    size_t numSessions = 1000;
+    size_t numMoves = 100000;
+    double movesPerSecond = 4.0;   // pace of one human player, for the sessions/core estimate
+    string params = "15 40 20 6 3";
+    const char moves[] = "qazwxedcs";
+    bool halfClose = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (arg == "--connections" && i + 1 < argc) {
+            numConns = max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--sessions" && i + 1 < argc) {
+            numSessions = max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--moves" && i + 1 < argc) {
+            numMoves = max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--rate" && i + 1 < argc) {
+            movesPerSecond = atof(argv[++i]);
+        }
+        else if (arg == "--params" && i + 1 < argc) {
+            params = argv[++i];
+        }
+        else if (arg == "--half-close") {
+            halfClose = true;
+        }
+        else {
+            cout << "usage: " << argv[0] << " [--socket path] [--connections n] [--sessions n] [--moves n]"
+                 << " [--rate moves/sec/session] [--params \"rows cols abysses monsters bats\"] [--half-close]" << endl;
+            return 1;
+        }
+    }
+
+    if (halfClose) {
+        int answered = 0;
+        for (int t = 0; t < kHalfCloseTries; t++) {
+            answered += checkHalfClose(params) ? 1 : 0;
+        }
+        cout << "half-close: " << answered << " of " << kHalfCloseTries << " got MOVED and ENDED" << endl;
+        return answered == kHalfCloseTries ? 0 : 1;
+    }
+
+    int statsFd = connectToServer();
+    string before = ask(statsFd, "STATS");
+
+    vector<LoadConnection> conns(numConns);
+    vector<pollfd> fds(numConns);
+    for (size_t i = 0; i < numConns; i++) {
+        conns[i].fd = connectToServer();
+        fds[i].fd = conns[i].fd;
+    }
+
+    vector<SessionSlot> slots(numSessions);
+    unordered_map<size_t, size_t> slotOfId;
+    unsigned int nextSeed = 1;
+    srand(12345);
+
+    for (size_t s = 0; s < numSessions; s++) {
+        slots[s].conn = s % numConns;
+        slots[s].id = 0;
+        ostringstream cmd;
+        cmd << "NEW " << params << ' ' << nextSeed++ << '\n';
+        conns[slots[s].conn].outbuf += cmd.str();
+        conns[slots[s].conn].awaitingCreate.push_back(s);
+    }
+
+    vector<double> latencies;
+    latencies.reserve(numMoves);
+    size_t gamesFinished = 0;
+    size_t errors = 0;
+    Clock::time_point start = Clock::now();
+
+    while (latencies.size() < numMoves) {
+        for (size_t i = 0; i < numConns; i++) {
+            flushOut(conns[i]);
+            fds[i].events = POLLIN | (conns[i].outbuf.empty() ? 0 : POLLOUT);
+        }
+        if (poll(&fds[0], fds.size(), 10000) <= 0) {
+            cout << "server stopped answering" << endl;
+            return 1;
+        }
+
+        for (size_t i = 0; i < numConns; i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP))) {
+                continue;
+            }
+            LoadConnection& conn = conns[i];
+            char buf[65536];
+            ssize_t n = recv(conn.fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n == 0) {
+                cout << "server closed the connection" << endl;
+                return 1;
+            }
+            if (n < 0) {
+                continue;
+            }
+            conn.inbuf.append(buf, n);
+
+            size_t startAt = 0;
+            size_t end;
+            while ((end = conn.inbuf.find('\n', startAt)) != string::npos) {
+                istringstream line(conn.inbuf.substr(startAt, end - startAt));
+                startAt = end + 1;
+
+                string verb;
+                size_t id = 0;
+                line >> verb >> id;
+                Clock::time_point now = Clock::now();
+
+                if (verb == "CREATED" && !conn.awaitingCreate.empty()) {
+                    size_t s = conn.awaitingCreate.front();
+                    conn.awaitingCreate.pop_front();
+                    slots[s].id = id;
+                    slotOfId[id] = s;
+                }
+                else if (verb == "MOVED") {
+                    int alive = 0;
+                    line >> alive;
+                    size_t s = slotOfId[id];
+                    latencies.push_back(chrono::duration<double, micro>(now - slots[s].sentAt).count());
+                    if (!alive) {
+                        gamesFinished++;
+                        slotOfId.erase(id);
+                        ostringstream cmd;
+                        cmd << "END " << id << "\nNEW " << params << ' ' << nextSeed++ << '\n';
+                        conn.outbuf += cmd.str();
+                        conn.awaitingCreate.push_back(s);
+                        continue;
+                    }
+                }
+                else if (verb == "ERR") {
+                    errors++;
+                    continue;
+                }
+                else {
+                    continue;
+                }
+
+                // the session is idle again, keep one move in flight
+                size_t s = slotOfId[id];
+                slots[s].sentAt = now;
+                ostringstream cmd;
+                cmd << "MOVE " << id << ' ' << moves[rand() % 9] << '\n';
+                conn.outbuf += cmd.str();
+            }
+            conn.inbuf.erase(0, startAt);
+        }
+    }
+
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    string after = ask(statsFd, "STATS");
+    for (size_t i = 0; i < numConns; i++) {
+        close(conns[i].fd);
+    }
+    close(statsFd);
+
+    sort(latencies.begin(), latencies.end());
+    double p50 = latencies[latencies.size() / 2];
+    double p99 = latencies[min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    double cpuSeconds = (statValue(after, "cpu_ms") - statValue(before, "cpu_ms")) / 1000.0;
+    double movesPerCpuSecond = cpuSeconds > 0 ? latencies.size() / cpuSeconds : 0;
+
+    cout << "sessions:            " << numSessions << " over " << numConns << " connections" << endl;
+    cout << "moves answered:      " << latencies.size() << " in " << seconds << " s ("
+         << latencies.size() / seconds << " moves/s)" << endl;
+    cout << "games finished:      " << gamesFinished << ", errors: " << errors << endl;
+    cout << "move latency p50:    " << p50 << " us" << endl;
+    cout << "move latency p99:    " << p99 << " us" << endl;
+    cout << "server cpu:          " << cpuSeconds << " s on " << statValue(after, "workers") << " workers" << endl;
+    if (movesPerCpuSecond > 0 && movesPerSecond > 0) {
+        cout << "sessions per core:   " << (long long)(movesPerCpuSecond / movesPerSecond)
+             << " at " << movesPerSecond << " moves/s per session" << endl;
+    }
+
+    return 0;
+
+} // main
@@ -1,24 +1,218 @@
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <ctime>
+#include <memory>
 
 using namespace std;
 
 #include "gameboard.h"
+#include "realtime.h"
+#include "dungeon.h"
 
 char getHeroNextMove() {
     char HeroNextMove;
-    cout << "Your move. Where to? ['s' to stay, etc.]: " ;
+    cout << "Your move. Where to? ['s' to stay, 'u' to take back a turn, etc.]: " ;
     cin >> HeroNextMove;
     cout << endl;
     return HeroNextMove;
 }
 
-int main( ) {
-	
+// plays a turn on the dungeon's current level, or on board when there is no dungeon
+bool playTurn(GameBoardBase& board, Dungeon* dungeon, char move) {
+    return dungeon != NULL ? dungeon->makeMoves(move) : board.makeMoves(move);
+}
+
+// takes back one turn, through the dungeon (which uncounts it) when there is one
+size_t takeBackTurn(GameBoardBase& board, Dungeon* dungeon) {
+    return dungeon != NULL ? dungeon->rewind(1) : board.rewind(1);
+}
+
+// display() with every empty cell the baddies could catch the hero on drawn as kThreatGlyph
+void displayWithHints(GameBoardBase& board) {
+    const ThreatMap* threats = board.getThreats();
+    if (threats == NULL) {
+        board.display();
+        return;
+    }
+    size_t cols = board.getNumCols();
+    string border = '-' + string(cols, '-') + "-\n";
+    string text = border;
+    string row(cols, ' ');
+    for (size_t r = 0; r < board.getNumRows(); r++) {
+        board.renderRow(r, 0, cols, &row[0]);
+        for (size_t c = 0; c < cols; c++) {
+            if (row[c] == kTileGlyphs[TileEmpty] && threats->threatened(r, c)) {
+                row[c] = kThreatGlyph;
+            }
+        }
+        text += '|' + row + "|\n";
+    }
+    cout << text << border << flush;
+}
+
+// strips whitespace so scripts can be wrapped over several lines
+string cleanScript(const string& text) {
+    string moves;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (!isspace((unsigned char)text[i])) {
+            moves += text[i];
+        }
+    }
+    return moves;
+}
+
+void printUsage(const char* program) {
+    cout << "usage: " << program << " [--rows n] [--cols n] [--abysses n] [--monsters n] [--bats n] [--seed n]" << endl;
+    cout << "       [--realtime [--tick-rate n] [--frame-rate n] [--ticks n]]" << endl;
+    cout << "       [--script moves | --script-file path]" << endl;
+    cout << "       [--collisions block|swap|merge|legacy] [--log-level off|outcomes|all]" << endl;
+    cout << "       [--trace chrome.json] [--perf-markers markers.txt] [--fog radius] [--levels n] [--hints]" << endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    // board parameters given on the command line skip their prompt
     int numrows = 0; //15
     int numcols = 0; //40
+    int numA = -1;
+    int numM = -1;
+    int numB = -1;
+    int seed = -1;
+    bool seedGiven = false;
+
+    // --realtime runs the board on a fixed tick with non-blocking input
+    bool realTime = false;
+    double tickRate = 5;
+    double frameRate = 30;
+    size_t maxTicks = 0;
+
+    // --script / --script-file play a whole move string without redrawing
+    bool scripted = false;
+    string script;
+
+    // --collisions picks what a baddie does when it runs into another baddie
+    CollisionPolicy collisionPolicy = CollisionBlock;
+
+    // --log-level picks which of the board's diagnostic messages are shown
+    EventLevel logLevel = LogAll;
+
+    // --trace / --perf-markers record TraceSpans and write them when the game ends
+    string tracePath, markersPath;
+
+    // --fog hides every cell the hero cannot see from where it stands
+    int fogRadius = 0;
+
+    // --levels turns the ladder into the way down to the next level, n levels deep (0 = endless)
+    int numLevels = 1;
+
+    // --hints marks every cell where the baddies would catch the hero next turn
+    bool hints = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--rows" && hasValue) {
+            numrows = atoi(argv[++i]);
+        }
+        else if (arg == "--cols" && hasValue) {
+            numcols = atoi(argv[++i]);
+        }
+        else if (arg == "--abysses" && hasValue) {
+            numA = atoi(argv[++i]);
+        }
+        else if (arg == "--monsters" && hasValue) {
+            numM = atoi(argv[++i]);
+        }
+        else if (arg == "--bats" && hasValue) {
+            numB = atoi(argv[++i]);
+        }
+        else if (arg == "--seed" && hasValue) {
+            seed = atoi(argv[++i]);
+            seedGiven = true;
+        }
+        else if (arg == "--realtime") {
+            realTime = true;
+        }
+        else if (arg == "--tick-rate" && hasValue) {
+            tickRate = atof(argv[++i]);
+        }
+        else if (arg == "--frame-rate" && hasValue) {
+            frameRate = atof(argv[++i]);
+        }
+        else if (arg == "--ticks" && hasValue) {
+            maxTicks = atoi(argv[++i]);
+        }
+        else if (arg == "--script" && hasValue) {
+            scripted = true;
+            script = cleanScript(argv[++i]);
+        }
+        else if (arg == "--script-file" && hasValue) {
+            ifstream file(argv[++i]);
+            if (!file) {
+                cout << "could not open script file " << argv[i] << endl;
+                return 1;
+            }
+            stringstream text;
+            text << file.rdbuf();
+            scripted = true;
+            script = cleanScript(text.str());
+        }
+        else if (arg == "--collisions" && hasValue) {
+            if (!collisionPolicyOfName(argv[++i], collisionPolicy)) {
+                cout << "unknown collision policy " << argv[i] << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--log-level" && hasValue) {
+            if (!eventLevelOfName(argv[++i], logLevel)) {
+                cout << "unknown log level " << argv[i] << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        }
+        else if (arg == "--perf-markers" && hasValue) {
+            markersPath = argv[++i];
+        }
+        else if (arg == "--fog" && hasValue) {
+            fogRadius = atoi(argv[++i]);
+        }
+        else if (arg == "--levels" && hasValue) {
+            numLevels = atoi(argv[++i]);
+        }
+        else if (arg == "--hints") {
+            hints = true;
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (tickRate <= 0 || frameRate <= 0) {
+        cout << "tick and frame rates must be positive" << endl;
+        return 1;
+    }
+    if (fogRadius < 0) {
+        cout << "the fog radius cannot be negative" << endl;
+        return 1;
+    }
+    if (numLevels < 0) {
+        cout << "the number of levels cannot be negative" << endl;
+        return 1;
+    }
+    if (realTime && numLevels != 1) {
+        cout << "--realtime plays a single level" << endl;
+        return 1;
+    }
+    if (realTime && scripted) {
+        cout << "--realtime and --script cannot be combined" << endl;
+        return 1;
+    }
+
     while (numrows < 10 || numrows > 30) {
         cout << "Enter the number of rows (10-30) for the board: ";
         cin >> numrows;
@@ -29,17 +223,26 @@ int main( ) {
         cin >> numcols;
         cout << endl;
     }
-    GameBoard myBoard(numrows, numcols);
-    
-    int numA = -1;
+    unique_ptr<GameBoardBase> boardPtr(makeGameBoard(numrows, numcols));
+    GameBoardBase& myBoard = *boardPtr;
+    myBoard.setCollisionPolicy(collisionPolicy);
+    myBoard.setFogOfWar(fogRadius);
+    myBoard.setTrackThreats(hints);
+
+    // the board's messages are written by the log's own thread; flush() before
+    // every display() keeps them above the board they belong to
+    TextEventSink eventText(cout);
+    EventLog events(1 << 12, logLevel);
+    events.start(&eventText);
+    myBoard.setEventLog(&events, 0);
+
     while (numA < 0 || numA > 200) {
         cout << "Enter the number of abyss cells (0-200) on the board: ";
         cin >> numA;
         cout << endl;
     }
     myBoard.setNumAbysses(numA);
-    
-    int numM = -1;
+
     while (numM < 0 || numM > 30) {
         cout << "Enter the number of monsters (0-30) on the board, ~1/3 will be super monsters: ";
         cin >> numM;
@@ -47,7 +250,6 @@ int main( ) {
     }
     myBoard.setNumMonsters(numM);
 
-    int numB = -1;
     while (numB < 0 || numB > 10) {
         cout << "Enter the number of bats (0-10) on the board: ";
         cin >> numB;
@@ -55,33 +257,133 @@ int main( ) {
     }
     myBoard.setNumBats(numB);
 
-    int seed = -1;
-    cout << "Enter a seed for the random number generator (-1 to use system time): ";
-    cin >> seed;
-    cout << endl;
-    
+    if (!seedGiven) {
+        cout << "Enter a seed for the random number generator (-1 to use system time): ";
+        cin >> seed;
+        cout << endl;
+    }
+
+    setTracing(!tracePath.empty() || !markersPath.empty());
+
     if (seed < 0) {
-        myBoard.setupBoard(time(0));
+        seed = time(0);
+    }
+
+    // with --levels the dungeon makes every level, the first one included, on its own thread
+    unique_ptr<Dungeon> dungeon;
+    GameBoardBase* board = &myBoard;
+    if (numLevels != 1) {
+        DungeonConfig config;
+        config.rows = numrows;
+        config.cols = numcols;
+        config.abysses = numA;
+        config.monsters = numM;
+        config.bats = numB;
+        config.seed = seed;
+        config.numLevels = numLevels;
+        config.collisionPolicy = collisionPolicy;
+        config.fogRadius = fogRadius;
+        config.trackThreats = hints;
+        config.undoTurns = scripted ? 0 : 100;
+        config.undoChanges = scripted ? 0 : 10000;
+        config.verbose = !scripted;
+        config.eventLog = &events;
+        dungeon.reset(new Dungeon(config));
+        board = &dungeon->board();
     } else {
         myBoard.setupBoard(seed);
     }
-    myBoard.display();
-        
-    bool gameOver = false;
-    char nextMove;
-    while (!gameOver) {
-        nextMove = getHeroNextMove();
-        gameOver = !(myBoard.makeMoves(nextMove));
-        myBoard.display();
-    }  
-
-    if (myBoard.getWonGame()) {
+
+    // true once the script ran out with the hero still playing, after scriptTurns turns
+    bool scriptFinished = false;
+    size_t scriptTurns = 0;
+    if (scripted) {
+        // only the final state (or the turn the game ended on) is reported
+        size_t turnsPlayed = 0;
+        bool alive = true;
+        if (dungeon) {
+            while (alive && turnsPlayed < script.size()) {
+                alive = dungeon->makeMoves(script[turnsPlayed++]);
+                if (!alive && board->getWonGame() && dungeon->descend()) {
+                    board = &dungeon->board();
+                    alive = true;
+                }
+            }
+        } else {
+            alive = myBoard.runMoves(script, turnsPlayed);
+        }
+        events.flush();
+        displayWithHints(*board);
+        if (alive) {
+            scriptFinished = true;
+            scriptTurns = turnsPlayed;
+        } else {
+            cout << "Game ended on turn " << turnsPlayed << " of " << script.size() << "." << endl;
+        }
+    } else if (realTime) {
+        RealTimeGame game(myBoard, tickRate, frameRate);
+        game.setMaxTicks(maxTicks);
+        game.run();
+        game.report(cout);
+    } else {
+        // 'u' takes back the last turn, as far back as the undo history reaches
+        board->setUndoLimit(100, 10000);
+        displayWithHints(*board);
+
+        bool gameOver = false;
+        char nextMove;
+        while (!gameOver) {
+            nextMove = getHeroNextMove();
+            if (nextMove == 'u') {
+                if (takeBackTurn(*board, dungeon.get()) == 0) {
+                    cout << "Nothing to take back." << endl;
+                }
+            } else {
+                gameOver = !playTurn(*board, dungeon.get(), nextMove);
+            }
+            if (gameOver && board->getWonGame() && dungeon && dungeon->descend()) {
+                events.flush();
+                cout << "The ladder leads down to level " << dungeon->heroState().depth + 1 << "." << endl;
+                board = &dungeon->board();
+                gameOver = false;
+            }
+            events.flush();
+            displayWithHints(*board);
+        }
+    }
+
+    if (dungeon) {
+        const HeroState& hero = dungeon->heroState();
+        cout << "Reached level " << hero.depth + 1;
+        if (numLevels > 0) {
+            cout << " of " << numLevels;
+        }
+        cout << " in " << hero.turns << " turns." << endl;
+        if (dungeon->transitionMicros().count() > 0) {
+            cout << "Slowest level change: " << dungeon->transitionMicros().maximum() << " us" << endl;
+        }
+    }
+    if (scriptFinished) {
+        cout << "Script finished after " << scriptTurns << " turns." << endl;
+    } else if (dungeon ? dungeon->cleared() : board->getWonGame()) {
         cout << "Hero Escaped!" << endl;
     } else {
         cout << "Hero did not escape..." << endl;
     }
+    if (board->getCollisionCount(collisionPolicy) > 0) {
+        cout << "Baddie collisions (" << kCollisionPolicyNames[collisionPolicy] << "): "
+             << board->getCollisionCount(collisionPolicy) << endl;
+    }
     cout << "Game Over." << endl;
-	
+
+    if (tracingEnabled()) {
+        setTracing(false);
+        if (!saveTrace(tracePath, markersPath)) {
+            cout << "could not write the trace" << endl;
+            return 1;
+        }
+    }
+
 	return 0;
-	
+
 } // main
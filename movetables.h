@@ -0,0 +1,308 @@
+/*
+    Filename: "movetables.h"
+    Author: Viraj Saudagar
+
+    This file defines MoveTables, the resolved outcome of every move a
+    hero or monster can try from every cell. How a move resolves against
+    the board edges, walls, the ladder and abysses depends only on those
+    cells, so it is worked out once per cell instead of on every move:
+
+        table        moves resolved with          used for
+        HeroTable    the hero's rules, 1 step     the hero
+        Step1Table   the baddie rules, 1 step     monsters (m)
+        Step2Table   the baddie rules, 2 steps    super monsters (M)
+
+    Each entry is one byte for (table, cell, direction): where the move lands
+    relative to the start (MoveStay, MoveFull, MoveVertical or
+    MoveHorizontal) plus flags for what happened on the way (clamped at an
+    edge, stopped by a wall or the ladder, falls into an abyss, reaches the
+    ladder). Resolving a move is one lookup.
+
+    An entry is worked out the first time it is looked up and kept until
+    the terrain it depends on changes. Every cell carries the generation
+    its entries belong to, so clear() after setting up a board is one
+    increment rather than resolving (or even wiping) 27 moves per cell
+    that most games never make. Terrain can change during a game (a baddie
+    deflected onto a wall or the ladder removes it); every move reads cells
+    at most two rows or columns away, so terrainChanged() only forgets the
+    5 x 5 cells around it.
+
+    A Terrain (see terrain.h) resolves its tables completely once and hands
+    them to every board set up from it with share(). A board reads the
+    shared tables until its own terrain changes, then falls back to a
+    private cache of its own.
+
+    A board too big for a table per cell (one stored in a ChunkedGrid,
+    see chunkedgrid.h) gets no cache at all: its moves are resolved from
+    the tiles every time, which is a handful of reads.
+
+*/
+
+#ifndef _MOVETABLES_H
+#define _MOVETABLES_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <memory>
+
+#include "tiles.h"
+#include "chunkedgrid.h"
+
+using namespace std;
+
+enum MoveEntryBits {
+    MoveStay = 0,           // lands on the cell it started from
+    MoveFull = 1,           // lands where it aimed
+    MoveVertical = 2,       // only the row part of the move happened
+    MoveHorizontal = 3,     // only the column part of the move happened
+    MoveKindMask = 3,
+
+    MoveIntoAbyss = 4,      // the landing cell is an abyss
+    MoveOntoLadder = 8,     // the landing cell is the ladder (hero moves only)
+    MoveRowClamped = 16,    // the row would have left the board
+    MoveColClamped = 32,    // the column would have left the board
+    MoveBlocked = 64,       // the target was a wall (or, for baddies, the ladder)
+
+    MoveUnresolved = 0xff   // not worked out yet
+};
+
+// direction of a hero move key ('s' and unknown keys stand still)
+inline void heroDirection(char move, int& dr, int& dc) {
+    dr = 0;
+    dc = 0;
+    switch (move) {
+        case 'q': dr = -1; dc = -1; break;
+        case 'w': dr = -1;          break;
+        case 'e': dr = -1; dc = 1;  break;
+        case 'a':          dc = -1; break;
+        case 'd':          dc = 1;  break;
+        case 'z': dr = 1;  dc = -1; break;
+        case 'x': dr = 1;           break;
+        case 'c': dr = 1;  dc = 1;  break;
+        default: break;
+    }
+}
+
+class MoveTables {
+    public:
+        enum Table {
+            HeroTable = 0,
+            Step1Table = 1,
+            Step2Table = 2,
+            NumTables = 3
+        };
+
+    private:
+        size_t rows, cols;
+        const unsigned char* tiles;                // the board's occupancy map, rows x cols
+        const ChunkedGrid<unsigned char>* chunkedTiles; // or, for a sparse board, its chunked one
+        // everything about one cell in 32 bytes, so a lookup touches one cache line
+        struct CellMoves {
+            unsigned generation;                   // entry is stale unless this equals MoveTables::generation
+            unsigned char entry[NumTables][9];     // [table][direction], MoveUnresolved until looked up
+        };
+        vector<CellMoves> cells;                   // row after row, empty while shared
+        unsigned generation;                       // starts at 1; 0 marks a cell stale for good
+        shared_ptr<const MoveTables> shared;       // fully resolved tables in use instead of cells, if any
+
+        unsigned char tileAt(size_t r, size_t c) const {
+            return tiles != NULL ? tiles[r * cols + c] : (*chunkedTiles)(r, c);
+        }
+
+        // the entry for moving (dr, dc) from (r, c), worked out from the tiles
+        unsigned char resolve(Table table, size_t r, size_t c, int dr, int dc) const {
+            return (table == HeroTable) ? resolveHero(r, c, dr, dc)
+                                        : resolveBaddie(r, c, dr, dc, table == Step2Table ? 2 : 1);
+        }
+
+        static unsigned char kindOf(size_t r, size_t c, size_t newR, size_t newC) {
+            if (newR == r && newC == c) {
+                return MoveStay;
+            }
+            if (newR != r && newC != c) {
+                return MoveFull;
+            }
+            return newR != r ? MoveVertical : MoveHorizontal;
+        }
+
+        //---------------------------------------------------------------------------------
+        // The move rules themselves, as GameBoard::moveBaddies() and makeMoves() used to
+        // apply them one move at a time.
+        //---------------------------------------------------------------------------------
+        unsigned char resolveBaddie(size_t r, size_t c, int dr, int dc, int step) const {
+            unsigned char flags = 0;
+            size_t newR = r + dr * step;
+            size_t newC = c + dc * step;
+            if (newR >= rows) {
+                newR = r;
+                flags |= MoveRowClamped;
+            }
+            if (newC >= cols) {
+                newC = c;
+                flags |= MoveColClamped;
+            }
+            unsigned char target = tileAt(newR, newC);
+            if (target == TileWall || target == TileLadder) {
+                // straight into a wall stops the baddie; diagonal keeps the vertical
+                // part of the move, even when that cell is a wall as well
+                bool straight = (newR == r || newC == c);
+                newR = straight ? r : newR;
+                newC = c;
+                flags |= MoveBlocked;
+            }
+            if (tileAt(newR, newC) == TileAbyss) {
+                flags |= MoveIntoAbyss;
+            }
+            return flags | kindOf(r, c, newR, newC);
+        }
+
+        unsigned char resolveHero(size_t r, size_t c, int dr, int dc) const {
+            unsigned char flags = 0;
+            size_t newR = r + dr;
+            size_t newC = c + dc;
+            if (newR >= rows) {
+                newR = r;
+                flags |= MoveRowClamped;
+            }
+            if (newC >= cols) {
+                newC = c;
+                flags |= MoveColClamped;
+            }
+            if (tileAt(newR, newC) == TileWall) {
+                // diagonal into a wall keeps the vertical part unless that is blocked too
+                bool straight = (newR == r || newC == c);
+                newR = (straight || tileAt(newR, c) == TileWall) ? r : newR;
+                newC = c;
+                flags |= MoveBlocked;
+            }
+            unsigned char landing = tileAt(newR, newC);
+            if (landing == TileLadder) {
+                flags |= MoveOntoLadder;
+            }
+            else if (landing == TileAbyss) {
+                flags |= MoveIntoAbyss;
+            }
+            return flags | kindOf(r, c, newR, newC);
+        }
+
+    public:
+        MoveTables() : rows(0), cols(0), tiles(NULL), chunkedTiles(NULL), generation(1) {}
+
+        // sizes the tables for a rows x cols board whose occupancy map is at boardTiles;
+        // nothing is allocated until the first clear() or resolveAll()
+        void resize(size_t numRows, size_t numCols, const unsigned char* boardTiles) {
+            rows = numRows;
+            cols = numCols;
+            tiles = boardTiles;
+            chunkedTiles = NULL;
+            cells.clear();
+            shared.reset();
+            generation = 1;
+        }
+
+        // same for a sparse board; its moves are never cached
+        void resize(size_t numRows, size_t numCols, const ChunkedGrid<unsigned char>* boardTiles) {
+            resize(numRows, numCols, (const unsigned char*)NULL);
+            chunkedTiles = boardTiles;
+        }
+
+        // index of the direction (dr, dc), each -1, 0 or 1; 4 is standing still
+        static int direction(int dr, int dc) {
+            return (dr + 1) * 3 + (dc + 1);
+        }
+
+        // forgets every entry, e.g. after a new layout was set up, and stops using shared tables
+        void clear() {
+            shared.reset();
+            if (tiles == NULL) {
+                return;
+            }
+            if (cells.size() != rows * cols) {
+                CellMoves stale;
+                stale.generation = 0;
+                cells.assign(rows * cols, stale);
+            }
+            generation++;
+            if (generation == 0) {
+                // wrapped around: an old stamp could look current again
+                for (size_t i = 0; i < cells.size(); i++) {
+                    cells[i].generation = 0;
+                }
+                generation = 1;
+            }
+        }
+
+        // resolves every entry now, for tables that are going to be shared
+        void resolveAll() {
+            clear();
+            for (size_t r = 0; r < rows; r++) {
+                for (size_t c = 0; c < cols; c++) {
+                    for (int t = 0; t < NumTables; t++) {
+                        for (int dr = -1; dr <= 1; dr++) {
+                            for (int dc = -1; dc <= 1; dc++) {
+                                lookup((Table)t, r, c, dr, dc);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // uses tables (same size, resolved with resolveAll()) until the terrain changes
+        void share(const shared_ptr<const MoveTables>& tables) {
+            shared = tables;
+            vector<CellMoves>().swap(cells);
+        }
+
+        bool isShared() const {
+            return (bool)shared;
+        }
+
+        // forgets the entries of cells whose moves can reach (r, c), after its terrain changed
+        void terrainChanged(size_t r, size_t c) {
+            if (shared) {
+                // the shared tables describe the terrain as it was; start a private cache
+                clear();
+                return;
+            }
+            if (cells.empty()) {
+                return;
+            }
+            for (size_t nr = (r >= 2 ? r - 2 : 0); nr <= r + 2 && nr < rows; nr++) {
+                for (size_t nc = (c >= 2 ? c - 2 : 0); nc <= c + 2 && nc < cols; nc++) {
+                    cells[nr * cols + nc].generation = 0;
+                }
+            }
+        }
+
+        // the entry for moving (dr, dc) from (r, c) with the rules of table
+        unsigned char lookup(Table table, size_t r, size_t c, int dr, int dc) {
+            if (shared) {
+                return shared->cells[r * cols + c].entry[table][direction(dr, dc)];
+            }
+            if (tiles == NULL) {
+                return resolve(table, r, c, dr, dc);
+            }
+            CellMoves& cell = cells[r * cols + c];
+            if (cell.generation != generation) {
+                memset(cell.entry, MoveUnresolved, sizeof(cell.entry));
+                cell.generation = generation;
+            }
+            unsigned char& entry = cell.entry[table][direction(dr, dc)];
+            if (entry == MoveUnresolved) {
+                entry = resolve(table, r, c, dr, dc);
+            }
+            return entry;
+        }
+
+        // where a move of (dr, dc) times step from (r, c) with this entry ends up
+        static void landing(unsigned char entry, size_t r, size_t c, int dr, int dc, int step,
+                            size_t& newR, size_t& newC) {
+            unsigned char kind = entry & MoveKindMask;
+            newR = (kind == MoveFull || kind == MoveVertical) ? r + dr * step : r;
+            newC = (kind == MoveFull || kind == MoveHorizontal) ? c + dc * step : c;
+        }
+};
+
+#endif //_MOVETABLES_H
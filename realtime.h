@@ -0,0 +1,326 @@
+/*
+    Filename: "realtime.h"
+    Author: Viraj Saudagar
+
+    This file defines the RealTimeGame class which runs a GameBoard on a
+    fixed tick instead of waiting on the player. The terminal is switched
+    into raw mode and keys are read without blocking through ppoll(). Each
+    tick the hero takes the oldest queued key, or 's' when no key arrived,
+    and makeMoves() advances the game.
+
+    Rendering is decoupled from simulation: frames are drawn at their own
+    rate and only when the board changed, with the whole frame built in
+    memory and written with a single write().
+
+    The loop measures tick jitter (how late each tick started), simulation
+    time per tick, and input-to-frame latency (key read -> first frame
+    showing its effect written), and can print a report at the end.
+
+*/
+
+#ifndef _REALTIME_H
+#define _REALTIME_H
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <chrono>
+
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+
+#include "gameboard.h"
+
+using namespace std;
+
+// Collects timing samples (in microseconds) and reports percentiles.
+class LatencyStats {
+    private:
+        vector<double> samples;
+        bool sorted;
+
+    public:
+        LatencyStats() : sorted(true) {}
+
+        void add(double micros) {
+            samples.push_back(micros);
+            sorted = false;
+        }
+
+        size_t count() const {
+            return samples.size();
+        }
+
+        double percentile(double p) {
+            if (samples.empty()) {
+                return 0;
+            }
+            if (!sorted) {
+                sort(samples.begin(), samples.end());
+                sorted = true;
+            }
+            size_t at = (size_t)(p / 100.0 * (samples.size() - 1) + 0.5);
+            return samples[at];
+        }
+
+        double maximum() {
+            return percentile(100);
+        }
+};
+
+
+// Puts a terminal into raw (non-canonical, no echo) mode for its lifetime.
+// Does nothing when the file descriptor is not a terminal.
+class RawTerminal {
+    private:
+        int fd;
+        bool active;
+        struct termios saved;
+
+    public:
+        explicit RawTerminal(int fd) : fd(fd), active(false) {
+            if (!isatty(fd) || tcgetattr(fd, &saved) != 0) {
+                return;
+            }
+            struct termios raw = saved;
+            raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+            raw.c_cc[VMIN] = 0;
+            raw.c_cc[VTIME] = 0;
+            active = (tcsetattr(fd, TCSANOW, &raw) == 0);
+        }
+
+        ~RawTerminal() {
+            if (active) {
+                tcsetattr(fd, TCSANOW, &saved);
+            }
+        }
+
+        bool isActive() const {
+            return active;
+        }
+
+    private:
+        RawTerminal(const RawTerminal&);
+        RawTerminal& operator=(const RawTerminal&);
+};
+
+
+class RealTimeGame {
+    private:
+        typedef chrono::steady_clock Clock;
+
+        struct QueuedKey {
+            char move;
+            Clock::time_point readAt;
+        };
+
+        GameBoardBase& board;
+        Clock::duration tickPeriod;
+        Clock::duration framePeriod;
+        size_t maxTicks;  // 0 = run until the game ends or the player quits
+        bool render;
+
+        deque<QueuedKey> keys;
+        static const size_t kMaxQueuedKeys = 4;
+
+        LatencyStats tickJitter;
+        LatencyStats tickCost;
+        LatencyStats inputToFrame;
+        size_t ticks;
+        size_t overruns;  // ticks that started a full period or more late
+        size_t frames;
+        bool quit;
+        bool inputOpen;  // false once stdin reached end-of-file
+
+        static double micros(Clock::duration d) {
+            return chrono::duration<double, micro>(d).count();
+        }
+
+        static bool isMoveKey(char ch) {
+            switch (ch) {
+                case 'q': case 'a': case 'z': case 'w': case 'x':
+                case 'e': case 'd': case 'c': case 's':
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Reads whatever is waiting on stdin without blocking.
+        void readKeys() {
+            char buf[64];
+            ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+            if (n == 0 && !isatty(STDIN_FILENO)) {
+                inputOpen = false;  // piped input ran out, keep ticking with 's'
+            }
+            Clock::time_point now = Clock::now();
+            for (ssize_t i = 0; i < n; i++) {
+                if (buf[i] == 3 || buf[i] == 4) {  // Ctrl-C, Ctrl-D
+                    quit = true;
+                }
+                else if (isMoveKey(buf[i]) && keys.size() < kMaxQueuedKeys) {
+                    QueuedKey key = {buf[i], now};
+                    keys.push_back(key);
+                }
+            }
+        }
+
+        void drawFrame(const string& status) {
+            size_t rows = board.getNumRows();
+            size_t cols = board.getNumCols();
+            string frame;
+            frame.reserve((rows + 3) * (cols + 3) + status.size() + 8);
+
+            frame += "\x1b[H";
+            frame += string(cols + 2, '-');
+            frame += '\n';
+            size_t top = frame.size();
+            frame.resize(top + rows * (cols + 3), '|');
+            board.renderTo(&frame[top + 1], cols + 3);
+            for (size_t r = 0; r < rows; r++) {
+                frame[top + r * (cols + 3) + cols + 2] = '\n';
+            }
+            frame += string(cols + 2, '-');
+            frame += '\n';
+            frame += status;
+            frame += "\x1b[K\n";
+
+            size_t written = 0;
+            while (written < frame.size()) {
+                ssize_t n = write(STDOUT_FILENO, frame.data() + written, frame.size() - written);
+                if (n <= 0) {
+                    break;
+                }
+                written += n;
+            }
+            frames++;
+        }
+
+    public:
+        /* param constructor -> rates are in ticks and frames per second */
+        RealTimeGame(GameBoardBase& board, double tickRate, double frameRate)
+            : board(board), maxTicks(0), render(true), ticks(0), overruns(0), frames(0), quit(false), inputOpen(true) {
+            tickPeriod = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / tickRate));
+            framePeriod = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / frameRate));
+        }
+
+        // stops after n ticks even if the game is not over (used to benchmark)
+        void setMaxTicks(size_t n) {
+            maxTicks = n;
+        }
+
+        void setRender(bool r) {
+            render = r;
+        }
+
+        //---------------------------------------------------------------------------------
+        // bool run()
+        //
+        // Runs the game until it ends, the player quits, or maxTicks is reached.
+        // Returns true if the game ended on its own (hero escaped or died).
+        //---------------------------------------------------------------------------------
+        bool run() {
+            RawTerminal raw(STDIN_FILENO);
+            bool wasVerbose = board.getVerbose();
+            board.setVerbose(false);
+
+            bool gameOver = false;
+            bool dirty = true;
+            vector<Clock::time_point> unshownInputs;  // keys applied but not yet on screen
+
+            if (render) {
+                ssize_t ignored = write(STDOUT_FILENO, "\x1b[2J", 4);
+                (void)ignored;
+            }
+
+            Clock::time_point start = Clock::now();
+            Clock::time_point nextTick = start + tickPeriod;
+            Clock::time_point nextFrame = start;
+
+            while (!gameOver && !quit && (maxTicks == 0 || ticks < maxTicks)) {
+                Clock::time_point now = Clock::now();
+                Clock::time_point wakeAt = nextTick;
+                if (render && dirty && nextFrame < wakeAt) {
+                    wakeAt = nextFrame;
+                }
+
+                // wait for input, the next tick, or the next frame
+                if (wakeAt > now) {
+                    struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+                    long long waitNs = chrono::duration_cast<chrono::nanoseconds>(wakeAt - now).count();
+                    struct timespec timeout = {(time_t)(waitNs / 1000000000), (long)(waitNs % 1000000000)};
+                    if (ppoll(&pfd, inputOpen ? 1 : 0, &timeout, NULL) > 0) {
+                        readKeys();
+                        continue;
+                    }
+                    now = Clock::now();
+                }
+
+                if (now >= nextTick) {
+                    tickJitter.add(micros(now - nextTick));
+                    if (now - nextTick >= tickPeriod) {
+                        overruns++;
+                    }
+
+                    char move = 's';
+                    if (!keys.empty()) {
+                        move = keys.front().move;
+                        unshownInputs.push_back(keys.front().readAt);
+                        keys.pop_front();
+                    }
+
+                    Clock::time_point simStart = Clock::now();
+                    gameOver = !board.makeMoves(move);
+                    tickCost.add(micros(Clock::now() - simStart));
+
+                    ticks++;
+                    dirty = true;
+                    nextTick += tickPeriod;
+                    if (now - nextTick >= tickPeriod) {
+                        nextTick = now + tickPeriod;  // fell far behind, do not try to catch up
+                    }
+                }
+
+                if (render && dirty && Clock::now() >= nextFrame) {
+                    drawFrame("tick " + to_string(ticks) + "  (Ctrl-C to quit)");
+                    Clock::time_point shown = Clock::now();
+                    for (size_t i = 0; i < unshownInputs.size(); i++) {
+                        inputToFrame.add(micros(shown - unshownInputs[i]));
+                    }
+                    unshownInputs.clear();
+                    dirty = false;
+                    nextFrame = shown + framePeriod;
+                }
+            }
+
+            if (render && dirty) {
+                drawFrame("tick " + to_string(ticks));
+            }
+
+            board.setVerbose(wasVerbose);
+            return gameOver;
+        }
+
+        // Prints the measured timings.
+        void report(ostream& out) {
+            out << "ticks: " << ticks << ", frames: " << frames << ", overruns: " << overruns << endl;
+            out << "tick jitter (us)      p50 " << tickJitter.percentile(50) << "  p99 " << tickJitter.percentile(99)
+                << "  max " << tickJitter.maximum() << endl;
+            out << "simulation/tick (us)  p50 " << tickCost.percentile(50) << "  p99 " << tickCost.percentile(99)
+                << "  max " << tickCost.maximum() << endl;
+            if (inputToFrame.count() > 0) {
+                out << "input-to-frame (us)   p50 " << inputToFrame.percentile(50) << "  p99 " << inputToFrame.percentile(99)
+                    << "  max " << inputToFrame.maximum() << endl;
+            }
+        }
+
+    private:
+        RealTimeGame(const RealTimeGame&);
+        RealTimeGame& operator=(const RealTimeGame&);
+};
+
+#endif //_REALTIME_H
@@ -0,0 +1,119 @@
+#include <cstdlib>
+#include <csignal>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <memory>
+
+using namespace std;
+
+#include "gameserver.h"
+
+static GameServer* runningServer = NULL;
+
+void handleSignal(int) {
+    if (runningServer != NULL) {
+        runningServer->stop();
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    string socketPath = "/tmp/heroboard.sock";
+    size_t numWorkers = 0;
+    string levelPath;
+    string tracePath, markersPath;
+    string eventPath;
+    EventLevel eventLevel = LogOutcomes;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (arg == "--workers" && i + 1 < argc) {
+            numWorkers = atoi(argv[++i]);
+        }
+        else if (arg == "--levels" && i + 1 < argc) {
+            levelPath = argv[++i];
+        }
+        else if (arg == "--event-log" && i + 1 < argc) {
+            eventPath = argv[++i];
+        }
+        else if (arg == "--log-level" && i + 1 < argc && eventLevelOfName(argv[i + 1], eventLevel)) {
+            i++;
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            tracePath = argv[++i];
+        }
+        else if (arg == "--perf-markers" && i + 1 < argc) {
+            markersPath = argv[++i];
+        }
+        else {
+            cout << "usage: " << argv[0] << " [--socket path] [--workers n] [--levels library]" << endl;
+            cout << "       [--event-log events.bin [--log-level outcomes|all]]" << endl;
+            cout << "       [--trace chrome.json] [--perf-markers markers.txt]" << endl;
+            return 1;
+        }
+    }
+
+    try {
+        unique_ptr<LevelLibrary> levels;
+        if (!levelPath.empty()) {
+            levels.reset(new LevelLibrary(levelPath));
+            cout << "Loaded " << levels->size() << " levels from " << levelPath << endl;
+        }
+
+        // the game events of every session, as binary GameEvents (see eventlog.h)
+        ofstream eventFile;
+        unique_ptr<BinaryEventSink> eventSink;
+        unique_ptr<EventLog> events;
+        if (!eventPath.empty()) {
+            eventFile.open(eventPath.c_str(), ios::binary);
+            if (!eventFile) {
+                cout << "could not open " << eventPath << endl;
+                return 1;
+            }
+            eventSink.reset(new BinaryEventSink(eventFile));
+            events.reset(new EventLog(1 << 16, eventLevel));
+            events->start(eventSink.get());
+        }
+
+        GameServer server(socketPath, numWorkers);
+        server.setLevelLibrary(levels.get());
+        server.setEventLog(events.get());
+        runningServer = &server;
+        signal(SIGINT, handleSignal);
+        signal(SIGTERM, handleSignal);
+
+        // spans are written when the server stops
+        bool tracing = !tracePath.empty() || !markersPath.empty();
+        setTracing(tracing);
+
+        cout << "Serving games on " << socketPath << endl;
+        server.run();
+        runningServer = NULL;
+        cout << "Server stopped." << endl;
+
+        if (events) {
+            events->stop();
+            cout << "Game events written to " << eventPath << ", " << events->dropped() << " dropped." << endl;
+        }
+
+        if (tracing) {
+            setTracing(false);
+            if (!saveTrace(tracePath, markersPath)) {
+                cout << "could not write the trace" << endl;
+                return 1;
+            }
+            cout << "Trace written, " << traceDropped() << " spans dropped." << endl;
+        }
+    }
+    catch (exception& excpt) {
+        cout << excpt.what() << endl;
+        return 1;
+    }
+
+    return 0;
+
+} // main
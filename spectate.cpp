@@ -0,0 +1,167 @@
+/*
+    Filename: "spectate.cpp"
+    Author: Viraj Saudagar
+
+    Spectator client for the game server. WATCHes one session, rebuilds
+    the board from the keyframe and delta stream (see deltastream.h), and
+    redraws it after every frame. With --quiet it only counts frames and
+    bytes, which is handy for measuring what a spectator costs.
+
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+#include "deltastream.h"
+
+void draw(const DeltaDecoder& decoder, size_t session, size_t frameBytes) {
+    string frame = "\x1b[H";
+    frame += string(decoder.numCols() + 2, '-');
+    frame += '\n';
+    for (size_t r = 0; r < decoder.numRows(); r++) {
+        frame += '|';
+        for (size_t c = 0; c < decoder.numCols(); c++) {
+            frame += glyphOfTile(decoder.tile(r, c));
+        }
+        frame += "|\n";
+    }
+    frame += string(decoder.numCols() + 2, '-');
+    ostringstream status;
+    status << "\nsession " << session << "  turn " << decoder.getTurn() << "  last frame " << frameBytes << " bytes";
+    if (decoder.gameOver()) {
+        status << (decoder.wonGame() ? "  - hero escaped" : "  - hero did not escape");
+    }
+    frame += status.str();
+    frame += "\x1b[K\n";
+    cout << frame << flush;
+}
+
+int main(int argc, char* argv[]) {
+
+    string socketPath = "/tmp/heroboard.sock";
+    size_t session = 0;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (arg == "--session" && i + 1 < argc) {
+            session = atoi(argv[++i]);
+        }
+        else if (arg == "--quiet") {
+            quiet = true;
+        }
+        else {
+            cout << "usage: " << argv[0] << " --session id [--socket path] [--quiet]" << endl;
+            return 1;
+        }
+    }
+    if (session == 0) {
+        cout << "usage: " << argv[0] << " --session id [--socket path] [--quiet]" << endl;
+        return 1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        cout << "could not connect to " << socketPath << endl;
+        return 1;
+    }
+    ostringstream watch;
+    watch << "WATCH " << session << '\n';
+    string request = watch.str();
+    if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) < 0) {
+        cout << "could not send to " << socketPath << endl;
+        return 1;
+    }
+    if (!quiet) {
+        cout << "\x1b[2J" << flush;
+    }
+
+    DeltaDecoder decoder;
+    string inbuf;
+    bool frameNext = false;  // a STREAM line was read, a binary frame follows
+    size_t frames = 0, frameBytes = 0, keyframeBytes = 0, keyframes = 0;
+    bool ended = false;
+
+    try {
+        while (!ended) {
+            char buf[65536];
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                break;
+            }
+            inbuf.append(buf, n);
+
+            size_t at = 0;
+            while (at < inbuf.size()) {
+                if (frameNext) {
+                    size_t used = decoder.apply((const unsigned char*)inbuf.data() + at, inbuf.size() - at);
+                    if (used == 0) {
+                        break;
+                    }
+                    frameNext = false;
+                    frames++;
+                    frameBytes += used;
+                    if (decoder.lastWasKeyframe()) {
+                        keyframes++;
+                        keyframeBytes += used;
+                    }
+                    at += used;
+                    if (!quiet) {
+                        draw(decoder, session, used);
+                    }
+                    continue;
+                }
+
+                size_t end = inbuf.find('\n', at);
+                if (end == string::npos) {
+                    break;
+                }
+                istringstream line(inbuf.substr(at, end - at));
+                at = end + 1;
+                string verb;
+                size_t id = 0;
+                line >> verb >> id;
+                if (verb == "STREAM" && id == session) {
+                    frameNext = true;
+                }
+                else if (verb == "ENDED" && id == session) {
+                    ended = true;
+                }
+                else if (verb == "ERR") {
+                    cout << line.str() << endl;
+                    return 1;
+                }
+            }
+            inbuf.erase(0, at);
+        }
+    }
+    catch (exception& excpt) {
+        cout << excpt.what() << endl;
+        return 1;
+    }
+    close(fd);
+
+    cout << frames << " frames (" << keyframes << " keyframes), " << frameBytes << " bytes";
+    if (frames > keyframes) {
+        cout << ", " << (double)(frameBytes - keyframeBytes) / (frames - keyframes) << " bytes per delta";
+    }
+    cout << endl;
+    return 0;
+
+} // main
@@ -0,0 +1,291 @@
+/*
+    Filename: "sweep.cpp"
+    Author: Viraj Saudagar
+
+    Difficulty calibration. Plays a hero policy (see heropolicy.h) over
+    every combination of the given board parameters and reports, for each
+    combination: win rate, mean turns to escape, and how the hero died
+    (abyss, monster, bat, or still alive at --max-turns), each with a 95%
+    confidence interval.
+
+    Every parameter takes a list of values and ranges, e.g.
+        --monsters 0,3,6  --abysses 10:50:10  --rows 15
+    Game g of every combination uses seed start-seed + g, so combinations
+    are compared on the same seeds.
+
+    Games of one combination are split across all cores. Each thread keeps
+    streaming statistics (counts and Welford means) that are merged at the
+    end, so memory does not grow with the number of games.
+
+    --heatmaps prefix also collects per-cell Heatmaps (see heatmap.h) for
+    every combination: where the hero went, where it died of what, and
+    where monsters moved. They are written as PGM and CSV files named
+    prefix_<rows>x<cols>_a<abysses>_m<monsters>_b<bats>_<layer>.
+
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+using namespace std;
+
+#include "gameboard.h"
+#include "heropolicy.h"
+#include "gamestats.h"
+#include "workerpool.h"
+#include "heatmap.h"
+
+struct SweepPoint {
+    int rows, cols, abysses, monsters, bats;
+};
+
+struct PointResults {
+    size_t games;
+    size_t outcomes[NumGameOutcomes];  // OutcomePlaying counts games cut off at --max-turns
+    RunningStats escapeTurns;          // turns played in games the hero won
+
+    PointResults() : games(0) {
+        for (int i = 0; i < NumGameOutcomes; i++) {
+            outcomes[i] = 0;
+        }
+    }
+
+    void merge(const PointResults& other) {
+        games += other.games;
+        for (int i = 0; i < NumGameOutcomes; i++) {
+            outcomes[i] += other.outcomes[i];
+        }
+        escapeTurns.merge(other.escapeTurns);
+    }
+};
+
+// everything one run of the ThreadTeam needs
+struct SweepJob {
+    SweepPoint point;
+    string policy;
+    int startSeed;
+    size_t maxTurns;
+    bool collectHeatmaps;
+    mutex lock;
+    PointResults results;
+    unique_ptr<Heatmaps> heatmaps;  // every thread's heatmaps merged, if collectHeatmaps
+};
+
+void playGames(void* context, size_t begin, size_t end) {
+    SweepJob& job = *(SweepJob*)context;
+    unique_ptr<GameBoardBase> board(makeGameBoard(job.point.rows, job.point.cols));
+    unique_ptr<HeroPolicy> policy(makeHeroPolicy(job.policy));
+    BoardView view(*board);
+    unique_ptr<Heatmaps> heat;
+    if (job.collectHeatmaps) {
+        heat.reset(new Heatmaps(job.point.rows, job.point.cols));
+    }
+    board->setVerbose(false);
+    board->setNumAbysses(job.point.abysses);
+    board->setNumMonsters(job.point.monsters);
+    board->setNumBats(job.point.bats);
+
+    PointResults local;
+    for (size_t g = begin; g < end; g++) {
+        int seed = job.startSeed + (int)g;
+        board->setupBoard(seed);
+        policy->startGame(view, seed);
+        if (heat) {
+            heat->startGame(*board);
+        }
+
+        size_t turns = 0;
+        bool alive = true;
+        while (alive && turns < job.maxTurns) {
+            alive = board->makeMoves(policy->nextMove(view));
+            turns++;
+            if (heat) {
+                heat->afterTurn(*board);
+            }
+        }
+        if (heat) {
+            heat->endGame(*board);
+        }
+
+        GameOutcome outcome = board->getOutcome();
+        local.games++;
+        local.outcomes[outcome]++;
+        if (outcome == OutcomeEscaped) {
+            local.escapeTurns.add(turns);
+        }
+    }
+
+    lock_guard<mutex> guard(job.lock);
+    job.results.merge(local);
+    if (heat) {
+        job.heatmaps->merge(*heat);
+    }
+}
+
+// parses "a,b,c" where each item is a value or first:last[:step]
+bool parseValues(const string& text, vector<int>& values) {
+    values.clear();
+    stringstream items(text);
+    string item;
+    while (getline(items, item, ',')) {
+        int first, last, step = 1;
+        int n = sscanf(item.c_str(), "%d:%d:%d", &first, &last, &step);
+        if (n == 1) {
+            values.push_back(first);
+        }
+        else if (n >= 2 && step > 0 && first <= last) {
+            for (int v = first; v <= last; v += step) {
+                values.push_back(v);
+            }
+        }
+        else {
+            return false;
+        }
+    }
+    return !values.empty();
+}
+
+string percentWithInterval(size_t hits, size_t n) {
+    double low, high;
+    wilsonInterval(hits, n, low, high);
+    char text[64];
+    snprintf(text, sizeof(text), "%5.1f%% [%4.1f,%5.1f]", n ? 100.0 * hits / n : 0.0, 100 * low, 100 * high);
+    return text;
+}
+
+int main(int argc, char* argv[]) {
+
+    vector<int> rows(1, 15), cols(1, 40), abysses(1, 20), monsters(1, 6), bats(1, 3);
+    size_t numGames = 2000;
+    size_t maxTurns = 500;
+    int startSeed = 1;
+    size_t numThreads = 0;
+    string policyName = "planner";
+    bool csv = false;
+    string heatmapPrefix;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        bool ok = true;
+        if (arg == "--rows" && hasValue)               ok = parseValues(argv[++i], rows);
+        else if (arg == "--cols" && hasValue)          ok = parseValues(argv[++i], cols);
+        else if (arg == "--abysses" && hasValue)       ok = parseValues(argv[++i], abysses);
+        else if (arg == "--monsters" && hasValue)      ok = parseValues(argv[++i], monsters);
+        else if (arg == "--bats" && hasValue)          ok = parseValues(argv[++i], bats);
+        else if (arg == "--games" && hasValue)         numGames = max(1, atoi(argv[++i]));
+        else if (arg == "--max-turns" && hasValue)     maxTurns = max(1, atoi(argv[++i]));
+        else if (arg == "--start-seed" && hasValue)    startSeed = atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)       numThreads = atoi(argv[++i]);
+        else if (arg == "--policy" && hasValue)        policyName = argv[++i];
+        else if (arg == "--csv")                       csv = true;
+        else if (arg == "--heatmaps" && hasValue)      heatmapPrefix = argv[++i];
+        else                                           ok = false;
+        if (!ok) {
+            cout << "usage: " << argv[0] << " [--rows list] [--cols list] [--abysses list] [--monsters list] [--bats list]" << endl;
+            cout << "       [--games n] [--max-turns n] [--start-seed n] [--threads n]" << endl;
+            cout << "       [--policy random|greedy|planner|safe|search] [--csv] [--heatmaps prefix]" << endl;
+            cout << "a list is values and first:last[:step] ranges separated by commas" << endl;
+            return 1;
+        }
+    }
+    unique_ptr<HeroPolicy> check(makeHeroPolicy(policyName));
+    if (!check) {
+        cout << "unknown policy " << policyName << endl;
+        return 1;
+    }
+
+    ThreadTeam team(numThreads);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t totalGames = 0;
+
+    if (csv) {
+        cout << "rows,cols,abysses,monsters,super_monsters,bats,games,win_rate,win_low,win_high,"
+             << "escape_turns,escape_turns_ci,abyss_rate,monster_rate,bat_rate,timeout_rate" << endl;
+    }
+    else {
+        cout << "policy " << policyName << ", " << numGames << " games per point, seeds " << startSeed
+             << ".." << startSeed + (int)numGames - 1 << ", " << team.size() << " threads" << endl;
+        printf("%-18s %-22s %-14s %-22s %-22s %-22s %-22s\n", "rows cols a m(M) b", "win rate [95% CI]",
+               "escape turns", "abyss", "monster", "bat", "timeout");
+    }
+
+    for (size_t ri = 0; ri < rows.size(); ri++)
+    for (size_t ci = 0; ci < cols.size(); ci++)
+    for (size_t ai = 0; ai < abysses.size(); ai++)
+    for (size_t mi = 0; mi < monsters.size(); mi++)
+    for (size_t bi = 0; bi < bats.size(); bi++) {
+        SweepJob job;
+        job.point.rows = rows[ri];
+        job.point.cols = cols[ci];
+        job.point.abysses = abysses[ai];
+        job.point.monsters = monsters[mi];
+        job.point.bats = bats[bi];
+        job.policy = policyName;
+        job.startSeed = startSeed;
+        job.maxTurns = maxTurns;
+        job.collectHeatmaps = !heatmapPrefix.empty();
+
+        const SweepPoint& p = job.point;
+        if (!validGameParameters(p.rows, p.cols, p.abysses, p.monsters, p.bats)) {
+            if (!csv) {
+                printf("%d %d %d %d %d: skipped, parameters out of range\n", p.rows, p.cols, p.abysses, p.monsters, p.bats);
+            }
+            continue;
+        }
+
+        if (job.collectHeatmaps) {
+            job.heatmaps.reset(new Heatmaps(p.rows, p.cols));
+        }
+        team.run(numGames, &playGames, &job);
+        totalGames += numGames;
+        if (job.collectHeatmaps) {
+            char name[96];
+            snprintf(name, sizeof(name), "_%dx%d_a%d_m%d_b%d", p.rows, p.cols, p.abysses, p.monsters, p.bats);
+            if (!job.heatmaps->save(heatmapPrefix + name)) {
+                cout << "could not write the heatmaps " << heatmapPrefix + name << "_*" << endl;
+                return 1;
+            }
+        }
+
+        const PointResults& res = job.results;
+        size_t n = res.games;
+        size_t wins = res.outcomes[OutcomeEscaped];
+        int superMonsters = p.monsters / 3;  // the split setNumMonsters() makes
+        if (csv) {
+            double low, high;
+            wilsonInterval(wins, n, low, high);
+            printf("%d,%d,%d,%d,%d,%d,%zu,%.4f,%.4f,%.4f,%.2f,%.2f,%.4f,%.4f,%.4f,%.4f\n",
+                   p.rows, p.cols, p.abysses, p.monsters - superMonsters, superMonsters, p.bats, n,
+                   (double)wins / n, low, high, res.escapeTurns.mean(), res.escapeTurns.meanHalfWidth(),
+                   (double)res.outcomes[OutcomeAbyss] / n, (double)res.outcomes[OutcomeMonster] / n,
+                   (double)res.outcomes[OutcomeBat] / n, (double)res.outcomes[OutcomePlaying] / n);
+        }
+        else {
+            char point[32], turns[32];
+            snprintf(point, sizeof(point), "%d %d %d %d(%d) %d", p.rows, p.cols, p.abysses, p.monsters, superMonsters, p.bats);
+            snprintf(turns, sizeof(turns), "%.1f +- %.1f", res.escapeTurns.mean(), res.escapeTurns.meanHalfWidth());
+            printf("%-18s %-22s %-14s %-22s %-22s %-22s %-22s\n", point, percentWithInterval(wins, n).c_str(),
+                   wins ? turns : "-", percentWithInterval(res.outcomes[OutcomeAbyss], n).c_str(),
+                   percentWithInterval(res.outcomes[OutcomeMonster], n).c_str(),
+                   percentWithInterval(res.outcomes[OutcomeBat], n).c_str(),
+                   percentWithInterval(res.outcomes[OutcomePlaying], n).c_str());
+        }
+        fflush(stdout);
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!csv) {
+        cout << totalGames << " games in " << seconds << " s (" << (long long)(totalGames / seconds) << " games/s)" << endl;
+    }
+
+    return 0;
+
+} // main
@@ -0,0 +1,102 @@
+/*
+    Filename: "terrain.h"
+    Author: Viraj Saudagar
+
+    This file defines Terrain, the part of a level that every game played
+    on it has in common: the walls, the ladder and the abysses, where the
+    hero and the baddies start, and the move tables (see movetables.h)
+    resolved for that terrain.
+
+    A Terrain never changes once it is built and is handed around as a
+    SharedTerrain (shared_ptr<const Terrain>), so any number of boards on
+    any number of threads can be set up from one and keep using its move
+    tables. What a board still keeps for itself is its grid of cell
+    pointers, its occupancy map and its hero and baddies: empty and
+    terrain cells are the shared cells from sharedCellForTile().
+
+*/
+
+#ifndef _TERRAIN_H
+#define _TERRAIN_H
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include "tiles.h"
+#include "movetables.h"
+
+using namespace std;
+
+class Terrain {
+    private:
+        size_t rows, cols;
+        vector<unsigned char> tiles;          // walls, ladder and abysses; TileEmpty everywhere else
+        vector<size_t> entityCells;           // r * cols + c of the hero and every baddie, row after row
+        vector<unsigned char> entityTiles;    // their tiles
+        MoveTables moves;                     // fully resolved for tiles
+
+    public:
+        /* param constructor -> splits a full layout (rows x cols TileType codes, row after row) */
+        Terrain(size_t numRows, size_t numCols, const unsigned char* layout)
+            : rows(numRows), cols(numCols), tiles(numRows * numCols, TileEmpty) {
+            if (rows == 0 || cols == 0) {
+                throw invalid_argument("Terrain constructor -> the layout has no cells");
+            }
+            for (size_t i = 0; i < rows * cols; i++) {
+                unsigned char tile = layout[i];
+                if (isTerrainTile(tile)) {
+                    tiles[i] = tile;
+                }
+                else if (tile != TileEmpty && tile < NumTileTypes) {
+                    entityCells.push_back(i);
+                    entityTiles.push_back(tile);
+                }
+            }
+            moves.resize(rows, cols, &tiles[0]);
+            moves.resolveAll();
+        }
+
+        size_t numRows() const {
+            return rows;
+        }
+
+        size_t numCols() const {
+            return cols;
+        }
+
+        unsigned char tile(size_t r, size_t c) const {
+            return tiles[r * cols + c];
+        }
+
+        // the hero and the baddies where the game starts
+        size_t numEntities() const {
+            return entityCells.size();
+        }
+
+        size_t entityCell(size_t i) const {
+            return entityCells[i];
+        }
+
+        unsigned char entityTile(size_t i) const {
+            return entityTiles[i];
+        }
+
+        const MoveTables& moveTables() const {
+            return moves;
+        }
+
+    private:
+        Terrain(const Terrain&);
+        Terrain& operator=(const Terrain&);
+};
+
+typedef shared_ptr<const Terrain> SharedTerrain;
+
+// builds a Terrain from a full layout, e.g. what GameBoardBase::getTiles() wrote
+inline SharedTerrain makeTerrain(size_t rows, size_t cols, const unsigned char* layout) {
+    return SharedTerrain(new Terrain(rows, cols, layout));
+}
+
+#endif //_TERRAIN_H
@@ -0,0 +1,118 @@
+/*
+    Filename: "threatmap.h"
+    Author: Viraj Saudagar
+
+    This file defines ThreatMap, the cells where the hero would be caught
+    if it stood there once the baddies have moved: every cell a monster or
+    super monster would land on moving towards a hero there (after the
+    edges, walls and ladder have deflected it, and unless it falls into an
+    abyss on the way), every cell holding a monster, and every cell of a
+    row with a bat in it, since a bat flies to the hero's column wherever
+    that is.
+
+    The board keeps the map up to date as tiles are put (see
+    GameBoardBase::setTrackThreats()): a monster that moves takes back
+    what it threatened from its old cell and adds what it threatens from
+    its new one, a handful of move table lookups, and a wall or abyss that
+    changes redoes only the monsters within two cells of it. Asking whether
+    a cell is threatened is one bit test.
+
+    Each cell counts the monsters threatening it and each row the bats in
+    it, so threats can be taken back one baddie at a time. The union is
+    also kept as a bitset, one 64-bit word per 64 columns, which renderers
+    and hero policies read directly.
+
+    Collisions between baddies are not taken into account: a monster that
+    would be blocked by another baddie still threatens where it would have
+    landed, so the map errs on the safe side.
+
+*/
+
+#ifndef _THREATMAP_H
+#define _THREATMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// display character of a threatened empty cell in a hint overlay
+static const char kThreatGlyph = '!';
+
+class ThreatMap {
+    private:
+        size_t rows, cols;
+        size_t wordsPerRow;
+        vector<unsigned char> monsters;   // monsters threatening each cell, row after row
+        vector<unsigned> bats;            // bats in each row
+        vector<uint64_t> bits;            // threatened cells, each row starting on a new word
+
+        void setBit(size_t r, size_t c, bool on) {
+            uint64_t& word = bits[r * wordsPerRow + c / 64];
+            uint64_t mask = (uint64_t)1 << (c % 64);
+            word = on ? (word | mask) : (word & ~mask);
+        }
+
+    public:
+        ThreatMap() : rows(0), cols(0), wordsPerRow(0) {}
+
+        // sizes the map for a rows x cols board with nothing threatened
+        void reset(size_t numRows, size_t numCols) {
+            rows = numRows;
+            cols = numCols;
+            wordsPerRow = (cols + 63) / 64;
+            monsters.assign(rows * cols, 0);
+            bats.assign(rows, 0);
+            bits.assign(rows * wordsPerRow, 0);
+        }
+
+        // one more (add) or one less monster threatens (r, c)
+        void markMonster(size_t r, size_t c, bool add) {
+            unsigned char& n = monsters[r * cols + c];
+            n = add ? n + 1 : n - 1;
+            if (bats[r] == 0 && n == (add ? 1 : 0)) {
+                setBit(r, c, add);
+            }
+        }
+
+        // one more (add) or one less bat is in row r
+        void markBat(size_t r, bool add) {
+            bats[r] = add ? bats[r] + 1 : bats[r] - 1;
+            if (bats[r] != (add ? 1u : 0u)) {
+                return;
+            }
+            for (size_t c = 0; c < cols; c++) {
+                setBit(r, c, add || monsters[r * cols + c] > 0);
+            }
+        }
+
+        size_t numRows() const {
+            return rows;
+        }
+
+        size_t numCols() const {
+            return cols;
+        }
+
+        bool threatened(size_t r, size_t c) const {
+            return (bits[r * wordsPerRow + c / 64] >> (c % 64)) & 1;
+        }
+
+        // the words of row r; bit c % 64 of word c / 64 is column c
+        const uint64_t* rowBits(size_t r) const {
+            return &bits[r * wordsPerRow];
+        }
+
+        // number of threatened cells
+        size_t count() const {
+            size_t n = 0;
+            for (size_t i = 0; i < bits.size(); i++) {
+                n += __builtin_popcountll(bits[i]);
+            }
+            return n;
+        }
+};
+
+#endif //_THREATMAP_H
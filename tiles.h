@@ -0,0 +1,106 @@
+/*
+    Filename: "tiles.h"
+    Author: Viraj Saudagar
+
+    This file defines TileType, a small integer code for each kind of
+    BoardCell. Tiles are what gets stored or sent when a board has to be
+    written down compactly (level libraries, frame streams, observations);
+    every code fits in 4 bits so two tiles pack into one byte.
+
+*/
+
+#ifndef _TILES_H
+#define _TILES_H
+
+#include <cstddef>
+
+#include "boardcell.h"
+
+enum TileType {
+    TileEmpty = 0,          // ' '  Nothing
+    TileHero = 1,           // 'H'  Hero
+    TileLadder = 2,         // '*'  EscapeLadder
+    TileWall = 3,           // '+'  Wall
+    TileAbyss = 4,          // '#'  Abyss
+    TileMonster = 5,        // 'm'  Monster with power 1
+    TileSuperMonster = 6,   // 'M'  Monster with power 2
+    TileBat = 7,            // '~'  Bat
+    NumTileTypes = 8
+};
+
+// display character of each tile, indexed by TileType
+static const char kTileGlyphs[NumTileTypes + 1] = " H*+#mM~";
+
+inline char glyphOfTile(int tile) {
+    return (tile >= 0 && tile < NumTileTypes) ? kTileGlyphs[tile] : '?';
+}
+
+inline TileType tileOfGlyph(char glyph) {
+    switch (glyph) {
+        case 'H': return TileHero;
+        case '*': return TileLadder;
+        case '+': return TileWall;
+        case '#': return TileAbyss;
+        case 'm': return TileMonster;
+        case 'M': return TileSuperMonster;
+        case '~': return TileBat;
+        default:  return TileEmpty;
+    }
+}
+
+// walls, the ladder and abysses: the tiles that decide where a move can go
+inline bool isTerrainTile(int tile) {
+    return tile == TileWall || tile == TileLadder || tile == TileAbyss;
+}
+
+// tiles whose cells never move or change: Nothing, Wall, EscapeLadder, Abyss
+inline bool isStaticTile(int tile) {
+    return tile == TileEmpty || tile == TileLadder || tile == TileWall || tile == TileAbyss;
+}
+
+// One shared cell for each static tile. Boards only ever ask these cells for their
+// display, so every board points at them instead of allocating a cell per square;
+// the position they were built with means nothing. Any other tile gives NULL.
+inline BoardCell* sharedCellForTile(int tile) {
+    static Nothing nothing(0, 0);
+    static EscapeLadder ladder(0, 0);
+    static Wall wall(0, 0);
+    static Abyss abyss(0, 0);
+    switch (tile) {
+        case TileEmpty:  return &nothing;
+        case TileLadder: return &ladder;
+        case TileWall:   return &wall;
+        case TileAbyss:  return &abyss;
+        default:         return NULL;
+    }
+}
+
+// creates the BoardCell for a tile at (r, c); TileEmpty gives a Nothing cell
+inline BoardCell* newCellForTile(int tile, size_t r, size_t c) {
+    switch (tile) {
+        case TileHero:
+            return new Hero(r, c);
+        case TileLadder:
+            return new EscapeLadder(r, c);
+        case TileWall:
+            return new Wall(r, c);
+        case TileAbyss:
+            return new Abyss(r, c);
+        case TileMonster: {
+            BoardCell* monster = new Monster(r, c);
+            monster->setPower(1);
+            return monster;
+        }
+        case TileSuperMonster: {
+            BoardCell* monster = new Monster(r, c);
+            monster->setPower(2);
+            return monster;
+        }
+        case TileBat:
+            return new Bat(r, c);
+        default:
+            return new Nothing(r, c);
+    }
+}
+
+#endif //_TILES_H
@@ -0,0 +1,126 @@
+/*
+    Filename: "timingwheel.h"
+    Author: Viraj Saudagar
+
+    This file defines TimingWheel, a hierarchical timing wheel: items are
+    scheduled for a beat in the future and handed back on that beat, at a
+    cost that does not depend on how many other items are waiting or how
+    far ahead they are due.
+
+    The wheel has kWheelLevels levels of kWheelSlots slots. Level 0 holds
+    the items due within the next kWheelSlots beats, one slot per beat;
+    every level above covers kWheelSlots times the span of the one below,
+    one slot per span. Advancing a beat empties one slot of level 0, and
+    whenever a level's slots have all gone by the next slot of the level
+    above is emptied down, so every item is moved at most once per level
+    on its way to being due. Items due further ahead than the top level
+    reaches wait in an overflow list that is looked at once per turn of
+    the top level.
+
+    Items due on the same beat come back in no particular order.
+
+*/
+
+#ifndef _TIMINGWHEEL_H
+#define _TIMINGWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+static const unsigned kWheelSlotBits = 6;
+static const size_t kWheelSlots = (size_t)1 << kWheelSlotBits;   // 64 slots a level
+static const unsigned kWheelLevels = 4;                           // reaches 64^4 = 16.7M beats ahead
+
+template<typename T>
+class TimingWheel {
+    private:
+        struct Pending {
+            T item;
+            uint64_t due;
+        };
+
+        uint64_t now;                                   // the beat handed out last
+        vector<Pending> slots[kWheelLevels][kWheelSlots];
+        vector<Pending> overflow;                       // due beyond what the top level reaches
+        vector<Pending> moving;                         // reused while a slot is emptied down
+        size_t count;
+
+        // the level a beat belongs on: the highest slot-sized group of bits in which it
+        // differs from now (0 if it is now)
+        void place(const Pending& p) {
+            uint64_t differ = p.due ^ now;
+            unsigned level = (differ == 0) ? 0 : (63 - __builtin_clzll(differ)) / kWheelSlotBits;
+            if (level >= kWheelLevels) {
+                overflow.push_back(p);
+                return;
+            }
+            slots[level][(p.due >> (level * kWheelSlotBits)) & (kWheelSlots - 1)].push_back(p);
+        }
+
+        // places the items of list again, now that now has moved on
+        void redistribute(vector<Pending>& list) {
+            moving.swap(list);
+            for (size_t k = 0; k < moving.size(); k++) {
+                place(moving[k]);
+            }
+            moving.clear();
+        }
+
+    public:
+        TimingWheel() : now(0), count(0) {}
+
+        // drops everything and starts over at beat start
+        void reset(uint64_t start) {
+            for (unsigned level = 0; level < kWheelLevels; level++) {
+                for (size_t s = 0; s < kWheelSlots; s++) {
+                    slots[level][s].clear();
+                }
+            }
+            overflow.clear();
+            now = start;
+            count = 0;
+        }
+
+        // the beat advance() handed out last
+        uint64_t getNow() const {
+            return now;
+        }
+
+        // items waiting
+        size_t size() const {
+            return count;
+        }
+
+        // hands item back on beat due; a beat that is not after now counts as the next one
+        void schedule(const T& item, uint64_t due) {
+            Pending p;
+            p.item = item;
+            p.due = (due > now) ? due : now + 1;
+            place(p);
+            count++;
+        }
+
+        // moves on to the next beat and appends the items due on it to due
+        void advance(vector<T>& due) {
+            now++;
+            if ((now & ((((uint64_t)1) << (kWheelLevels * kWheelSlotBits)) - 1)) == 0) {
+                redistribute(overflow);
+            }
+            for (unsigned level = kWheelLevels - 1; level > 0; level--) {
+                if ((now & ((((uint64_t)1) << (level * kWheelSlotBits)) - 1)) == 0) {
+                    redistribute(slots[level][(now >> (level * kWheelSlotBits)) & (kWheelSlots - 1)]);
+                }
+            }
+            vector<Pending>& slot = slots[0][now & (kWheelSlots - 1)];
+            for (size_t k = 0; k < slot.size(); k++) {
+                due.push_back(slot[k].item);
+            }
+            count -= slot.size();
+            slot.clear();
+        }
+};
+
+#endif //_TIMINGWHEEL_H
@@ -0,0 +1,313 @@
+/*
+    Filename: "tournament.cpp"
+    Author: Viraj Saudagar
+
+    Hero policy tournament. Every policy (see heropolicy.h) plays game g on
+    the layout setupBoard(start-seed + g) makes, so all of them face exactly
+    the same boards and can be compared game by game. Reported:
+
+      - per policy: win rate, how the hero died, mean turns to escape, and
+        how long one nextMove() takes (mean, p50, p99 and max; with
+        --threat-map the boards keep a ThreatMap the policies read
+        instead of looking around every cell they weigh). A policy
+        whose p99 is within --hint-budget-us is fast enough to suggest
+        moves to a player in real time.
+      - per pair of policies: the difference in win rate with a 95%
+        confidence interval over the paired games, McNemar's p-value for
+        it, and the mean difference in turns to escape over the games both
+        of them won.
+
+    Games are split across all cores; each thread has its own board and
+    one instance of every policy, and keeps streaming statistics that are
+    merged at the end.
+
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+using namespace std;
+
+#include "gameboard.h"
+#include "heropolicy.h"
+#include "gamestats.h"
+#include "workerpool.h"
+
+struct PolicyResults {
+    size_t games;
+    size_t outcomes[NumGameOutcomes];  // OutcomePlaying counts games cut off at --max-turns
+    RunningStats escapeTurns;          // turns played in games the hero won
+    RunningStats decisionMicros;       // time of every nextMove() call
+    LogHistogram decisionHistogram;
+
+    PolicyResults() : games(0) {
+        for (int i = 0; i < NumGameOutcomes; i++) {
+            outcomes[i] = 0;
+        }
+    }
+
+    void merge(const PolicyResults& other) {
+        games += other.games;
+        for (int i = 0; i < NumGameOutcomes; i++) {
+            outcomes[i] += other.outcomes[i];
+        }
+        escapeTurns.merge(other.escapeTurns);
+        decisionMicros.merge(other.decisionMicros);
+        decisionHistogram.merge(other.decisionHistogram);
+    }
+};
+
+// policy a against policy b over the same games
+struct PairResults {
+    size_t onlyFirst, onlySecond;  // games only a won, games only b won
+    RunningStats winDifference;    // 1, 0 or -1 per game: a won minus b won
+    RunningStats turnDifference;   // a's turns minus b's, in games both won
+
+    PairResults() : onlyFirst(0), onlySecond(0) {}
+
+    void merge(const PairResults& other) {
+        onlyFirst += other.onlyFirst;
+        onlySecond += other.onlySecond;
+        winDifference.merge(other.winDifference);
+        turnDifference.merge(other.turnDifference);
+    }
+};
+
+// everything one run of the ThreadTeam needs
+struct TournamentJob {
+    vector<string> policies;
+    int rows, cols, abysses, monsters, bats;
+    CollisionPolicy collisions;
+    int startSeed;
+    size_t maxTurns;
+    bool threatMap;
+    mutex lock;
+    vector<PolicyResults> results;  // one per policy
+    vector<PairResults> pairs;      // a * policies + b for a < b
+};
+
+void playGames(void* context, size_t begin, size_t end) {
+    TournamentJob& job = *(TournamentJob*)context;
+    size_t numPolicies = job.policies.size();
+    unique_ptr<GameBoardBase> board(makeGameBoard(job.rows, job.cols));
+    board->setVerbose(false);
+    board->setCollisionPolicy(job.collisions);
+    board->setNumAbysses(job.abysses);
+    board->setNumMonsters(job.monsters);
+    board->setNumBats(job.bats);
+    board->setTrackThreats(job.threatMap);
+    BoardView view(*board);
+
+    vector< unique_ptr<HeroPolicy> > policies;
+    for (size_t p = 0; p < numPolicies; p++) {
+        policies.push_back(unique_ptr<HeroPolicy>(makeHeroPolicy(job.policies[p])));
+    }
+
+    vector<PolicyResults> local(numPolicies);
+    vector<PairResults> localPairs(numPolicies * numPolicies);
+    vector<bool> won(numPolicies);
+    vector<size_t> turnsPlayed(numPolicies);
+    for (size_t g = begin; g < end; g++) {
+        int seed = job.startSeed + (int)g;
+        for (size_t p = 0; p < numPolicies; p++) {
+            board->setupBoard(seed);
+            policies[p]->startGame(view, seed);
+
+            size_t turns = 0;
+            bool alive = true;
+            while (alive && turns < job.maxTurns) {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                char move = policies[p]->nextMove(view);
+                double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+                local[p].decisionMicros.add(micros);
+                local[p].decisionHistogram.add(micros);
+                alive = board->makeMoves(move);
+                turns++;
+            }
+
+            GameOutcome outcome = board->getOutcome();
+            local[p].games++;
+            local[p].outcomes[outcome]++;
+            won[p] = (outcome == OutcomeEscaped);
+            turnsPlayed[p] = turns;
+            if (won[p]) {
+                local[p].escapeTurns.add(turns);
+            }
+        }
+
+        for (size_t a = 0; a < numPolicies; a++) {
+            for (size_t b = a + 1; b < numPolicies; b++) {
+                PairResults& pair = localPairs[a * numPolicies + b];
+                pair.onlyFirst += (won[a] && !won[b]);
+                pair.onlySecond += (won[b] && !won[a]);
+                pair.winDifference.add((int)won[a] - (int)won[b]);
+                if (won[a] && won[b]) {
+                    pair.turnDifference.add((double)turnsPlayed[a] - (double)turnsPlayed[b]);
+                }
+            }
+        }
+    }
+
+    lock_guard<mutex> guard(job.lock);
+    for (size_t p = 0; p < numPolicies; p++) {
+        job.results[p].merge(local[p]);
+    }
+    for (size_t i = 0; i < localPairs.size(); i++) {
+        job.pairs[i].merge(localPairs[i]);
+    }
+}
+
+// splits "a,b,c" into names
+vector<string> splitNames(const string& text) {
+    vector<string> names;
+    stringstream items(text);
+    string item;
+    while (getline(items, item, ',')) {
+        names.push_back(item);
+    }
+    return names;
+}
+
+string percentWithInterval(size_t hits, size_t n) {
+    double low, high;
+    wilsonInterval(hits, n, low, high);
+    char text[64];
+    snprintf(text, sizeof(text), "%5.1f%% [%4.1f,%5.1f]", n ? 100.0 * hits / n : 0.0, 100 * low, 100 * high);
+    return text;
+}
+
+int main(int argc, char* argv[]) {
+
+    TournamentJob job;
+    job.policies.assign(kHeroPolicyNames, kHeroPolicyNames + kNumHeroPolicies);
+    job.rows = 15;
+    job.cols = 40;
+    job.abysses = 20;
+    job.monsters = 6;
+    job.bats = 3;
+    job.collisions = CollisionBlock;
+    job.startSeed = 1;
+    job.maxTurns = 500;
+    job.threatMap = false;
+    size_t numGames = 1000;
+    size_t numThreads = 0;
+    double hintBudget = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        bool ok = true;
+        if (arg == "--policies" && hasValue)            job.policies = splitNames(argv[++i]);
+        else if (arg == "--rows" && hasValue)           job.rows = atoi(argv[++i]);
+        else if (arg == "--cols" && hasValue)           job.cols = atoi(argv[++i]);
+        else if (arg == "--abysses" && hasValue)        job.abysses = atoi(argv[++i]);
+        else if (arg == "--monsters" && hasValue)       job.monsters = atoi(argv[++i]);
+        else if (arg == "--bats" && hasValue)           job.bats = atoi(argv[++i]);
+        else if (arg == "--collisions" && hasValue)     ok = collisionPolicyOfName(argv[++i], job.collisions);
+        else if (arg == "--games" && hasValue)          numGames = max(1, atoi(argv[++i]));
+        else if (arg == "--max-turns" && hasValue)      job.maxTurns = max(1, atoi(argv[++i]));
+        else if (arg == "--start-seed" && hasValue)     job.startSeed = atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)        numThreads = atoi(argv[++i]);
+        else if (arg == "--hint-budget-us" && hasValue) hintBudget = atof(argv[++i]);
+        else if (arg == "--threat-map")                 job.threatMap = true;
+        else                                            ok = false;
+        if (!ok) {
+            cout << "usage: " << argv[0] << " [--policies a,b,...] [--rows n] [--cols n] [--abysses n] [--monsters n] [--bats n]" << endl;
+            cout << "       [--collisions block|swap|merge|legacy] [--games n] [--max-turns n] [--start-seed n]" << endl;
+            cout << "       [--threads n] [--hint-budget-us n] [--threat-map]" << endl;
+            cout << "policies: random, greedy, planner, safe, search (all of them by default)" << endl;
+            return 1;
+        }
+    }
+    for (size_t p = 0; p < job.policies.size(); p++) {
+        unique_ptr<HeroPolicy> check(makeHeroPolicy(job.policies[p]));
+        if (!check) {
+            cout << "unknown policy " << job.policies[p] << endl;
+            return 1;
+        }
+    }
+    if (job.policies.size() < 2) {
+        cout << "a tournament needs at least two policies" << endl;
+        return 1;
+    }
+    if (!validGameParameters(job.rows, job.cols, job.abysses, job.monsters, job.bats)) {
+        cout << "board parameters out of range" << endl;
+        return 1;
+    }
+
+    size_t numPolicies = job.policies.size();
+    job.results.resize(numPolicies);
+    job.pairs.resize(numPolicies * numPolicies);
+
+    ThreadTeam team(numThreads);
+    cout << numPolicies << " policies, " << numGames << " games each on " << job.rows << "x" << job.cols
+         << " boards (" << job.abysses << " abysses, " << job.monsters << " monsters, " << job.bats << " bats), seeds "
+         << job.startSeed << ".." << job.startSeed + (int)numGames - 1 << ", " << team.size() << " threads" << endl;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    team.run(numGames, &playGames, &job);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << endl;
+    printf("%-8s %-22s %-14s %-22s %-22s %-22s %-22s\n", "policy", "win rate [95% CI]", "escape turns",
+           "abyss", "monster", "bat", "timeout");
+    for (size_t p = 0; p < numPolicies; p++) {
+        const PolicyResults& res = job.results[p];
+        size_t n = res.games;
+        size_t wins = res.outcomes[OutcomeEscaped];
+        char turns[32];
+        snprintf(turns, sizeof(turns), "%.1f +- %.1f", res.escapeTurns.mean(), res.escapeTurns.meanHalfWidth());
+        printf("%-8s %-22s %-14s %-22s %-22s %-22s %-22s\n", job.policies[p].c_str(),
+               percentWithInterval(wins, n).c_str(), wins ? turns : "-",
+               percentWithInterval(res.outcomes[OutcomeAbyss], n).c_str(),
+               percentWithInterval(res.outcomes[OutcomeMonster], n).c_str(),
+               percentWithInterval(res.outcomes[OutcomeBat], n).c_str(),
+               percentWithInterval(res.outcomes[OutcomePlaying], n).c_str());
+    }
+
+    cout << endl;
+    printf("%-8s %10s %12s %10s %10s %10s  %s\n", "policy", "decisions", "mean us", "p50 us", "p99 us",
+           "max us", "real-time hints");
+    for (size_t p = 0; p < numPolicies; p++) {
+        const PolicyResults& res = job.results[p];
+        double p99 = res.decisionHistogram.quantile(0.99);
+        printf("%-8s %10zu %12.2f %10.2f %10.2f %10.1f  %s\n", job.policies[p].c_str(),
+               res.decisionMicros.count(), res.decisionMicros.mean(), res.decisionHistogram.quantile(0.5), p99,
+               res.decisionHistogram.maximum(), p99 <= hintBudget ? "yes" : "no (p99 over budget)");
+    }
+
+    cout << endl;
+    printf("%-17s %-24s %-10s %-8s %-24s\n", "a vs b", "win rate a - b [95% CI]", "only a/b", "p", "turns a - b (both won)");
+    for (size_t a = 0; a < numPolicies; a++) {
+        for (size_t b = a + 1; b < numPolicies; b++) {
+            const PairResults& pair = job.pairs[a * numPolicies + b];
+            char names[64], diff[64], split[32], turns[64];
+            snprintf(names, sizeof(names), "%s vs %s", job.policies[a].c_str(), job.policies[b].c_str());
+            double mean = pair.winDifference.mean();
+            double half = pair.winDifference.meanHalfWidth();
+            snprintf(diff, sizeof(diff), "%+6.1f [%+6.1f,%+6.1f]", 100 * mean, 100 * (mean - half), 100 * (mean + half));
+            snprintf(split, sizeof(split), "%zu/%zu", pair.onlyFirst, pair.onlySecond);
+            if (pair.turnDifference.count() > 0) {
+                snprintf(turns, sizeof(turns), "%+.1f +- %.1f (%zu games)", pair.turnDifference.mean(),
+                         pair.turnDifference.meanHalfWidth(), pair.turnDifference.count());
+            }
+            else {
+                snprintf(turns, sizeof(turns), "-");
+            }
+            printf("%-17s %-24s %-10s %-8.4f %-24s\n", names, diff, split,
+                   mcNemarPValue(pair.onlyFirst, pair.onlySecond), turns);
+        }
+    }
+
+    cout << endl << numGames * numPolicies << " games in " << seconds << " s" << endl;
+
+    return 0;
+
+} // main
@@ -0,0 +1,243 @@
+/*
+    Filename: "tracing.h"
+    Author: Viraj Saudagar
+
+    This file defines TraceSpan, a scoped timer that records where a turn's
+    time goes. The board puts spans around setup, the phases of makeMoves(),
+    every baddie's move, findHero(), setBaddieMovedToFalse() and display().
+
+    Tracing is off until setTracing(true). While it is off a span costs one
+    relaxed atomic load, so the spans stay compiled in everywhere. While it
+    is on, each thread appends finished spans to a buffer of its own (no
+    lock, no allocation after the first span on that thread); a full buffer
+    counts what it drops instead of growing.
+
+    Once the traced work is done the spans can be written out as
+        writeChromeTrace()   Chrome trace JSON, for chrome://tracing or Perfetto
+        writePerfMarkers()   one line per span, "start end tid name", with
+                             CLOCK_MONOTONIC times in seconds, so the spans
+                             line up with "perf record -k CLOCK_MONOTONIC"
+                             samples in "perf script"
+    saveTrace() writes either or both to files. Write or clear the trace
+    only while no thread is adding spans.
+
+*/
+
+#ifndef _TRACING_H
+#define _TRACING_H
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <ostream>
+#include <fstream>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+struct TraceEvent {
+    const char* name;   // a string literal
+    uint64_t start;     // steady_clock nanoseconds
+    uint64_t duration;  // nanoseconds
+};
+
+// The spans of one thread. Only that thread appends; count is published with release
+// so a reader that loads it with acquire sees complete events.
+struct TraceBuffer {
+    long tid;
+    vector<TraceEvent> events;
+    atomic<size_t> count;
+    atomic<size_t> dropped;
+
+    TraceBuffer(long threadId, size_t capacity) : tid(threadId), events(capacity), count(0), dropped(0) {}
+
+    void add(const char* name, uint64_t start, uint64_t duration) {
+        size_t n = count.load(memory_order_relaxed);
+        if (n == events.size()) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        events[n].name = name;
+        events[n].start = start;
+        events[n].duration = duration;
+        count.store(n + 1, memory_order_release);
+    }
+};
+
+// every thread's buffer, kept until the process ends so a trace outlives its threads
+struct TraceRegistry {
+    mutex lock;
+    vector< unique_ptr<TraceBuffer> > buffers;
+    size_t capacity;  // events per thread buffer
+
+    TraceRegistry() : capacity(1 << 18) {}
+};
+
+inline TraceRegistry& traceRegistry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+// constant-initialized, so reading it needs no guard for first use
+inline atomic<bool>& traceFlag() {
+    static atomic<bool> enabled(false);
+    return enabled;
+}
+
+inline bool tracingEnabled() {
+    return traceFlag().load(memory_order_relaxed);
+}
+
+inline void setTracing(bool on) {
+    traceFlag().store(on, memory_order_relaxed);
+}
+
+// events each thread can hold; applies to threads that record their first span afterwards
+inline void setTraceCapacity(size_t events) {
+    TraceRegistry& registry = traceRegistry();
+    lock_guard<mutex> guard(registry.lock);
+    registry.capacity = events;
+}
+
+inline uint64_t traceNow() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline TraceBuffer& threadTraceBuffer() {
+    static thread_local TraceBuffer* buffer = NULL;
+    if (buffer == NULL) {
+        TraceRegistry& registry = traceRegistry();
+        lock_guard<mutex> guard(registry.lock);
+        registry.buffers.push_back(unique_ptr<TraceBuffer>(new TraceBuffer(syscall(SYS_gettid), registry.capacity)));
+        buffer = registry.buffers.back().get();
+    }
+    return *buffer;
+}
+
+// throws away every recorded span (the buffers stay allocated)
+inline void clearTrace() {
+    TraceRegistry& registry = traceRegistry();
+    lock_guard<mutex> guard(registry.lock);
+    for (size_t i = 0; i < registry.buffers.size(); i++) {
+        registry.buffers[i]->count.store(0, memory_order_relaxed);
+        registry.buffers[i]->dropped.store(0, memory_order_relaxed);
+    }
+}
+
+// spans that did not fit into their thread's buffer
+inline size_t traceDropped() {
+    TraceRegistry& registry = traceRegistry();
+    lock_guard<mutex> guard(registry.lock);
+    size_t dropped = 0;
+    for (size_t i = 0; i < registry.buffers.size(); i++) {
+        dropped += registry.buffers[i]->dropped.load(memory_order_relaxed);
+    }
+    return dropped;
+}
+
+//---------------------------------------------------------------------------------
+// class TraceSpan
+//
+// Times the enclosing scope, or up to end() if that comes first:
+//      TraceSpan span("moveBaddies");
+// name must outlive the trace (use a string literal).
+//---------------------------------------------------------------------------------
+class TraceSpan {
+    private:
+        const char* name;  // NULL when tracing was off at the start, or after end()
+        uint64_t start;
+
+    public:
+        explicit TraceSpan(const char* spanName) : name(NULL), start(0) {
+            if (tracingEnabled()) {
+                name = spanName;
+                start = traceNow();
+            }
+        }
+
+        ~TraceSpan() {
+            end();
+        }
+
+        void end() {
+            if (name != NULL) {
+                threadTraceBuffer().add(name, start, traceNow() - start);
+                name = NULL;
+            }
+        }
+
+    private:
+        TraceSpan(const TraceSpan&);
+        TraceSpan& operator=(const TraceSpan&);
+};
+
+// writes every recorded span as Chrome trace JSON ("X" events, times in microseconds)
+inline void writeChromeTrace(ostream& out) {
+    TraceRegistry& registry = traceRegistry();
+    lock_guard<mutex> guard(registry.lock);
+    long pid = getpid();
+    char line[256];
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    for (size_t b = 0; b < registry.buffers.size(); b++) {
+        const TraceBuffer& buffer = *registry.buffers[b];
+        size_t count = buffer.count.load(memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent& e = buffer.events[i];
+            snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"cat\":\"game\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld}",
+                     first ? "" : ",\n", e.name, e.start / 1000.0, e.duration / 1000.0, pid, buffer.tid);
+            out << line;
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+// writes every recorded span as "start end tid name", CLOCK_MONOTONIC seconds
+inline void writePerfMarkers(ostream& out) {
+    TraceRegistry& registry = traceRegistry();
+    lock_guard<mutex> guard(registry.lock);
+    char line[256];
+    for (size_t b = 0; b < registry.buffers.size(); b++) {
+        const TraceBuffer& buffer = *registry.buffers[b];
+        size_t count = buffer.count.load(memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent& e = buffer.events[i];
+            uint64_t end = e.start + e.duration;
+            snprintf(line, sizeof(line), "%llu.%09llu %llu.%09llu %ld %s\n",
+                     (unsigned long long)(e.start / 1000000000), (unsigned long long)(e.start % 1000000000),
+                     (unsigned long long)(end / 1000000000), (unsigned long long)(end % 1000000000),
+                     buffer.tid, e.name);
+            out << line;
+        }
+    }
+}
+
+// writes the Chrome trace to chromePath and the perf markers to markersPath, skipping
+// an empty path; false if a file could not be written
+inline bool saveTrace(const string& chromePath, const string& markersPath) {
+    if (!chromePath.empty()) {
+        ofstream out(chromePath.c_str());
+        writeChromeTrace(out);
+        if (!out) {
+            return false;
+        }
+    }
+    if (!markersPath.empty()) {
+        ofstream out(markersPath.c_str());
+        writePerfMarkers(out);
+        if (!out) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif //_TRACING_H
@@ -0,0 +1,201 @@
+/*
+    Filename: "vecenv.h"
+    Author: Viraj Saudagar
+
+    This file defines VecEnv, a batch of N boards stepped together for
+    training hero policies.
+
+        reset(seeds)     sets up every board from its own seed
+        step(actions)    plays one move on every board (actions[i] is an index
+                         into kVecEnvMoves), then fills in
+
+            observations()   N x rows x cols TileType codes, board after board;
+                             with fogRadius set, cells the hero cannot see
+                             are kHiddenTile (see fieldofview.h)
+            rewards()        N floats: stepReward every move, plus escapeReward
+                             or deathReward on the move that ended the game
+            dones()          N flags: 1 if the game ended (or hit maxSteps)
+
+    A board whose game ended is set up again right away with its next seed
+    (seed + N, seed + 2N, ...), so the observation next to a done flag is
+    already the first one of the new game.
+
+    All buffers are sized in the constructor and boards recycle their
+    cells, so step() does not allocate. The boards are split across a
+    ThreadTeam, one slice per core.
+
+*/
+
+#ifndef _VECENV_H
+#define _VECENV_H
+
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+
+#include "gameboard.h"
+#include "workerpool.h"
+
+using namespace std;
+
+// action index -> hero move; 0 is "stay"
+static const char kVecEnvMoves[] = "sqweadzxc";
+static const size_t kVecEnvNumActions = 9;
+
+struct VecEnvConfig {
+    size_t rows, cols;
+    int abysses, monsters, bats;
+    CollisionPolicy collisions;
+    float stepReward;      // every move
+    float escapeReward;    // the hero reached the ladder
+    float deathReward;     // the hero was captured or fell
+    size_t maxSteps;       // a game is cut off after this many moves (0 = never)
+    size_t fogRadius;      // the hero only observes cells this close and not behind a wall (0 = all)
+    size_t threads;        // 0 = one per core
+
+    VecEnvConfig()
+        : rows(15), cols(40), abysses(20), monsters(6), bats(3), collisions(CollisionBlock),
+          stepReward(-0.01f), escapeReward(1.0f), deathReward(-1.0f), maxSteps(500), fogRadius(0), threads(0) {}
+};
+
+class VecEnv {
+    private:
+        VecEnvConfig config;
+        size_t numEnvs;
+        size_t cells;  // rows * cols
+        vector<GameBoardBase*> boards;
+        vector<int> seeds;            // seed of the game each board is playing
+        vector<size_t> steps;         // moves played in that game
+        vector<unsigned char> obs;
+        vector<float> rewardBuf;
+        vector<unsigned char> doneBuf;
+        const unsigned char* pendingActions;
+        ThreadTeam team;
+
+        void setupEnv(size_t i) {
+            boards[i]->setupBoard(seeds[i]);
+            steps[i] = 0;
+            boards[i]->getObservation(&obs[i * cells]);
+        }
+
+        void stepEnv(size_t i) {
+            GameBoardBase& board = *boards[i];
+            unsigned char action = pendingActions[i];
+            char move = kVecEnvMoves[action < kVecEnvNumActions ? action : 0];
+
+            bool alive = board.makeMoves(move);
+            steps[i]++;
+            float reward = config.stepReward;
+            bool done = !alive || (config.maxSteps > 0 && steps[i] >= config.maxSteps);
+            if (!alive) {
+                reward += board.getWonGame() ? config.escapeReward : config.deathReward;
+            }
+            rewardBuf[i] = reward;
+            doneBuf[i] = done ? 1 : 0;
+
+            if (done) {
+                seeds[i] += numEnvs;
+                setupEnv(i);
+            }
+            else {
+                board.getObservation(&obs[i * cells]);
+            }
+        }
+
+        static void resetSlice(void* context, size_t begin, size_t end) {
+            VecEnv* env = (VecEnv*)context;
+            for (size_t i = begin; i < end; i++) {
+                env->setupEnv(i);
+            }
+        }
+
+        static void stepSlice(void* context, size_t begin, size_t end) {
+            VecEnv* env = (VecEnv*)context;
+            for (size_t i = begin; i < end; i++) {
+                env->stepEnv(i);
+            }
+        }
+
+    public:
+        /* param constructor -> n boards with the given parameters, not set up until reset() */
+        VecEnv(size_t n, const VecEnvConfig& c = VecEnvConfig())
+            : config(c), numEnvs(n), cells(c.rows * c.cols), boards(n, (GameBoardBase*)NULL),
+              seeds(n, 0), steps(n, 0), obs(n * c.rows * c.cols, 0), rewardBuf(n, 0), doneBuf(n, 0),
+              pendingActions(NULL), team(c.threads) {
+            if (n == 0) {
+                throw invalid_argument("VecEnv constructor -> needs at least one board");
+            }
+            for (size_t i = 0; i < n; i++) {
+                boards[i] = makeGameBoard(c.rows, c.cols);
+                boards[i]->setVerbose(false);
+                boards[i]->setCollisionPolicy(c.collisions);
+                boards[i]->setNumAbysses(c.abysses);
+                boards[i]->setNumMonsters(c.monsters);
+                boards[i]->setNumBats(c.bats);
+                boards[i]->setFogOfWar(c.fogRadius);
+            }
+        }
+
+        /* destructor */
+        virtual ~VecEnv() {
+            for (size_t i = 0; i < boards.size(); i++) {
+                delete boards[i];
+            }
+        }
+
+        // sets up board i from seeds[i] (N seeds) and clears rewards and dones
+        void reset(const int* newSeeds) {
+            for (size_t i = 0; i < numEnvs; i++) {
+                seeds[i] = newSeeds[i];
+            }
+            fill(rewardBuf.begin(), rewardBuf.end(), 0.0f);
+            fill(doneBuf.begin(), doneBuf.end(), 0);
+            team.run(numEnvs, &VecEnv::resetSlice, this);
+        }
+
+        // plays actions[i] (N action indexes) on board i, then refreshes every buffer
+        void step(const unsigned char* actions) {
+            pendingActions = actions;
+            team.run(numEnvs, &VecEnv::stepSlice, this);
+            pendingActions = NULL;
+        }
+
+        const unsigned char* observations() const {
+            return &obs[0];
+        }
+
+        const float* rewards() const {
+            return &rewardBuf[0];
+        }
+
+        const unsigned char* dones() const {
+            return &doneBuf[0];
+        }
+
+        size_t size() const {
+            return numEnvs;
+        }
+
+        size_t numRows() const {
+            return config.rows;
+        }
+
+        size_t numCols() const {
+            return config.cols;
+        }
+
+        size_t numThreads() const {
+            return team.size();
+        }
+
+        // board i itself, e.g. to display it
+        GameBoardBase& board(size_t i) {
+            return *boards[i];
+        }
+
+    private:
+        VecEnv(const VecEnv&);
+        VecEnv& operator=(const VecEnv&);
+};
+
+#endif //_VECENV_H
@@ -0,0 +1,221 @@
+/*
+    Filename: "workerpool.h"
+    Author: Viraj Saudagar
+
+    This file defines the WorkerPool class, a fixed set of threads that
+    pull tasks off of a shared queue. The game server hands turn processing
+    to the pool so the event loop never runs game logic itself.
+
+    ThreadTeam is the fork-join counterpart for code that runs the same
+    work over many boards every step: run() splits a range across a fixed
+    set of threads (the caller included) and returns when every slice is
+    done, without allocating or queueing anything.
+
+*/
+
+#ifndef _WORKERPOOL_H
+#define _WORKERPOOL_H
+
+#include <cstdlib>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+class WorkerPool {
+    private:
+        vector<thread> workers;
+        deque< function<void()> > tasks;
+        mutex lock;
+        condition_variable wake;
+        bool stopping;
+
+        // Body of every worker thread. Waits for a task, runs it, and repeats
+        // until the pool is stopped and the queue has been drained.
+        void workerLoop() {
+            while (true) {
+                function<void()> task;
+                {
+                    unique_lock<mutex> guard(lock);
+                    while (!stopping && tasks.empty()) {
+                        wake.wait(guard);
+                    }
+                    if (tasks.empty()) {
+                        return;
+                    }
+                    task = move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+    public:
+        /* param constructor -> 0 threads means one per hardware core */
+        explicit WorkerPool(size_t numThreads = 0) {
+            stopping = false;
+            if (numThreads == 0) {
+                numThreads = thread::hardware_concurrency();
+            }
+            if (numThreads == 0) {
+                numThreads = 1;
+            }
+            for (size_t i = 0; i < numThreads; i++) {
+                workers.push_back(thread(&WorkerPool::workerLoop, this));
+            }
+        }
+
+        /* destructor -> finishes queued tasks then joins every thread */
+        virtual ~WorkerPool() {
+            join();
+        }
+
+        // Finishes the queued tasks (and any they submit) and joins every thread, so
+        // an owner can stop the pool before tearing down what the tasks use. Nothing
+        // runs a task afterwards; calling it again does nothing.
+        void join() {
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (size_t i = 0; i < workers.size(); i++) {
+                if (workers[i].joinable()) {
+                    workers[i].join();
+                }
+            }
+        }
+
+        // Queues a task to be run on one of the worker threads.
+        void submit(function<void()> task) {
+            {
+                lock_guard<mutex> guard(lock);
+                tasks.push_back(move(task));
+            }
+            wake.notify_one();
+        }
+
+        size_t size() const {
+            return workers.size();
+        }
+
+    private:
+        WorkerPool(const WorkerPool&);
+        WorkerPool& operator=(const WorkerPool&);
+};
+
+class ThreadTeam {
+    public:
+        // work on items [begin, end) of the range given to run()
+        typedef void (*Job)(void* context, size_t begin, size_t end);
+
+    private:
+        vector<thread> helpers;
+        mutex lock;
+        condition_variable wake;      // a new job was posted, or the team is stopping
+        condition_variable finished;  // the last helper finished its slice
+        size_t generation;            // bumped once per job
+        size_t busy;                  // helpers still working on the current job
+        bool stopping;
+
+        Job job;
+        void* jobContext;
+        size_t jobSize;
+
+        // slice i of n equal parts of [0, jobSize)
+        void runSlice(size_t i) {
+            size_t parts = helpers.size() + 1;
+            size_t begin = jobSize * i / parts;
+            size_t end = jobSize * (i + 1) / parts;
+            if (begin < end) {
+                job(jobContext, begin, end);
+            }
+        }
+
+        void helperLoop(size_t slice) {
+            size_t seen = 0;
+            while (true) {
+                {
+                    unique_lock<mutex> guard(lock);
+                    while (!stopping && generation == seen) {
+                        wake.wait(guard);
+                    }
+                    if (stopping) {
+                        return;
+                    }
+                    seen = generation;
+                }
+                runSlice(slice);
+                {
+                    lock_guard<mutex> guard(lock);
+                    if (--busy == 0) {
+                        finished.notify_one();
+                    }
+                }
+            }
+        }
+
+    public:
+        /* param constructor -> numThreads counts the calling thread; 0 means one per hardware core */
+        explicit ThreadTeam(size_t numThreads = 0)
+            : generation(0), busy(0), stopping(false), job(NULL), jobContext(NULL), jobSize(0) {
+            if (numThreads == 0) {
+                numThreads = max(1u, thread::hardware_concurrency());
+            }
+            for (size_t i = 1; i < numThreads; i++) {
+                helpers.push_back(thread(&ThreadTeam::helperLoop, this, i));
+            }
+        }
+
+        /* destructor -> joins every helper */
+        virtual ~ThreadTeam() {
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (size_t i = 0; i < helpers.size(); i++) {
+                helpers[i].join();
+            }
+        }
+
+        // Calls fn(context, begin, end) over slices covering [0, count) on every thread
+        // of the team and returns once all of them are done. Not reentrant.
+        void run(size_t count, Job fn, void* context) {
+            if (helpers.empty()) {
+                if (count > 0) {
+                    fn(context, 0, count);
+                }
+                return;
+            }
+            {
+                lock_guard<mutex> guard(lock);
+                job = fn;
+                jobContext = context;
+                jobSize = count;
+                busy = helpers.size();
+                generation++;
+            }
+            wake.notify_all();
+            runSlice(0);
+            unique_lock<mutex> guard(lock);
+            while (busy > 0) {
+                finished.wait(guard);
+            }
+        }
+
+        size_t size() const {
+            return helpers.size() + 1;
+        }
+
+    private:
+        ThreadTeam(const ThreadTeam&);
+        ThreadTeam& operator=(const ThreadTeam&);
+};
+
+#endif //_WORKERPOOL_H